@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+# Compare the abstract syntax trees of two builds (see bench/astdump.cpp).
+#
+# Usage: bench/astdiff.sh <old astdump> <new astdump> <file or directory> ...
+#
+# The old astdump is usually built from the commit before a change of
+# TokenList::createAst, e.g. in a second worktree with "make astdump". The
+# C and C++ files of the directories are dumped with both builds, one file
+# at a time. The script prints the differences of the dumps and fails if
+# there are any.
+
+if [ $# -lt 3 ]; then
+    echo "Usage: $0 <old astdump> <new astdump> <file or directory> ..." >&2
+    exit 2
+fi
+
+OLD=$1
+NEW=$2
+shift 2
+
+TMP=${TMPDIR:-/tmp}/astdiff.$$
+mkdir -p "$TMP" || exit 2
+trap 'rm -rf "$TMP"' EXIT
+
+find "$@" -type f \( -name '*.c' -o -name '*.cpp' -o -name '*.cc' -o -name '*.cxx' -o -name '*.h' -o -name '*.hpp' \) | sort > "$TMP/files"
+
+: > "$TMP/old"
+: > "$TMP/new"
+while read -r file; do
+    "$OLD" "$file" >> "$TMP/old" 2>/dev/null || echo "=== $file: old astdump failed" >> "$TMP/old"
+    "$NEW" "$file" >> "$TMP/new" 2>/dev/null || echo "=== $file: new astdump failed" >> "$TMP/new"
+done < "$TMP/files"
+
+if diff "$TMP/old" "$TMP/new"; then
+    echo "astdiff: $(wc -l < "$TMP/files") files, same trees"
+    exit 0
+fi
+echo "astdiff: the trees differ" >&2
+exit 1
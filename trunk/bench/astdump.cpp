@@ -0,0 +1,118 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Dump of the abstract syntax trees built by the tokenizer (make astdump).
+ *
+ * Usage: astdump file.cpp ...
+ *
+ * Every file is tokenized on its own. For every token in a tree one line is
+ * written: the index of the token, its text and the indexes of astOperand1,
+ * astOperand2 and astParent, -1 if there is none. Two builds give the same
+ * dump exactly when they build the same trees, see bench/astdiff.sh.
+ */
+
+#include "errorlogger.h"
+#include "filedepend.h"
+#include "globalmacros.h"
+#include "preprocessor.h"
+#include "settings.h"
+#include "token.h"
+#include "tokenize.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+class SilentErrorLogger : public ErrorLogger {
+public:
+    virtual void reportOut(const std::string &) {
+    }
+    virtual void reportErr(const ErrorLogger::ErrorMessage &) {
+    }
+};
+
+static int index(const std::map<const Token *, int> &indexes, const Token *tok)
+{
+    const std::map<const Token *, int>::const_iterator it = tok ? indexes.find(tok) : indexes.end();
+    return it == indexes.end() ? -1 : it->second;
+}
+
+static bool dumpFile(const std::string &filename, std::ostream &out)
+{
+    std::ifstream fin(filename.c_str());
+    if (!fin.is_open())
+        return false;
+
+    SilentErrorLogger errorLogger;
+    Preprocessor preprocessor(*Settings::Instance(), &errorLogger);
+    const std::string processedCode = preprocessor.read(fin, filename);
+    const std::string code = preprocessor.getcode(processedCode, emptyString, filename);
+
+    out << "=== " << filename << "\n";
+    Tokenizer tokenizer(Settings::Instance(), &errorLogger);
+    std::istringstream istr(code);
+    try {
+        if (!tokenizer.tokenize(istr, filename.c_str())) {
+            out << "not tokenized\n";
+            return true;
+        }
+    } catch (const InternalError &) {
+        out << "internal error\n";
+        return true;
+    }
+
+    std::map<const Token *, int> indexes;
+    int n = 0;
+    for (const Token *tok = tokenizer.tokens(); tok; tok = tok->next())
+        indexes[tok] = n++;
+
+    n = 0;
+    for (const Token *tok = tokenizer.tokens(); tok; tok = tok->next(), ++n) {
+        if (!tok->astOperand1() && !tok->astOperand2() && !tok->astParent())
+            continue;
+        out << n << " " << tok->str()
+            << " " << index(indexes, tok->astOperand1())
+            << " " << index(indexes, tok->astOperand2())
+            << " " << index(indexes, tok->astParent()) << "\n";
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help") {
+        std::cout << "Usage: astdump file.cpp ...\n";
+        return argc < 2 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    // the inputs are not part of a project, the tokenizer finds no files in this table
+    CFileDependTable fileTable;
+    CGlobalMacros::SetFileTable(&fileTable);
+
+    for (int i = 1; i < argc; ++i) {
+        if (!dumpFile(argv[i], std::cout)) {
+            std::cerr << "astdump: can not read " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+#!/bin/sh
+#
+# Write a large C file of similar functions, for bench/windowdiff.sh.
+#
+# Usage: bench/cgen.sh <functions>
+#
+# The functions return int, struct, union and enum types, so that
+# CodeWindows has to tell function definitions from type definitions such
+# as "struct __attribute__((packed)) Packed { ... }". Every function has a
+# buffer overrun and a memory leak, so the checks have something to report.
+
+if [ $# -ne 1 ]; then
+    echo "Usage: $0 <functions>" >&2
+    exit 2
+fi
+
+awk -v functions="$1" '
+BEGIN {
+    print "#include <stdlib.h>"
+    print "#include <string.h>"
+    print "struct Node { int v; struct Node *next; char name[16]; };"
+    print "struct __attribute__((packed)) Packed { char c; int v; };"
+    print "union Value { int i; float f; };"
+    print "enum Kind { KIND_INT, KIND_FLOAT };"
+    print "struct Node *lookup(int k);"
+    for (i = 0; i < functions; i++) {
+        k = i % 4
+        if (k == 0) {
+            type = "int"
+            result = "sum + buf[16]"
+        } else if (k == 1) {
+            type = "struct Node *"
+            result = "sum > buf[16] ? p : 0"
+        } else if (k == 2) {
+            type = "union Value"
+            result = "(v.i += buf[16], v)"
+        } else {
+            type = "enum Kind"
+            result = "sum + buf[16] ? KIND_INT : KIND_FLOAT"
+        }
+        print type (k == 1 ? "" : " ") "gen_" i "(int k, const char *s)"
+        print "{"
+        print "    struct Node *p = lookup(k + " i ");"
+        print "    union Value v;"
+        print "    char buf[16];"
+        print "    int sum = 0;"
+        print "    int j;"
+        print "    for (j = 0; j < 16; j++)"
+        print "        buf[j] = s[j];"
+        print "    if (k > " (i % 7) ")"
+        print "        sum += p->v;"
+        print "    v.i = sum;"
+        print "    char *q = (char *)malloc(32);"
+        print "    if (k == " (i % 5) ")"
+        print "        return " result ";"
+        print "    strcpy(q, buf);"
+        print "    free(q);"
+        print "    return " result ";"
+        print "}"
+    }
+}'
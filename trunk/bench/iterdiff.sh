@@ -0,0 +1,67 @@
+#!/bin/sh
+#
+# Compare the findings of two tscancode builds with invalidIterator enabled
+# (make checkiterators).
+#
+# Usage: bench/iterdiff.sh <old tscancode> <new tscancode> [file or directory ...]
+#
+# The old tscancode is usually built from the commit before a change of
+# CheckStl, e.g. in a second worktree. Both builds check the given files and
+# the STL inputs of bench/stlgen.sh, with a copy of cfg/ in which the
+# invalidIterator check is turned on. The script prints the differences of
+# the sorted findings and fails if there are any.
+#
+# Run it from the directory of the Makefile, cfg/ is copied from there.
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 <old tscancode> <new tscancode> [file or directory ...]" >&2
+    exit 2
+fi
+
+absolute() {
+    case $1 in
+    /*) echo "$1" ;;
+    *) echo "$PWD/$1" ;;
+    esac
+}
+
+OLD=$(absolute "$1")
+NEW=$(absolute "$2")
+shift 2
+
+# number of generated files and functions per file
+STL_FILES=${STL_FILES:-8}
+STL_FUNCTIONS=${STL_FUNCTIONS:-500}
+
+TMP=${TMPDIR:-/tmp}/iterdiff.$$
+mkdir -p "$TMP/stl" || exit 2
+trap 'rm -rf "$TMP"' EXIT
+
+cp -R cfg "$TMP/cfg" || exit 2
+sed 's/<subid name="invalidIterator" value="0"/<subid name="invalidIterator" value="1"/' cfg/cfg.xml > "$TMP/cfg/cfg.xml" || exit 2
+if ! grep -q '<subid name="invalidIterator" value="1"' "$TMP/cfg/cfg.xml"; then
+    echo "iterdiff: invalidIterator not found in cfg/cfg.xml" >&2
+    exit 2
+fi
+
+i=1
+while [ $i -le "$STL_FILES" ]; do
+    sh bench/stlgen.sh $i "$STL_FUNCTIONS" > "$TMP/stl/g$i.cpp" || exit 2
+    i=$((i + 1))
+done
+
+INPUTS="$TMP/stl"
+for input in "$@"; do
+    INPUTS="$INPUTS $(absolute "$input")"
+done
+
+# the findings are written to stderr, in the order the files were checked
+(cd "$TMP" && "$OLD" -q $INPUTS 2>&1 >/dev/null | sort > old.txt)
+(cd "$TMP" && "$NEW" -q $INPUTS 2>&1 >/dev/null | sort > new.txt)
+
+if diff "$TMP/old.txt" "$TMP/new.txt"; then
+    echo "iterdiff: $(wc -l < "$TMP/new.txt") findings, same in both builds"
+    exit 0
+fi
+echo "iterdiff: the findings differ" >&2
+exit 1
@@ -0,0 +1,607 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Microbenchmarks of the hot primitives (make microbench).
+ *
+ * Usage: microbench [--filter=<text>] [file.cpp ...]
+ *
+ * Every benchmark runs on fixed synthetic inputs and, if source files are
+ * given (e.g. the files in ../samples/cpp), on their concatenation. A
+ * benchmark is repeated in rounds of at least MIN_ROUND_CLOCKS until
+ * STABLE_ROUNDS rounds in a row agree within STABLE_SPREAD. The fastest round
+ * is reported as ns/op together with the heap allocations per op, as JSON on
+ * stdout.
+ */
+
+#include "astutils.h"
+#include "errorlogger.h"
+#include "filedepend.h"
+#include "globalmacros.h"
+#include "mathlib.h"
+#include "preprocessor.h"
+#include "settings.h"
+#include "suppressions.h"
+#include "token.h"
+#include "tokenize.h"
+#include "tokenlist.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <new>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// a round is timed for at least 50ms, so that std::clock() is precise enough
+static const std::clock_t MIN_ROUND_CLOCKS = CLOCKS_PER_SEC / 20;
+static const unsigned int STABLE_ROUNDS = 3;
+static const double STABLE_SPREAD = 0.03;
+static const unsigned int MAX_ROUNDS = 20;
+
+//---------------------------------------------------------------------------
+// allocation counting, the benchmark is single threaded
+
+static unsigned long long s_allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++s_allocations;
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) throw()
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    std::free(p);
+}
+
+//---------------------------------------------------------------------------
+
+class SilentErrorLogger : public ErrorLogger {
+public:
+    virtual void reportOut(const std::string &) {
+    }
+    virtual void reportErr(const ErrorLogger::ErrorMessage &) {
+    }
+};
+
+/** the input of one benchmark run, built once and shared by all benchmarks */
+struct BenchInput {
+    explicit BenchInput(const std::string &name_)
+        : name(name_), tokenizer(Settings::Instance(), &errorLogger), uncompacted(Settings::Instance(), &errorLogger) {
+    }
+
+    std::string name;
+    std::string filename;
+    std::string rawCode;        // before preprocessing
+    std::string processedCode;  // after Preprocessor::read()
+    std::list<std::string> configurations;
+    SilentErrorLogger errorLogger;
+    Tokenizer tokenizer;
+    Tokenizer uncompacted;      // the same code tokenized with --no-compact-tokens
+    std::vector<std::string> numbers;
+    std::vector<const Token *> binaryOperators;
+};
+
+// results are summed here so that the compiler can not drop the work
+static volatile unsigned long long s_sink = 0;
+
+/** run the primitive once per op, return the number of ops done */
+typedef unsigned long long BenchProc(BenchInput &input);
+
+//---------------------------------------------------------------------------
+
+static const char * const s_matchPatterns[] = {
+    "%name% (",
+    "if|while|for (",
+    "[;{}] %var% = %num% ;",
+    "%var% . %name% (",
+    "return %any% ;",
+    "delete [ ] %var% ;",
+    "%type% * %var% [,;=]",
+    "%op%|%comp% %num%"
+};
+
+static const char * const s_simpleMatchPatterns[] = {
+    ") {",
+    "else {",
+    "return ;",
+    "= 0 ;",
+    "for (",
+    "sizeof ("
+};
+
+template <std::size_t N>
+static unsigned long long matchAll(const Token *front, const char * const (&patterns)[N], bool simple)
+{
+    unsigned long long ops = 0;
+    unsigned long long matches = 0;
+    for (const Token *tok = front; tok; tok = tok->next()) {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (simple ? Token::simpleMatch(tok, patterns[i]) : Token::Match(tok, patterns[i]))
+                ++matches;
+        }
+        ops += N;
+    }
+    s_sink += matches;
+    return ops;
+}
+
+static unsigned long long benchMatch(BenchInput &input)
+{
+    return matchAll(input.tokenizer.tokens(), s_matchPatterns, false);
+}
+
+static unsigned long long benchMatchUncompacted(BenchInput &input)
+{
+    return matchAll(input.uncompacted.tokens(), s_matchPatterns, false);
+}
+
+static unsigned long long benchSimpleMatch(BenchInput &input)
+{
+    return matchAll(input.tokenizer.tokens(), s_simpleMatchPatterns, true);
+}
+
+static unsigned long long findmatchAll(const Token *front)
+{
+    // walk the whole list from match to match
+    unsigned long long ops = 0;
+    for (std::size_t i = 0; i < sizeof(s_matchPatterns) / sizeof(s_matchPatterns[0]); ++i) {
+        const Token *tok = front;
+        while ((tok = Token::findmatch(tok, s_matchPatterns[i])) != nullptr) {
+            tok = tok->next();
+            ++ops;
+        }
+        ++ops;
+    }
+    return ops;
+}
+
+static unsigned long long benchFindmatch(BenchInput &input)
+{
+    return findmatchAll(input.tokenizer.tokens());
+}
+
+static unsigned long long benchFindmatchUncompacted(BenchInput &input)
+{
+    return findmatchAll(input.uncompacted.tokens());
+}
+
+static unsigned long long benchToLongNumber(BenchInput &input)
+{
+    MathLib::bigint sum = 0;
+    for (std::size_t i = 0; i < input.numbers.size(); ++i) {
+        if (MathLib::isInt(input.numbers[i]))
+            sum += MathLib::toLongNumber(input.numbers[i]);
+    }
+    s_sink += (unsigned long long)sum;
+    return input.numbers.size();
+}
+
+static unsigned long long benchIsInt(BenchInput &input)
+{
+    unsigned long long ints = 0;
+    for (std::size_t i = 0; i < input.numbers.size(); ++i) {
+        if (MathLib::isInt(input.numbers[i]))
+            ++ints;
+    }
+    s_sink += ints;
+    return input.numbers.size();
+}
+
+static unsigned long long benchCalculate(BenchInput &input)
+{
+    static const char actions[] = "+-*&|^";
+    unsigned long long ops = 0;
+    std::size_t length = 0;
+    for (std::size_t i = 1; i < input.numbers.size(); ++i) {
+        const std::string &first = input.numbers[i - 1];
+        const std::string &second = input.numbers[i];
+        if (!MathLib::isInt(first) || !MathLib::isInt(second))
+            continue;
+        length += MathLib::calculate(first, second, actions[i % (sizeof(actions) - 1)]).size();
+        ++ops;
+    }
+    s_sink += length;
+    return ops;
+}
+
+static unsigned long long benchRemoveComments(BenchInput &input)
+{
+    Preprocessor preprocessor(*Settings::Instance(), &input.errorLogger);
+    s_sink += preprocessor.removeComments(input.rawCode, input.filename).size();
+    return 1;
+}
+
+static unsigned long long benchRead(BenchInput &input)
+{
+    Preprocessor preprocessor(*Settings::Instance(), &input.errorLogger);
+    std::istringstream istr(input.rawCode);
+    s_sink += preprocessor.read(istr, input.filename).size();
+    return 1;
+}
+
+static unsigned long long benchGetcode(BenchInput &input)
+{
+    Preprocessor preprocessor(*Settings::Instance(), &input.errorLogger);
+    s_sink += preprocessor.getcode(input.processedCode, emptyString, input.filename).size();
+    return 1;
+}
+
+static unsigned long long benchGetcodeConfigurations(BenchInput &input)
+{
+    Preprocessor preprocessor(*Settings::Instance(), &input.errorLogger);
+    for (std::list<std::string>::const_iterator cfg = input.configurations.begin(); cfg != input.configurations.end(); ++cfg)
+        s_sink += preprocessor.getcode(input.processedCode, *cfg, input.filename).size();
+    return input.configurations.size();
+}
+
+static unsigned long long benchGetcodeSharedStream(BenchInput &input)
+{
+    Preprocessor preprocessor(*Settings::Instance(), &input.errorLogger);
+    CfgLineStream stream;
+    Preprocessor::splitLines(input.processedCode, stream);
+    for (std::list<std::string>::const_iterator cfg = input.configurations.begin(); cfg != input.configurations.end(); ++cfg)
+        s_sink += preprocessor.getcode(stream, *cfg, input.filename, true).size();
+    return input.configurations.size();
+}
+
+static unsigned long long benchCreateTokens(BenchInput &input)
+{
+    TokenList list(Settings::Instance());
+    std::istringstream istr(input.processedCode);
+    s_sink += list.createTokens(istr, input.filename);
+    return 1;
+}
+
+static unsigned long long benchSetVarId(BenchInput &input)
+{
+    input.tokenizer.setVarId();
+    return 1;
+}
+
+static unsigned long long benchIsSameExpression(BenchInput &input)
+{
+    static const std::set<std::string> constFunctions;
+    unsigned long long same = 0;
+    for (std::size_t i = 0; i < input.binaryOperators.size(); ++i) {
+        const Token *tok = input.binaryOperators[i];
+        if (isSameExpression(true, tok->astOperand1(), tok->astOperand2(), constFunctions))
+            ++same;
+        // compare with the previous expression too, most of these differ late
+        if (i && isSameExpression(true, tok, input.binaryOperators[i - 1], constFunctions))
+            ++same;
+    }
+    s_sink += same;
+    return input.binaryOperators.size() * 2;
+}
+
+static unsigned long long benchIsSuppressed(BenchInput &input)
+{
+    static Suppressions *suppressions = nullptr;
+    if (!suppressions) {
+        suppressions = new Suppressions;
+        for (unsigned int i = 0; i < 20; ++i) {
+            std::ostringstream id;
+            id << "error" << i;
+            suppressions->addSuppression(id.str());
+            suppressions->addSuppression(id.str(), "src/*/file" + id.str() + ".cpp");
+            suppressions->addSuppression(id.str(), input.filename, i * 10 + 1);
+        }
+    }
+
+    static const char * const ids[] = { "error3", "error19", "nullpointer", "uninitvar" };
+    static const char * const files[] = { "src/a/fileerror3.cpp", "lib/token.cpp", "" };
+    unsigned long long ops = 0;
+    unsigned long long suppressed = 0;
+    for (unsigned int line = 1; line <= 100; ++line) {
+        for (std::size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i) {
+            for (std::size_t j = 0; j < sizeof(files) / sizeof(files[0]); ++j) {
+                const std::string file = *files[j] ? std::string(files[j]) : input.filename;
+                if (suppressions->isSuppressed(ids[i], file, line))
+                    ++suppressed;
+                ++ops;
+            }
+        }
+    }
+    s_sink += suppressed;
+    return ops;
+}
+
+struct Benchmark {
+    const char *name;
+    BenchProc *run;
+};
+
+static const Benchmark s_benchmarks[] = {
+    { "Token::Match", benchMatch },
+    { "Token::Match, uncompacted tokens", benchMatchUncompacted },
+    { "Token::simpleMatch", benchSimpleMatch },
+    { "Token::findmatch", benchFindmatch },
+    { "Token::findmatch, uncompacted tokens", benchFindmatchUncompacted },
+    { "MathLib::toLongNumber", benchToLongNumber },
+    { "MathLib::isInt", benchIsInt },
+    { "MathLib::calculate", benchCalculate },
+    { "Preprocessor::removeComments", benchRemoveComments },
+    { "Preprocessor::read", benchRead },
+    { "Preprocessor::getcode", benchGetcode },
+    { "Preprocessor::getcode per configuration", benchGetcodeConfigurations },
+    { "Preprocessor::getcode per configuration, shared stream", benchGetcodeSharedStream },
+    { "TokenList::createTokens", benchCreateTokens },
+    { "Tokenizer::setVarId", benchSetVarId },
+    { "isSameExpression", benchIsSameExpression },
+    { "Suppressions::isSuppressed", benchIsSuppressed }
+};
+
+//---------------------------------------------------------------------------
+
+// a translation unit exercising the patterns above, the same on every run
+static std::string syntheticCode()
+{
+    std::ostringstream code;
+    code << "/* synthetic input */\n#include <string.h>\n#define SIZE 16\n#define MAX(a, b) ((a) > (b) ? (a) : (b))\n";
+    code << "struct Item {\n    int id;\n    char name[SIZE];\n    struct Item *next;\n};\n";
+    for (unsigned int i = 0; i < 100; ++i) {
+        code << "#ifdef FEATURE_" << i % 4 << "\n";
+        code << "static int feature" << i << " = 0x" << std::hex << i * 37 << std::dec << ";\n";
+        code << "#endif\n";
+        code << "// function " << i << "\n";
+        code << "int func" << i << "(struct Item *item, int n, const char *s)\n{\n";
+        code << "    int sum = " << i << ";\n    char buf[SIZE];\n    int *p = 0;\n";
+        code << "    for (int k = 0; k < n; k++) {\n        sum += k * " << i + 1 << "u;\n";
+        code << "        if (sum > 0" << i << " && sum != n)\n            sum = MAX(sum, n) - " << i << ";\n    }\n";
+        code << "    if (item == 0 || item->id == " << i << ")\n        return -1;\n";
+        code << "    while (item->next != 0 && item->next->id != n)\n        item = item->next;\n";
+        code << "    strcpy(buf, s);\n    p = new int[n];\n    p[0] = sum + (n & 0xff) + (n | 3) + (n ^ 1);\n";
+        code << "    if (p[0] == p[0] || n + 1 == n + 1)\n        sum = 1.5e" << i % 8 << " > sum ? 0 : sum;\n";
+        code << "    delete [] p;\n    return sum + sizeof(buf) + " << i * 1000 << "L;\n}\n";
+    }
+    return code.str();
+}
+
+// embedded style code where most of the file depends on the configuration
+static std::string ifdefCode()
+{
+    std::ostringstream code;
+    code << "#define BOARD_REV 3\n";
+    for (unsigned int i = 0; i < 40; ++i) {
+        code << "#if defined(CHIP_A) && BOARD_REV > " << i % 5 << "\n";
+        code << "#define REG_BASE_" << i << " 0x4000" << i % 10 << "000u\n";
+        for (unsigned int j = 0; j < 6; ++j)
+            code << "static int chipA_" << i << "_" << j << "(int v) { return v + " << j << "; }\n";
+        code << "#elif defined CHIP_B\n";
+        code << "#ifdef USE_DMA\nstatic int dma" << i << ";\n#endif\n";
+        for (unsigned int j = 0; j < 6; ++j)
+            code << "static int chipB_" << i << "_" << j << "(int v) { return v * " << j + 1 << "; }\n";
+        code << "#else\n";
+        for (unsigned int j = 0; j < 6; ++j)
+            code << "static int generic_" << i << "_" << j << "(int v) { return v - " << j << "; }\n";
+        code << "#endif\n";
+        code << "#ifndef NO_TRACE\nstatic int trace" << i << " = " << i << ";\n#endif\n";
+    }
+    return code.str();
+}
+
+static bool readFile(const std::string &filename, std::string &code)
+{
+    std::ifstream fin(filename.c_str());
+    if (!fin.is_open())
+        return false;
+    std::ostringstream ostr;
+    ostr << fin.rdbuf();
+    code = ostr.str();
+    return true;
+}
+
+static bool prepareInput(BenchInput &input)
+{
+    Preprocessor preprocessor(*Settings::Instance(), &input.errorLogger);
+    std::istringstream raw(input.rawCode);
+    input.processedCode = preprocessor.read(raw, input.filename);
+    input.configurations = preprocessor.getcfgs(input.processedCode, input.filename, std::map<std::string, std::string>());
+    const std::string code = preprocessor.getcode(input.processedCode, emptyString, input.filename);
+
+    std::istringstream istr(code);
+    std::istringstream istr2(code);
+    try {
+        if (!input.tokenizer.tokenize(istr, input.filename.c_str()))
+            return false;
+        Settings::Instance()->_compactTokens = false;
+        const bool tokenized = input.uncompacted.tokenize(istr2, input.filename.c_str());
+        Settings::Instance()->_compactTokens = true;
+        if (!tokenized)
+            return false;
+    } catch (const InternalError &) {
+        Settings::Instance()->_compactTokens = true;
+        return false;
+    }
+
+    for (const Token *tok = input.tokenizer.tokens(); tok; tok = tok->next()) {
+        if (tok->isNumber())
+            input.numbers.push_back(tok->str());
+        if (tok->isOp() && tok->astOperand1() && tok->astOperand2())
+            input.binaryOperators.push_back(tok);
+    }
+    static const char * const numbers[] = { "0", "1", "-1", "0x7fffffff", "0777", "123456789", "10u", "42L", "0xFFul", "1.5", "2e3", "'a'" };
+    input.numbers.insert(input.numbers.end(), numbers, numbers + sizeof(numbers) / sizeof(numbers[0]));
+    return true;
+}
+
+struct BenchResult {
+    double nsPerOp;
+    double allocationsPerOp;
+    unsigned long long opsPerRound;
+    unsigned int rounds;
+    bool stable;
+};
+
+static BenchResult measure(const Benchmark &benchmark, BenchInput &input)
+{
+    // calibrate the number of calls per round
+    unsigned long long calls = 1;
+    for (;;) {
+        const std::clock_t start = std::clock();
+        for (unsigned long long i = 0; i < calls; ++i)
+            benchmark.run(input);
+        if (std::clock() - start >= MIN_ROUND_CLOCKS / 4 || calls >= (1ULL << 30))
+            break;
+        calls *= 2;
+    }
+    calls *= 4;
+
+    BenchResult result;
+    result.nsPerOp = 0;
+    result.allocationsPerOp = 0;
+    result.opsPerRound = 0;
+    result.stable = false;
+    std::vector<double> history;
+    for (result.rounds = 1; result.rounds <= MAX_ROUNDS; ++result.rounds) {
+        unsigned long long ops = 0;
+        const unsigned long long allocations = s_allocations;
+        const std::clock_t start = std::clock();
+        for (unsigned long long i = 0; i < calls; ++i)
+            ops += benchmark.run(input);
+        const std::clock_t clocks = std::clock() - start;
+        if (ops == 0)
+            break;
+
+        const double nsPerOp = (double)clocks * 1e9 / CLOCKS_PER_SEC / (double)ops;
+        if (history.empty() || nsPerOp < result.nsPerOp) {
+            result.nsPerOp = nsPerOp;
+            result.allocationsPerOp = (double)(s_allocations - allocations) / (double)ops;
+        }
+        result.opsPerRound = ops;
+        history.push_back(nsPerOp);
+
+        if (history.size() >= STABLE_ROUNDS) {
+            double low = history.back(), high = history.back();
+            for (std::size_t i = history.size() - STABLE_ROUNDS; i < history.size(); ++i) {
+                low = std::min(low, history[i]);
+                high = std::max(high, history[i]);
+            }
+            if (high - low <= low * STABLE_SPREAD) {
+                result.stable = true;
+                break;
+            }
+        }
+    }
+    if (result.rounds > MAX_ROUNDS)
+        result.rounds = MAX_ROUNDS;
+    return result;
+}
+
+static std::string jsonString(const std::string &str)
+{
+    std::string ret = "\"";
+    for (std::string::size_type i = 0; i < str.size(); ++i) {
+        if (str[i] == '"' || str[i] == '\\')
+            ret += '\\';
+        ret += str[i];
+    }
+    return ret + "\"";
+}
+
+int main(int argc, char *argv[])
+{
+    std::string filter;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.compare(0, 9, "--filter=") == 0)
+            filter = arg.substr(9);
+        else if (arg == "-h" || arg == "--help") {
+            std::cout << "Usage: microbench [--filter=<text>] [file.cpp ...]\n";
+            return EXIT_SUCCESS;
+        } else
+            files.push_back(arg);
+    }
+
+    // the inputs are not part of a project, the tokenizer finds no files in this table
+    CFileDependTable fileTable;
+    CGlobalMacros::SetFileTable(&fileTable);
+
+    BenchInput synthetic("synthetic");
+    synthetic.filename = "synthetic.cpp";
+    synthetic.rawCode = syntheticCode();
+    BenchInput ifdefs("ifdefs");
+    ifdefs.filename = "ifdefs.c";
+    ifdefs.rawCode = ifdefCode();
+    BenchInput concatenated("files");
+    concatenated.filename = "files.cpp";
+    for (std::size_t i = 0; i < files.size(); ++i) {
+        std::string code;
+        if (!readFile(files[i], code)) {
+            std::cerr << "microbench: can not read " << files[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+        concatenated.rawCode += code + "\n";
+    }
+
+    std::vector<BenchInput *> inputs;
+    inputs.push_back(&synthetic);
+    inputs.push_back(&ifdefs);
+    if (!files.empty())
+        inputs.push_back(&concatenated);
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        if (!prepareInput(*inputs[i])) {
+            std::cerr << "microbench: can not tokenize the " << inputs[i]->name << " input" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "{\n\"benchmarks\": [";
+    bool first = true;
+    for (std::size_t i = 0; i < inputs.size(); ++i) {
+        for (std::size_t j = 0; j < sizeof(s_benchmarks) / sizeof(s_benchmarks[0]); ++j) {
+            const Benchmark &benchmark = s_benchmarks[j];
+            if (!filter.empty() && std::string(benchmark.name).find(filter) == std::string::npos)
+                continue;
+            const BenchResult result = measure(benchmark, *inputs[i]);
+            std::cout << (first ? "\n" : ",\n") << std::fixed
+                      << "{\"name\": " << jsonString(benchmark.name)
+                      << ", \"input\": " << jsonString(inputs[i]->name)
+                      << ", \"nsPerOp\": " << std::setprecision(2) << result.nsPerOp
+                      << ", \"allocationsPerOp\": " << std::setprecision(3) << result.allocationsPerOp
+                      << ", \"opsPerRound\": " << result.opsPerRound
+                      << ", \"rounds\": " << result.rounds
+                      << ", \"stable\": " << (result.stable ? "true" : "false") << "}" << std::flush;
+            first = false;
+        }
+    }
+    std::cout << "\n]\n}\n";
+    return EXIT_SUCCESS;
+}
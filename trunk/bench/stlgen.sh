@@ -0,0 +1,119 @@
+#!/bin/sh
+#
+# Write random C++ functions that use STL iterators, for bench/iterdiff.sh.
+#
+# Usage: bench/stlgen.sh <seed> <functions>
+#
+# The same seed always gives the same code. The functions mix iterators of
+# several containers: assignments between them, erase and insert through
+# them, increments, comparisons with end() and dereferences, inside if,
+# while and for statements. Much of it is wrong on purpose, so that
+# CheckStl::iterators has something to report.
+
+if [ $# -ne 2 ]; then
+    echo "Usage: $0 <seed> <functions>" >&2
+    exit 2
+fi
+
+awk -v seed="$1" -v functions="$2" '
+function pick(n) {
+    return int(rand() * n)
+}
+
+# one of the iterators declared at the top of the function
+function iter() {
+    return "it" pick(nit)
+}
+
+function container() {
+    return cont[1 + pick(ncont)]
+}
+
+function statement(depth, indent,    it, it2, c, j, k, s) {
+    it = iter()
+    it2 = iter()
+    c = container()
+    k = pick(depth < 2 ? 22 : 18)
+    if (k == 0) return indent it " = " it2 ";"
+    if (k == 1) return indent it " = " c ".begin();"
+    if (k == 2) return indent it " = " c ".end();"
+    if (k == 3) return indent it " = " c ".find(3);"
+    if (k == 4) return indent "std::advance(" it ", 1);"
+    if (k == 5) return indent c ".erase(" it ");"
+    if (k == 6) return indent c ".erase(" it "++);"
+    if (k == 7) return indent c ".erase(++" it ");"
+    if (k == 8) return indent c ".erase(*" it ");"
+    if (k == 9) return indent c ".insert(" it ", 1);"
+    if (k == 10) return indent c ".insert(*" it ");"
+    if (k == 11) return indent it ".operator++();"
+    if (k == 12) return indent "x = (" it " == " c ".end());"
+    if (k == 13) return indent "use(*" it ");"
+    if (k == 14) return indent "take(" it ");"
+    if (k == 15) return indent c ".erase(" it "); use(*" it ");"
+    if (k == 16) return indent "use(0);"
+    if (k == 17) return indent "if (" it " != " c ".end()) { use(*" it "); }"
+    if (k == 18) return indent "if (x > " pick(10) ") { " block(depth + 1) " } else { " block(depth + 1) " }"
+    if (k == 19) return indent "while (" it " != " c ".end()) { " block(depth + 1) " }"
+    if (k == 20) {
+        j = "j" pick(1000)
+        s = type[c]
+        return indent "for (std::" s "::iterator " j " = " c ".begin(); " j " != " container() ".end(); ++" j ") { " loopblock(depth + 1, j, c) " }"
+    }
+    return indent "for (std::" type[c] "::iterator it = " c ".begin(); it != " c ".end(); ++it) { " block(depth + 1) " }"
+}
+
+function block(depth,    n, i, s) {
+    n = 1 + pick(4)
+    s = ""
+    for (i = 0; i < n; i++)
+        s = s (i ? " " : "") statement(depth, "")
+    return s
+}
+
+# the body of a loop over c with iterator j
+function loopblock(depth, j, c,    k) {
+    k = pick(6)
+    if (k == 0) return c ".erase(" j "); " block(depth)
+    if (k == 1) return j " = " c ".erase(" j "); " block(depth)
+    if (k == 2) return "use(*" j "); " block(depth)
+    if (k == 3) return j " = " container() ".find(3); " block(depth)
+    if (k == 4) return block(depth) " return;"
+    return block(depth) " break;"
+}
+
+BEGIN {
+    srand(seed)
+    ncont = split("v1 v2 d1 l1 s1 m1", cont, " ")
+    type["v1"] = "vector<int>"
+    type["v2"] = "vector<int>"
+    type["d1"] = "deque<int>"
+    type["l1"] = "list<int>"
+    type["s1"] = "set<int>"
+    type["m1"] = "map<int,int>"
+
+    print "#include <vector>"
+    print "#include <list>"
+    print "#include <set>"
+    print "#include <map>"
+    print "#include <deque>"
+    print "void use(int);"
+    print "void take(std::vector<int>::iterator);"
+    for (f = 0; f < functions; f++) {
+        print "void f" f "(std::vector<int>& v1, std::vector<int>& v2, std::deque<int>& d1, std::list<int>& l1, std::set<int>& s1, std::map<int,int>& m1, int x) {"
+        nit = 3 + pick(6)
+        for (i = 0; i < nit; i++) {
+            c = container()
+            k = pick(3)
+            if (k == 0)
+                print "    std::" type[c] "::iterator it" i ";"
+            else if (k == 1)
+                print "    std::" type[c] "::iterator it" i "(" c ".begin());"
+            else
+                print "    std::" type[c] "::iterator it" i " = " c ".begin();"
+        }
+        n = 10 + pick(40)
+        for (i = 0; i < n; i++)
+            print statement(0, "    ")
+        print "}"
+    }
+}'
@@ -0,0 +1,64 @@
+#!/bin/sh
+#
+# Compare the run time and the findings of two tscancode builds on the
+# inputs of --stress (make checkstress).
+#
+# Usage: bench/stressdiff.sh <old tscancode> <new tscancode> [patterns]
+#
+# The tscancode of this directory writes the inputs of the given
+# --stress-patterns, by default eraseloop, and keeps the largest size of
+# each, so the builds compared need no --stress. Both builds then check
+# every input with invalidIterator turned on in a copy of cfg/. The script
+# prints the time of each run, the differences of the sorted findings, and
+# fails if there are any.
+#
+# Run it from the directory of the Makefile, cfg/ is copied from there.
+
+if [ $# -lt 2 ]; then
+    echo "Usage: $0 <old tscancode> <new tscancode> [patterns]" >&2
+    exit 2
+fi
+
+absolute() {
+    case $1 in
+    /*) echo "$1" ;;
+    *) echo "$PWD/$1" ;;
+    esac
+}
+
+OLD=$(absolute "$1")
+NEW=$(absolute "$2")
+PATTERNS=${3:-eraseloop}
+GEN=$PWD/tscancode
+
+TMP=${TMPDIR:-/tmp}/stressdiff.$$
+mkdir -p "$TMP/stress" || exit 2
+trap 'rm -rf "$TMP"' EXIT
+
+cp -R cfg "$TMP/cfg" || exit 2
+sed 's/<subid name="invalidIterator" value="0"/<subid name="invalidIterator" value="1"/' cfg/cfg.xml > "$TMP/cfg/cfg.xml" || exit 2
+
+# the run fails when a phase grows superlinearly, the inputs are written anyway
+(cd "$TMP" && "$GEN" --stress="$TMP/stress" --stress-patterns="$PATTERNS" > stress.txt)
+rm -f "$TMP"/stress/*.json
+
+# milliseconds of one run, the findings go to <file>
+timed() {
+    start=$(date +%s%N)
+    (cd "$TMP" && "$1" -q "$2" 2>&1 >/dev/null | sort > "$3")
+    end=$(date +%s%N)
+    echo $(( (end - start) / 1000000 ))
+}
+
+status=0
+for input in "$TMP"/stress/*.cpp; do
+    name=$(basename "$input" .cpp)
+    old_ms=$(timed "$OLD" "$input" "$TMP/$name.old")
+    new_ms=$(timed "$NEW" "$input" "$TMP/$name.new")
+    echo "stressdiff: $name: $old_ms ms -> $new_ms ms, $(wc -l < "$TMP/$name.new") findings"
+    if ! diff "$TMP/$name.old" "$TMP/$name.new"; then
+        echo "stressdiff: $name: the findings differ" >&2
+        status=1
+    fi
+done
+exit $status
@@ -0,0 +1,43 @@
+#!/bin/sh
+#
+# Compare the findings of a normal run with those of --window-size
+# (make checkwindows).
+#
+# Usage: bench/windowdiff.sh <tscancode> [file or directory ...]
+#
+# The given files and a large C file of bench/cgen.sh are checked once as a
+# whole and once in windows of WINDOW_SIZE MB of function bodies (default 1).
+# The script prints the differences of the sorted findings and fails if
+# there are any.
+#
+# Run it from the directory of the Makefile, tscancode reads cfg/ from there.
+
+if [ $# -lt 1 ]; then
+    echo "Usage: $0 <tscancode> [file or directory ...]" >&2
+    exit 2
+fi
+
+TSC=$1
+shift
+
+# window size in MB, and the number of generated functions of about 400 bytes.
+# The whole file must stay below large_token_count of cfg/cfg.xml: larger files
+# skip the enum simplification, and their windows then report more.
+WINDOW_SIZE=${WINDOW_SIZE:-1}
+C_FUNCTIONS=${C_FUNCTIONS:-3000}
+
+TMP=${TMPDIR:-/tmp}/windowdiff.$$
+mkdir -p "$TMP/gen" || exit 2
+trap 'rm -rf "$TMP"' EXIT
+
+sh bench/cgen.sh "$C_FUNCTIONS" > "$TMP/gen/gen.c" || exit 2
+
+"$TSC" -q "$TMP/gen" "$@" 2>&1 >/dev/null | sort > "$TMP/whole.txt"
+"$TSC" -q --window-size="$WINDOW_SIZE" "$TMP/gen" "$@" 2>&1 >/dev/null | sort > "$TMP/windows.txt"
+
+if diff "$TMP/whole.txt" "$TMP/windows.txt"; then
+    echo "windowdiff: $(wc -l < "$TMP/windows.txt") findings, same with --window-size=$WINDOW_SIZE"
+    exit 0
+fi
+echo "windowdiff: the findings differ" >&2
+exit 1
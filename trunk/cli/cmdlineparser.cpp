@@ -1,6 +1,7 @@
 #include "cmdlineparser.h"
 #include "tscancode.h"
 #include "tscexecutor.h"
+#include "tscstresstest.h"
 #include "filelister.h"
 #include "path.h"
 #include "settings.h"
@@ -149,6 +150,26 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
         else if (std::strcmp(argv[i], "--dump") == 0)
             _settings->dump = true;
 
+        else if (std::strncmp(argv[i], "--dump-format=", 14) == 0) {
+            const std::string format(argv[i] + 14);
+            if (format == "xml")
+                _settings->_dumpFormat = DUMP_XML;
+            else if (format == "jsonl")
+                _settings->_dumpFormat = DUMP_JSONL;
+            else {
+                PrintMessage("TscanCode: error: unrecognized dump format: \"" + format + "\".");
+                return false;
+            }
+        }
+
+        else if (std::strncmp(argv[i], "--dump-sections=", 16) == 0) {
+            _settings->_dumpSections = DumpWriter::parseSections(argv[i] + 16);
+            if (_settings->_dumpSections == 0) {
+                PrintMessage("TscanCode: error: argument to '--dump-sections=' must be a comma separated list of tokens, scopes, variables and values.");
+                return false;
+            }
+        }
+
         else if (std::strcmp(argv[i], "--exception-handling") == 0)
             _settings->exceptionHandling = true;
         else if (std::strncmp(argv[i], "--exception-handling=", 21) == 0) {
@@ -161,6 +182,54 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
         else if (std::strcmp(argv[i], "--inconclusive") == 0)
             _settings->inconclusive = true;
 
+        // Only check code touched by a diff or a list of file:line ranges
+        else if (std::strncmp(argv[i], "--diff-scope=", 13) == 0) {
+            const std::string filename = argv[i] + 13;
+            std::ifstream f(filename.c_str());
+            if (!f.is_open()) {
+                PrintMessage("TscanCode: Couldn't open the file: \"" + filename + "\".");
+                return false;
+            }
+            const std::string errmsg(_settings->_changedLines.parseFile(f));
+            if (!errmsg.empty()) {
+                PrintMessage(errmsg);
+                return false;
+            }
+        }
+
+        // Do not report the findings of an earlier run
+        else if (std::strncmp(argv[i], "--baseline=", 11) == 0) {
+            const std::string filename = argv[i] + 11;
+            std::ifstream f(filename.c_str());
+            if (!f.is_open()) {
+                PrintMessage("TscanCode: Couldn't open the file: \"" + filename + "\".");
+                return false;
+            }
+            const std::string errmsg(_settings->_baseline.parseFile(f));
+            if (!errmsg.empty()) {
+                PrintMessage(errmsg);
+                return false;
+            }
+        }
+
+        // Write the fingerprints of the findings for the next --baseline=
+        else if (std::strncmp(argv[i], "--baseline-out=", 15) == 0) {
+            _settings->_baselineOut = argv[i] + 15;
+            if (_settings->_baselineOut.empty()) {
+                PrintMessage("TscanCode: error: no file name given to '--baseline-out='.");
+                return false;
+            }
+        }
+
+        // Reuse the findings of unchanged functions
+        else if (std::strncmp(argv[i], "--incremental-dir=", 18) == 0) {
+            _settings->_incrementalDir = Path::fromNativeSeparators(argv[i] + 18);
+            if (_settings->_incrementalDir.empty() || !FileLister::isDirectory(_settings->_incrementalDir)) {
+                PrintMessage("TscanCode: error: directory '" + _settings->_incrementalDir + "' given to '--incremental-dir=' does not exist.");
+                return false;
+            }
+        }
+
         // Enforce language (--language=, -x)
         else if (std::strncmp(argv[i], "--language=", 11) == 0 || std::strcmp(argv[i], "-x") == 0) {
             std::string str;
@@ -265,6 +334,18 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
         else if (std::strcmp(argv[i], "-f") == 0 || std::strcmp(argv[i], "--force") == 0)
             _settings->_force = true;
 
+        // Preprocess all configurations from one shared line stream
+        else if (std::strcmp(argv[i], "--variability-aware") == 0)
+            _settings->_variabilityAware = true;
+
+        // Keep the tokens where the simplifications left them
+        else if (std::strcmp(argv[i], "--no-compact-tokens") == 0)
+            _settings->_compactTokens = false;
+
+        // Do not check configurations with nothing but declarations
+        else if (std::strcmp(argv[i], "--skip-thin-files") == 0)
+            _settings->_skipThinFiles = true;
+
         // Output relative paths
         else if (std::strcmp(argv[i], "-rp") == 0 || std::strcmp(argv[i], "--relative-paths") == 0)
             _settings->_relativePaths = true;
@@ -645,6 +726,74 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
                 return false;
             }
         }
+
+        // write deterministic work counts
+        else if (std::strncmp(argv[i], "--work-counters=", 16) == 0) {
+            _settings->_workCounters = argv[i] + 16;
+            if (_settings->_workCounters.empty()) {
+                PrintMessage("TscanCode: error: no file name given to '--work-counters='.");
+                return false;
+            }
+        }
+
+        // compare the work counts with an earlier --work-counters file
+        else if (std::strncmp(argv[i], "--work-counters-baseline=", 25) == 0) {
+            _settings->_workCountersBaseline = argv[i] + 25;
+            std::ifstream f(_settings->_workCountersBaseline.c_str());
+            if (!f.is_open()) {
+                PrintMessage("TscanCode: Couldn't open the file: \"" + _settings->_workCountersBaseline + "\".");
+                return false;
+            }
+        }
+
+        // allowed growth of a work count in percent
+        else if (std::strncmp(argv[i], "--work-counters-tolerance=", 26) == 0) {
+            std::istringstream iss(26+argv[i]);
+            if (!(iss >> _settings->_workCountersTolerance)) {
+                PrintMessage("TscanCode: argument to '--work-counters-tolerance=' is not a number.");
+                return false;
+            }
+        }
+
+        // find phases that grow superlinearly with generated inputs
+        else if (std::strncmp(argv[i], "--stress=", 9) == 0) {
+            _stressDir = Path::fromNativeSeparators(argv[i] + 9);
+            if (_stressDir.empty() || !FileLister::isDirectory(_stressDir)) {
+                PrintMessage("TscanCode: error: directory '" + _stressDir + "' given to '--stress=' does not exist.");
+                return false;
+            }
+        }
+
+        // read the input from a bundle written by --pack-bundle=
+        else if (std::strncmp(argv[i], "--bundle=", 9) == 0) {
+            _bundle = argv[i] + 9;
+            if (_bundle.empty()) {
+                PrintMessage("TscanCode: error: no file given to '--bundle='.");
+                return false;
+            }
+        }
+
+        // pack the input into one file
+        else if (std::strncmp(argv[i], "--pack-bundle=", 14) == 0) {
+            _packBundle = argv[i] + 14;
+            if (_packBundle.empty()) {
+                PrintMessage("TscanCode: error: no file given to '--pack-bundle='.");
+                return false;
+            }
+        }
+
+        // patterns generated by --stress=
+        else if (std::strncmp(argv[i], "--stress-patterns=", 18) == 0) {
+            std::istringstream iss(argv[i] + 18);
+            std::string pattern;
+            while (std::getline(iss, pattern, ',')) {
+                if (!TscStressTest::IsPattern(pattern)) {
+                    PrintMessage("TscanCode: error: unknown stress pattern \"" + pattern + "\". Known patterns: " + TscStressTest::PatternNames() + ".");
+                    return false;
+                }
+                _stressPatterns.push_back(pattern);
+            }
+        }
 #ifdef HAVE_RULES
         // Rule given at command line
         else if (std::strncmp(argv[i], "--rule=", 7) == 0) {
@@ -717,6 +866,38 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
             }
         }
 
+        // Threads checking the functions of one file
+        else if (std::strncmp(argv[i], "--function-jobs=", 16) == 0) {
+            std::istringstream iss(16+argv[i]);
+            if (!(iss >> _settings->_functionJobs)) {
+                PrintMessage("TscanCode: argument to '--function-jobs=' is not a number.");
+                return false;
+            }
+
+            if (_settings->_functionJobs < 1 || _settings->_functionJobs > 10000) {
+                PrintMessage("TscanCode: argument to '--function-jobs=' must be between 1 and 10000.");
+                return false;
+            }
+        }
+
+        // Limit the resident size of global macro definitions
+        else if (std::strncmp(argv[i], "--memory-budget=", 16) == 0) {
+            std::istringstream iss(16+argv[i]);
+            if (!(iss >> _settings->_memoryBudget)) {
+                PrintMessage("TscanCode: argument to '--memory-budget=' is not a number.");
+                return false;
+            }
+        }
+
+        // Check large configurations one window of functions at a time
+        else if (std::strncmp(argv[i], "--window-size=", 14) == 0) {
+            std::istringstream iss(14+argv[i]);
+            if (!(iss >> _settings->_windowSize)) {
+                PrintMessage("TscanCode: argument to '--window-size=' is not a number.");
+                return false;
+            }
+        }
+
         // Set maximum number of #ifdef configurations to check
         else if (std::strncmp(argv[i], "--max-configs=", 14) == 0) {
             _settings->_force = false;
@@ -800,7 +981,7 @@ bool CmdLineParser::ParseFromArgs(int argc, const char* const argv[])
     }
 
     // Print error only if we have "real" command and expect files
-    if (!_exitAfterPrint && !_mergecfg && _pathnames.empty()) {
+    if (!_exitAfterPrint && !_mergecfg && _stressDir.empty() && _pathnames.empty()) {
         PrintMessage("TscanCode: No C or C++ source files found.");
         return false;
     }
@@ -831,6 +1012,16 @@ void CmdLineParser::PrintHelp()
               "    -U<ID>               Undefine preprocessor symbol. Use -U to explicitly\n"
               "                         hide certain #ifdef <ID> code paths from checking.\n"
               "                         Example: '-UDEBUG'\n"
+              "    --baseline=<file>    Do not report the findings listed in <file>, written\n"
+              "                         by --baseline-out= of an earlier run. Findings are\n"
+              "                         matched by check, file, function and source line,\n"
+              "                         not by line number.\n"
+              "    --baseline-out=<file>\n"
+              "                         Write the fingerprints of all findings of this run,\n"
+              "                         reported or not, to <file>.\n"
+              "    --bundle=<file>      Read the sources and headers from <file>, written by\n"
+              "                         --pack-bundle=, instead of the disk. Give the same\n"
+              "                         paths and -I options as when packing.\n"
               "    --enable=<id>        Enable additional checks. The available ids are:\n"
               "                          * all\n"
               "                                  Enable all checks. It is recommended to only\n"
@@ -857,13 +1048,64 @@ void CmdLineParser::PrintHelp()
               "                                  detailed information, use '--check-config'.\n"
               "                         Several ids can be given if you separate them with\n"
               "                         commas. See also --std\n"
+              "    --dump               Write the token list, symbol database and value flow of\n"
+              "                         each file to <file>.dump instead of checking it.\n"
+              "    --dump-format=<fmt>  Format of the --dump output: 'xml' (default) or 'jsonl',\n"
+              "                         one JSON record per line in <file>.dump.jsonl.\n"
+              "    --dump-sections=<s>  Comma separated parts to dump: tokens, scopes,\n"
+              "                         variables and values. Default is all.\n"
+              "    --diff-scope=<file>  Only check the files and functions touched by a change\n"
+              "                         and only report findings in changed lines. <file> is\n"
+              "                         a unified diff or has one file:line or\n"
+              "                         file:first-last entry per line.\n"
+              "    --function-jobs=<n>  Check the functions of a file with <n> threads in the\n"
+              "                         checks that support it (TSC Null Pointer). The\n"
+              "                         findings are the same as with one thread.\n"
               "    -h, --help           Print this help.\n"
               "    -I <dir>             Give path to search for include files. Give several -I\n"
               "                         parameters to give several paths. First given path is\n"
               "                         searched for contained header files first. If paths are\n"
               "                         relative to source files, this is not needed.\n"
+              "    --incremental-dir=<dir>\n"
+              "                         Keep the findings of each function in <dir> and only\n"
+              "                         recheck functions that changed since the last run.\n"
+              "                         Clear <dir> when the configuration changes.\n"
               "    -j <jobs>            Start [jobs] threads to do the checking simultaneously.\n"
+              "    --memory-budget=<MB> Keep at most <MB> of global macro definitions in\n"
+              "                         memory, the rest is spilled to a temporary file.\n"
+              "    --no-compact-tokens  Do not move the tokens into one block in list order\n"
+              "                         after the simplifications. For benchmarking.\n"
+              "    --pack-bundle=<file> Pack the given paths, the -I paths and the headers\n"
+              "                         they include into <file> and exit. Check from the\n"
+              "                         local copy with --bundle=<file>.\n"
               "    -q, --quiet          Do not show progress reports.\n"
+              "    --skip-thin-files    Do not check configurations without function bodies,\n"
+              "                         class definitions or initializers outside of headers\n"
+              "                         already checked by the thread with the same code.\n"
+              "                         Their declarations are still recorded. Each decision\n"
+              "                         is printed, with -q only the skipped ones.\n"
+              "    --stress=<dir>       Check generated inputs of growing size in <dir> and\n"
+              "                         report phases whose work grows superlinearly.\n"
+              "    --stress-patterns=<p>\n"
+              "                         Comma separated patterns for --stress=: nesting,\n"
+              "                         elseif, locals, funclen, ifdef, macro, include,\n"
+              "                         template, initializer and eraseloop. Default is all.\n"
+              "    --variability-aware  With --force or --max-configs=, split a file once into\n"
+              "                         code and directives shared by all configurations and\n"
+              "                         check configurations with the same code only once.\n"
+              "    --window-size=<MB>   Check configurations larger than <MB> after\n"
+              "                         preprocessing in windows of function bodies of about\n"
+              "                         <MB>, to limit the memory of a thread. Checks that need\n"
+              "                         other function bodies see less. Not used with --dump\n"
+              "                         and --incremental-dir.\n"
+              "    --work-counters=<file>\n"
+              "                         Write machine independent counts of the work done in\n"
+              "                         each phase and check to <file> as JSON.\n"
+              "    --work-counters-baseline=<file>\n"
+              "                         Fail if a work count grew compared to <file>, written\n"
+              "                         by --work-counters= of an earlier run.\n"
+              "    --work-counters-tolerance=<n>\n"
+              "                         Allowed growth of a work count in percent. Default 5.\n"
               "    --xml                Write results in xml format to error stream (stderr).\n"
               "\n"
               "Example usage:\n"
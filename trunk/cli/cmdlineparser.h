@@ -78,6 +78,35 @@ public:
 		return _oldcfg;
 	}
 
+	/**
+	* Return the directory given to --stress=, empty if not given.
+	*/
+	const std::string& GetStressDir() const
+	{
+		return _stressDir;
+	}
+
+	const std::vector<std::string>& GetStressPatterns() const
+	{
+		return _stressPatterns;
+	}
+
+	/**
+	* Return the file given to --bundle=, empty if not given.
+	*/
+	const std::string& GetBundle() const
+	{
+		return _bundle;
+	}
+
+	/**
+	* Return the file given to --pack-bundle=, empty if not given.
+	*/
+	const std::string& GetPackBundle() const
+	{
+		return _packBundle;
+	}
+
     /**
      * Return if we should exit after printing version, help etc.
      */
@@ -116,6 +145,12 @@ private:
 	bool _mergecfg;
 	std::string _newcfg;
 	std::string _oldcfg;
+
+	std::string _stressDir;
+	std::vector<std::string> _stressPatterns;
+
+	std::string _bundle;
+	std::string _packBundle;
 };
 
 /// @}
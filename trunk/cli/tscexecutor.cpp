@@ -9,8 +9,12 @@
 #include "preprocessor.h"
 //#include "threadexecutor.h"
 #include "tscthreadexecutor.h"
+#include "tscstresstest.h"
 #include "globaltokenizer.h"
 #include "globalmacros.h"
+#include "workcounters.h"
+#include "sideoutput.h"
+#include "sourcebundle.h"
 #ifdef _WIN32
 #include "CrashHelp.h"
 #endif
@@ -22,6 +26,7 @@
 #include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <fstream>
 
 #if !defined(NO_UNIX_SIGNAL_HANDLING) && defined(__GNUC__) && !defined(__CYGWIN__) && !defined(__MINGW32__) && !defined(__OS2__)
 #define USE_UNIX_SIGNAL_HANDLING
@@ -65,6 +70,7 @@ TscanCodeExecutor::TscanCodeExecutor()
 TscanCodeExecutor::~TscanCodeExecutor()
 {
 	Settings::Destroy();
+	CSourceBundle::Unload();
 }
 
 bool TscanCodeExecutor::parseFromArgs(TscanCode *tscancode, int argc, const char* const argv[])
@@ -101,6 +107,31 @@ bool TscanCodeExecutor::parseFromArgs(TscanCode *tscancode, int argc, const char
 			settings.terminate();
 			return true;
 		}
+
+		if (!parser.GetStressDir().empty())
+		{
+			TscStressTest stressTest(argv[0], parser.GetStressDir());
+			const bool bLinear = stressTest.Run(parser.GetStressPatterns());
+			settings.terminate();
+			return bLinear;
+		}
+
+		if (!parser.GetBundle().empty())
+		{
+			if (!parser.GetPackBundle().empty())
+			{
+				std::cout << "TscanCode: error: '--bundle=' and '--pack-bundle=' can not be combined." << std::endl;
+				return false;
+			}
+
+			// from here on the input is read from the bundle
+			std::string sError;
+			if (!CSourceBundle::Load(parser.GetBundle(), sError))
+			{
+				std::cout << "TscanCode: error: " << sError << std::endl;
+				return false;
+			}
+		}
 	}
 	else {
 		return false;
@@ -113,7 +144,7 @@ bool TscanCodeExecutor::parseFromArgs(TscanCode *tscancode, int argc, const char
 			iter != settings._includePaths.end();
 			) {
 			const std::string path(Path::toNativeSeparators(*iter));
-			if (FileLister::isDirectory(path))
+			if (CSourceBundle::IsDirectory(path))
 				++iter;
 			else {
 				// If the include path is not found, warn user and remove the non-existing path from the list.
@@ -123,6 +154,16 @@ bool TscanCodeExecutor::parseFromArgs(TscanCode *tscancode, int argc, const char
 		}
 	}
 
+	if (!parser.GetPackBundle().empty())
+	{
+		std::vector<std::string> includePaths(settings._includePaths.begin(), settings._includePaths.end());
+		std::string sMessage;
+		const bool bPacked = CSourceBundle::Pack(parser.GetPackBundle(), parser.GetPathNames(), includePaths, settings.userIncludes, sMessage);
+		std::cout << "TscanCode: " << (bPacked ? "" : "error: ") << sMessage << std::endl;
+		settings.terminate();
+		return bPacked;
+	}
+
 	//try load project custom cfg.xml
 	settings.LoadCustomCfgXml("cfg/cfg.xml", argv[0]); //suppress return warning
 
@@ -844,6 +885,8 @@ int TscanCodeExecutor::check_internal(TscanCode& tscancode, int /*argc*/, const
 	CLog::Initialize();
 #endif
 
+	if (!settings._workCounters.empty() || !settings._workCountersBaseline.empty())
+		WorkCounters::enable();
 
 	returnValue = analyze(settings);
 	if (returnValue) {
@@ -856,6 +899,24 @@ int TscanCodeExecutor::check_internal(TscanCode& tscancode, int /*argc*/, const
 	TscThreadExecutor executor(&_fileDependTable, settings, *this);
 	returnValue = executor.check(false, _settings->_no_check);
 
+	if (!settings._baselineOut.empty()) {
+		std::ofstream fout(settings._baselineOut.c_str());
+		settings._baseline.write(fout);
+	}
+
+	bool workRegression = false;
+	if (!settings._workCounters.empty()) {
+		std::ofstream fout(settings._workCounters.c_str());
+		WorkCounters::write(fout);
+	}
+	if (!settings._workCountersBaseline.empty()) {
+		std::ifstream fin(settings._workCountersBaseline.c_str());
+		std::ostringstream report;
+		if (WorkCounters::compare(fin, settings._workCountersTolerance, report) > 0) {
+			std::cout << "TscanCode: work counts grew by more than " << settings._workCountersTolerance << "%:" << std::endl << report.str();
+			workRegression = true;
+		}
+	}
 
 	if (!settings.checkConfiguration) {
 		tscancode.tooManyConfigsError("", 0U);
@@ -885,6 +946,8 @@ int TscanCodeExecutor::check_internal(TscanCode& tscancode, int /*argc*/, const
 
 
 	_settings = 0;
+	if (workRegression)
+		return EXIT_FAILURE;
 	if (returnValue)
 		return settings._exitCode;
 	else
@@ -893,8 +956,10 @@ int TscanCodeExecutor::check_internal(TscanCode& tscancode, int /*argc*/, const
 
 void TscanCodeExecutor::uninit()
 {
+	SideOutput::wait();
 	CGlobalMacros::Uninitialize();
 	CGlobalTokenizer::Uninitialize();
+	WorkCounters::shutdown();
 }
 
 unsigned int TscanCodeExecutor::analyze(Settings& settings)
@@ -0,0 +1,312 @@
+#include "tscstresstest.h"
+#include "workcounters.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#define NULL_REDIRECT	" 2>NUL"
+#else
+#define NULL_REDIRECT	" 2>/dev/null"
+#endif
+
+// every pattern is checked at baseSize, 2 * baseSize, .. 16 * baseSize
+static const unsigned int STRESS_STEPS = 5;
+// growth exponent from which a phase counts as superlinear
+static const double SUPERLINEAR_EXPONENT = 1.5;
+// phases doing less work at the largest size are too small to be fitted
+static const double MIN_WORK = 10000.0;
+
+// if (x > 0) { if (x > 1) { ... } }
+static void GenerateNesting(std::ostream& out, const std::string& /*name*/, unsigned int size, std::map<std::string, std::string>& /*headers*/)
+{
+	out << "int f(int x, int *p)\n{\n\tint y = 0;\n";
+	for (unsigned int i = 0; i < size; ++i)
+		out << std::string(i % 32 + 1, '\t') << "if (x > " << i << ") {\n";
+	out << "\ty = *p + x;\n";
+	for (unsigned int i = size; i > 0; --i)
+		out << std::string((i - 1) % 32 + 1, '\t') << "}\n";
+	out << "\treturn y;\n}\n";
+}
+
+// if (x == 0) .. else if (x == 1) .. else if ..
+static void GenerateElseIf(std::ostream& out, const std::string& /*name*/, unsigned int size, std::map<std::string, std::string>& /*headers*/)
+{
+	out << "int f(int x, char *buf)\n{\n\tint y;\n";
+	for (unsigned int i = 0; i < size; ++i)
+		out << (i ? "\telse if (x == " : "\tif (x == ") << i << ")\n\t\ty = buf[" << i % 16 << "] + " << i << ";\n";
+	out << "\telse\n\t\ty = -1;\n\treturn y;\n}\n";
+}
+
+// many local variables, each used by the next one
+static void GenerateLocals(std::ostream& out, const std::string& /*name*/, unsigned int size, std::map<std::string, std::string>& /*headers*/)
+{
+	out << "int f(int x)\n{\n\tint v0 = x;\n";
+	for (unsigned int i = 1; i < size; ++i)
+		out << "\tint v" << i << " = v" << i - 1 << " + " << i << ";\n";
+	out << "\tint *p = &v0;\n\treturn *p + v" << size - 1 << ";\n}\n";
+}
+
+// one long function body
+static void GenerateFunctionLength(std::ostream& out, const std::string& /*name*/, unsigned int size, std::map<std::string, std::string>& /*headers*/)
+{
+	out << "int f(int *a, int b)\n{\n\tint s = 0;\n";
+	for (unsigned int i = 0; i < size; ++i) {
+		out << "\ts += a[" << i % 16 << "] * b;\n";
+		if (i % 4 == 3)
+			out << "\tif (s > " << i << ")\n\t\ts -= b;\n";
+	}
+	out << "\treturn s;\n}\n";
+}
+
+// #ifdef CFG_0 .. #else .. #endif blocks
+static void GenerateIfdefs(std::ostream& out, const std::string& /*name*/, unsigned int size, std::map<std::string, std::string>& /*headers*/)
+{
+	for (unsigned int i = 0; i < size; ++i)
+		out << "#ifdef CFG_" << i << "\nint g" << i << " = " << i << ";\n#else\nint g" << i << " = -" << i << ";\n#endif\n";
+	out << "int f()\n{\n\treturn g0 + g" << size - 1 << ";\n}\n";
+}
+
+// M3(x) expands to M2((x) + 1) and so on
+static void GenerateMacroDepth(std::ostream& out, const std::string& /*name*/, unsigned int size, std::map<std::string, std::string>& /*headers*/)
+{
+	out << "#define M0(x) (x)\n";
+	for (unsigned int i = 1; i <= size; ++i)
+		out << "#define M" << i << "(x) M" << i - 1 << "((x) + 1)\n";
+	out << "int f(int v)\n{\n\treturn M" << size << "(v);\n}\n";
+}
+
+// the source includes many headers
+static void GenerateIncludes(std::ostream& out, const std::string& name, unsigned int size, std::map<std::string, std::string>& headers)
+{
+	for (unsigned int i = 0; i < size; ++i) {
+		std::ostringstream header;
+		header << name << "_" << i << ".h";
+		std::ostringstream code;
+		code << "#ifndef H" << i << "\n#define H" << i << "\n"
+		     << "#define VALUE" << i << " " << i << "\n"
+		     << "struct S" << i << " {\n\tint a;\n\tint get() const { return a + VALUE" << i << "; }\n};\n"
+		     << "int h" << i << "(int x);\n#endif\n";
+		headers[header.str()] = code.str();
+		out << "#include \"" << header.str() << "\"\n";
+	}
+	out << "int f(int x)\n{\n\tS0 s;\n\ts.a = x;\n\treturn s.get() + h" << size - 1 << "(x);\n}\n";
+}
+
+// W<W<..W<int>..>> nested template arguments
+static void GenerateTemplateDepth(std::ostream& out, const std::string& /*name*/, unsigned int size, std::map<std::string, std::string>& /*headers*/)
+{
+	out << "template<class T> struct W {\n\tT t;\n\tT get() const { return t; }\n};\n";
+	out << "typedef ";
+	for (unsigned int i = 0; i < size; ++i)
+		out << "W<";
+	out << "int";
+	for (unsigned int i = 0; i < size; ++i)
+		out << " >";
+	out << " Deep;\nint f()\n{\n\tDeep d;\n\treturn sizeof(d);\n}\n";
+}
+
+// a large constant table
+static void GenerateInitializer(std::ostream& out, const std::string& /*name*/, unsigned int size, std::map<std::string, std::string>& /*headers*/)
+{
+	out << "static const int table[] = {";
+	for (unsigned int i = 0; i < size; ++i)
+		out << (i % 16 ? " " : "\n\t") << i << ",";
+	out << "\n};\nint f(int i)\n{\n\treturn table[i];\n}\n";
+}
+
+// functions with for (it = v.begin(); ..) { if (*it == 0) .. else if (*it == 1) .. } erasing in some branches
+static void GenerateEraseLoop(std::ostream& out, const std::string& /*name*/, unsigned int size, std::map<std::string, std::string>& /*headers*/)
+{
+	out << "#include <vector>\nvoid use(int);\n";
+	for (unsigned int f = 0; f < size; ++f) {
+		out << "void f" << f << "(std::vector<int>& v, int x)\n{\n";
+		out << "\tfor (std::vector<int>::iterator it = v.begin(); it != v.end(); ++it) {\n";
+		for (unsigned int i = 0; i < 16; ++i) {
+			out << (i ? "\t\telse if (*it == " : "\t\tif (*it == ") << i << ") {\n";
+			if ((f + i) % 3 == 0)
+				out << "\t\t\tif (x > " << i << ")\n\t\t\t\tv.erase(it);\n\t\t\telse\n\t\t\t\tuse(*it);\n";
+			else if ((f + i) % 3 == 1)
+				out << "\t\t\tuse(*it);\n";
+			else
+				out << "\t\t\tif (x == " << i << ") {\n\t\t\t\tv.erase(it);\n\t\t\t\tbreak;\n\t\t\t}\n";
+			out << "\t\t}\n";
+		}
+		out << "\t}\n}\n";
+	}
+}
+
+typedef void GenerateProc(std::ostream& out, const std::string& name, unsigned int size, std::map<std::string, std::string>& headers);
+
+struct SStressPattern
+{
+	const char* name;
+	GenerateProc* generate;
+	unsigned int baseSize;
+};
+
+static const SStressPattern s_patterns[] = {
+	{ "nesting", GenerateNesting, 4 },
+	{ "elseif", GenerateElseIf, 50 },
+	{ "locals", GenerateLocals, 50 },
+	{ "funclen", GenerateFunctionLength, 200 },
+	{ "ifdef", GenerateIfdefs, 20 },
+	{ "macro", GenerateMacroDepth, 8 },
+	{ "include", GenerateIncludes, 10 },
+	{ "template", GenerateTemplateDepth, 4 },
+	{ "initializer", GenerateInitializer, 1000 },
+	{ "eraseloop", GenerateEraseLoop, 50 }
+};
+
+static const SStressPattern* FindPattern(const std::string& name)
+{
+	for (std::size_t i = 0; i < sizeof(s_patterns) / sizeof(s_patterns[0]); ++i) {
+		if (name == s_patterns[i].name)
+			return &s_patterns[i];
+	}
+	return nullptr;
+}
+
+// least squares slope of log(work) over log(size), sizes without work are left out
+static double GrowthExponent(const std::vector<double>& sizes, const std::vector<double>& work)
+{
+	double sx = 0, sy = 0, sxx = 0, sxy = 0;
+	unsigned int n = 0;
+	for (std::size_t i = 0; i < sizes.size() && i < work.size(); ++i) {
+		if (work[i] <= 0)
+			continue;
+		const double x = std::log(sizes[i]);
+		const double y = std::log(work[i]);
+		sx += x;
+		sy += y;
+		sxx += x * x;
+		sxy += x * y;
+		++n;
+	}
+	if (n < 3)
+		return 0;
+	return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+TscStressTest::TscStressTest(const std::string& exe, const std::string& dir)
+	: m_exe(exe)
+	, m_dir(dir)
+{
+}
+
+bool TscStressTest::IsPattern(const std::string& name)
+{
+	return FindPattern(name) != nullptr;
+}
+
+std::string TscStressTest::PatternNames()
+{
+	std::string names;
+	for (std::size_t i = 0; i < sizeof(s_patterns) / sizeof(s_patterns[0]); ++i) {
+		if (i)
+			names += ", ";
+		names += s_patterns[i].name;
+	}
+	return names;
+}
+
+bool TscStressTest::Run(const std::vector<std::string>& patterns)
+{
+	bool bLinear = true;
+	if (patterns.empty()) {
+		for (std::size_t i = 0; i < sizeof(s_patterns) / sizeof(s_patterns[0]); ++i)
+			bLinear = RunPattern(s_patterns[i].name) && bLinear;
+	}
+	else {
+		for (std::size_t i = 0; i < patterns.size(); ++i)
+			bLinear = RunPattern(patterns[i]) && bLinear;
+	}
+	return bLinear;
+}
+
+bool TscStressTest::RunPattern(const std::string& name)
+{
+	const SStressPattern* pattern = FindPattern(name);
+	if (!pattern)
+		return false;
+
+	const std::string source = m_dir + "/" + name + ".cpp";
+	const std::string countsFile = m_dir + "/" + name + ".json";
+
+	std::vector<double> sizes;
+	std::map<std::string, std::vector<double> > phases;
+	for (unsigned int step = 0; step < STRESS_STEPS; ++step) {
+		const unsigned int size = pattern->baseSize << step;
+
+		std::ostringstream code;
+		std::map<std::string, std::string> headers;
+		pattern->generate(code, name, size, headers);
+		for (std::map<std::string, std::string>::const_iterator it = headers.begin(); it != headers.end(); ++it) {
+			std::ofstream fout((m_dir + "/" + it->first).c_str());
+			fout << it->second;
+		}
+		{
+			std::ofstream fout(source.c_str());
+			fout << code.str();
+		}
+
+		std::map<std::string, double> work;
+		if (!CheckInput(source, countsFile, work)) {
+			std::cout << "TscanCode: stress pattern '" << name << "' failed at size " << size << ", see " << source << std::endl;
+			return false;
+		}
+
+		sizes.push_back(size);
+		for (std::map<std::string, double>::const_iterator it = work.begin(); it != work.end(); ++it) {
+			std::vector<double>& phaseWork = phases[it->first];
+			phaseWork.resize(step, 0.0);
+			phaseWork.push_back(it->second);
+		}
+	}
+
+	std::ostringstream report;
+	report << std::fixed << std::setprecision(2);
+	bool bLinear = true;
+	for (std::map<std::string, std::vector<double> >::iterator it = phases.begin(); it != phases.end(); ++it) {
+		std::vector<double>& work = it->second;
+		work.resize(STRESS_STEPS, 0.0);
+		const double exponent = GrowthExponent(sizes, work);
+		if (it->first == "total" || (exponent >= SUPERLINEAR_EXPONENT && work.back() >= MIN_WORK)) {
+			report << "    " << it->first << ": exponent " << exponent
+			       << ", work " << (unsigned long long)work.front() << " -> " << (unsigned long long)work.back();
+			if (it->first != "total") {
+				report << " (superlinear)";
+				bLinear = false;
+			}
+			report << "\n";
+		}
+	}
+	std::cout << "Stress pattern '" << name << "', sizes " << sizes.front() << ".." << sizes.back() << ":\n" << report.str() << std::flush;
+	return bLinear;
+}
+
+bool TscStressTest::CheckInput(const std::string& source, const std::string& countsFile, std::map<std::string, double>& work) const
+{
+	std::remove(countsFile.c_str());
+	const std::string cmd = "\"" + m_exe + "\" -q --work-counters=\"" + countsFile + "\" \"" + source + "\"" NULL_REDIRECT;
+	if (std::system(cmd.c_str()) != 0)
+		return false;
+
+	std::ifstream fin(countsFile.c_str());
+	if (!fin.is_open())
+		return false;
+	std::map<std::string, std::map<std::string, unsigned long long> > counts;
+	WorkCounters::read(fin, counts);
+	for (std::map<std::string, std::map<std::string, unsigned long long> >::const_iterator phase = counts.begin(); phase != counts.end(); ++phase) {
+		double sum = 0;
+		for (std::map<std::string, unsigned long long>::const_iterator it = phase->second.begin(); it != phase->second.end(); ++it)
+			sum += (double)it->second;
+		work[phase->first] = sum;
+	}
+	return true;
+}
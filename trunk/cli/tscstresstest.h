@@ -0,0 +1,44 @@
+#ifndef TSCSTRESSTEST_H
+#define TSCSTRESSTEST_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+
+/// @addtogroup CLI
+/// @{
+
+/**
+ * Finds phases whose work grows superlinearly with the size of the input
+ * (--stress=<dir>).
+ *
+ * For every pattern, e.g. a long else-if chain, inputs of geometrically
+ * growing size are generated into <dir> and checked by a child tscancode
+ * process with --work-counters=. The growth exponent of every phase is
+ * fitted on a log-log scale and phases growing clearly faster than linear
+ * are reported with the pattern that triggers them.
+ */
+class TscStressTest {
+public:
+	TscStressTest(const std::string& exe, const std::string& dir);
+
+	// is @name a built-in pattern?
+	static bool IsPattern(const std::string& name);
+	// names of the built-in patterns, comma separated
+	static std::string PatternNames();
+
+	// run the given patterns, all if empty. returns false if a phase grows superlinearly
+	bool Run(const std::vector<std::string>& patterns);
+
+private:
+	bool RunPattern(const std::string& name);
+	bool CheckInput(const std::string& source, const std::string& countsFile, std::map<std::string, double>& work) const;
+
+	std::string m_exe;
+	std::string m_dir;
+};
+
+/// @}
+
+#endif // TSCSTRESSTEST_H
@@ -42,6 +42,8 @@ TscThreadExecutor::TscThreadExecutor(CFileDependTable* pFileTable, Settings &set
 	, _fileCount(0)
 	, _analyzeFile(false)
 	, _threadIndex(0)
+	, _summaryLevel(0)
+	, _summaryIndex(0)
 	, _processedFiles(0)
 	, _totalFiles(0)
 	, _processedSize(0)
@@ -95,6 +97,10 @@ unsigned int TscThreadExecutor::check(bool bAnalyze, bool bCheck)
 
     _analyzeFile = bAnalyze;
 	CGlobalTokenizer::Instance()->SetAnalyze(bAnalyze);
+	if (bAnalyze)
+	{
+		CGlobalTokenizer::Instance()->OpenSideOutputs();
+	}
 
 	_checkList.clear();
 	_processedFiles = 0;
@@ -102,10 +108,18 @@ unsigned int TscThreadExecutor::check(bool bAnalyze, bool bCheck)
 	_totalFiles = 0;
 	_totalFileSize = 0;
 
+	// --diff-scope: the global data is still analyzed in full, only the check pass is limited
+	std::set<CCodeFile*> affected;
+	const bool bDiffScope = !bAnalyze && !_settings._changedLines.empty();
+	if (bDiffScope)
+	{
+		collectChangedFiles(affected);
+	}
+
 	CCodeFile* pFile = _pFileTable->GetFirstFile();
 	while (pFile)
 	{
-		if (Path::acceptFile(pFile->GetFullPath()) && !pFile->GetIgnore())
+		if (Path::acceptFile(pFile->GetFullPath()) && !pFile->GetIgnore() && (!bDiffScope || affected.count(pFile)))
 		{
 			_checkList.push_back(pFile);
 			_totalFileSize += pFile->GetSize();
@@ -137,7 +151,7 @@ unsigned int TscThreadExecutor::check(bool bAnalyze, bool bCheck)
 	
 	while (pFile)
 	{
-		if (Path::isHeader(pFile->GetFullPath()) && !pFile->GetIgnore() && !pFile->IsExpaned())
+		if (Path::isHeader(pFile->GetFullPath()) && !pFile->GetIgnore() && !pFile->IsExpaned() && (!bDiffScope || affected.count(pFile)))
 		{
 			_checkList.push_back(pFile);
 			_totalFileSize += pFile->GetSize();
@@ -166,6 +180,11 @@ unsigned int TscThreadExecutor::check(bool bAnalyze, bool bCheck)
 			_pFileTable->DumpFileDependResults();
 		}
 		CGlobalTokenizer::Instance()->Merge(_settings.debugDumpGlobal);	
+		computeFuncSummaries();
+		if (_settings.debugDumpGlobal)
+		{
+			CGlobalTokenizer::Instance()->DumpMergedData();
+		}
 	}
 	else
 	{
@@ -187,6 +206,28 @@ unsigned int TscThreadExecutor::check(bool bAnalyze, bool bCheck)
 	return ret;
 }
 
+void TscThreadExecutor::collectChangedFiles(std::set<CCodeFile*>& affected)
+{
+	// changed files and everything including them, directly or through other headers
+	std::vector<CCodeFile*> pending;
+	for (CCodeFile* pFile = _pFileTable->GetFirstFile(); pFile; pFile = pFile->GetNext())
+	{
+		if (_settings._changedLines.isChanged(pFile->GetFullPath()) && affected.insert(pFile).second)
+			pending.push_back(pFile);
+	}
+	while (!pending.empty())
+	{
+		CCodeFile* pFile = pending.back();
+		pending.pop_back();
+		std::vector<CCodeFile*>& includers = pFile->GetBeDepends();
+		for (std::vector<CCodeFile*>::iterator I = includers.begin(), E = includers.end(); I != E; ++I)
+		{
+			if (affected.insert(*I).second)
+				pending.push_back(*I);
+		}
+	}
+}
+
 unsigned TscThreadExecutor::init()
 {
 	CheckTSCInvalidVarArgs::InitFuncMap();
@@ -269,6 +310,13 @@ void* TscThreadExecutor::threadProc(void *args)
 		std::list<std::string>& errorList = CGlobalErrorList::Instance()->GetThreadErrorList(&fileChecker);
 		TSC_LOCK_LEAVE(&threadExecutor->_fileSync);
 		fileChecker.SyncErrorList(errorList);
+
+		if (!threadExecutor->_settings._baselineOut.empty())
+		{
+			TSC_LOCK_ENTER(&threadExecutor->_fileSync);
+			fileChecker.SyncBaseline(threadExecutor->_settings._baseline);
+			TSC_LOCK_LEAVE(&threadExecutor->_fileSync);
+		}
 	}
 
     return NULL;
@@ -323,9 +371,61 @@ void* TscThreadExecutor::threadProc_initMacros(void *args)
 	return NULL;
 }
 
+#ifdef TSC_THREADING_MODEL_WIN
+unsigned int __stdcall TscThreadExecutor::threadProc_funcSummaries(void *args)
+#else
+void* TscThreadExecutor::threadProc_funcSummaries(void *args)
+#endif
+{
+	TscThreadExecutor *threadExecutor = static_cast<TscThreadExecutor*>(args);
+	gt::CCallGraph& callGraph = CGlobalTokenizer::Instance()->GetCallGraph();
+	const std::size_t level = threadExecutor->_summaryLevel;
+	const std::size_t count = callGraph.GetComponentCount(level);
+
+	for (;;) {
+		TSC_LOCK_ENTER(&threadExecutor->_fileSync);
+		const std::size_t index = threadExecutor->_summaryIndex++;
+		TSC_LOCK_LEAVE(&threadExecutor->_fileSync);
+
+		if (index >= count)
+			break;
+
+		callGraph.SolveComponent(level, index);
+	}
+	return NULL;
+}
+
+// components of one level only read summaries of lower levels,
+// so the levels are solved bottom-up and each level in parallel
+void TscThreadExecutor::computeFuncSummaries()
+{
+	// thread startup is not worth it for the narrow levels
+	static const std::size_t MIN_PARALLEL_COMPONENTS = 256;
+
+	gt::CCallGraph& callGraph = CGlobalTokenizer::Instance()->GetCallGraph();
+	for (_summaryLevel = 0; _summaryLevel < callGraph.GetLevelCount(); ++_summaryLevel)
+	{
+		const std::size_t count = callGraph.GetComponentCount(_summaryLevel);
+		_summaryIndex = 0;
+		if (_settings._jobs > 1 && count >= MIN_PARALLEL_COMPONENTS)
+		{
+			multi_thread(TscThreadExecutor::threadProc_funcSummaries);
+		}
+		else
+		{
+			for (; _summaryIndex < count; ++_summaryIndex)
+			{
+				callGraph.SolveComponent(_summaryLevel, _summaryIndex);
+			}
+		}
+	}
+	callGraph.Clear();
+}
+
 unsigned int TscThreadExecutor::initMacros()
 {
 	CGlobalMacros::SetFileTable(_pFileTable);
+	CGlobalMacros::SetMemoryBudget((std::size_t)_settings._memoryBudget << 20);
 	_curFile = _pFileTable->GetFirstFile();
 
 	_processedFiles = 0;
@@ -341,11 +441,20 @@ unsigned int TscThreadExecutor::initMacros()
 		pFile = pFile->GetNext();
 	}
 
+	// each worker moves the macros and typedefs of its file into the file's own slot
+	CGlobalMacros::InitSlots(CFileBase::GetIDCount());
+	CGlobalTypedefs::InitSlots(CFileBase::GetIDCount());
 	TSC_LOCK_INIT(&CGlobalMacros::MacroLock);
-	TSC_LOCK_INIT(&CGlobalTypedefs::TypedefLock);
 
 	unsigned ret = multi_thread(TscThreadExecutor::threadProc_initMacros);
 
+	CGlobalMacros::MapSpilledMacros();
+	CGlobalTypedefs::BuildVisibleTypedefs(_pFileTable);
+	if (!_settings.quiet)
+	{
+		CGlobalMacros::reportSpill();
+	}
+
 	if (_settings.debugDumpGlobal)
 	{
 		CGlobalMacros::DumpMacros();
@@ -353,7 +462,6 @@ unsigned int TscThreadExecutor::initMacros()
 	}
 	
 	TSC_LOCK_DELETE(&CGlobalMacros::MacroLock);
-	TSC_LOCK_DELETE(&CGlobalTypedefs::TypedefLock);
 
 	return ret;
 }
@@ -40,6 +40,7 @@ public:
 
 	unsigned init();
 	unsigned int initMacros();
+	void computeFuncSummaries();
 
     virtual void reportOut(const std::string &outmsg);
     virtual void reportErr(const ErrorLogger::ErrorMessage &msg);
@@ -56,6 +57,7 @@ public:
 
 private:
 	unsigned int multi_thread(ThreadProc threadProc);
+	void collectChangedFiles(std::set<CCodeFile*>& affected);
 private:
 	CFileDependTable* _pFileTable;
 	std::list<CCodeFile*> _checkList;
@@ -79,6 +81,9 @@ private:
     std::list<std::string> _errorList;
 	int _threadIndex;
 
+	std::size_t _summaryLevel;
+	std::size_t _summaryIndex;
+
     void report(const ErrorLogger::ErrorMessage &msg, MessageType msgType);
     
     TSC_LOCK	 _errorSync;
@@ -89,11 +94,13 @@ private:
 
     static unsigned __stdcall threadProc(void*);
 	static unsigned __stdcall threadProc_initMacros(void*);
+	static unsigned __stdcall threadProc_funcSummaries(void*);
     
 #else
     
 	static void* threadProc(void*);
 	static void* threadProc_initMacros(void*);
+	static void* threadProc_funcSummaries(void*);
 
 #endif
 
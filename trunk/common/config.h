@@ -89,5 +89,11 @@ static const std::string emptyString;
 #define SNPRINTF	snprintf
 #endif
 
+#if defined(_MSC_VER)
+#define TSC_THREAD_LOCAL	__declspec(thread)
+#else
+#define TSC_THREAD_LOCAL	__thread
+#endif
+
 
 #endif // configH
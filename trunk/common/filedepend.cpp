@@ -29,6 +29,7 @@
 #include "filedepend.h"
 #include "path.h"
 #include "filelister.h"
+#include "sourcebundle.h"
 
 unsigned int CFileBase::s_id = 0;
 
@@ -169,6 +170,9 @@ bool CFileDependTable::BuildTable(CFolder* pParent, const std::string& sPath, fp
 
 std::size_t CFileDependTable::GetFileSize(const std::string& sPath)
 {
+	if (CSourceBundle::IsLoaded())
+		return CSourceBundle::GetFileSize(sPath);
+
 	WIN32_FIND_DATAA ffd;
 	HANDLE hFind = FindFirstFileA(Path::toNativeSeparators(sPath).c_str(), &ffd);
 	if (INVALID_HANDLE_VALUE == hFind)
@@ -179,6 +183,8 @@ std::size_t CFileDependTable::GetFileSize(const std::string& sPath)
 
 std::string CFileDependTable::getAbsolutePath(const std::string& path)
 {
+	if (CSourceBundle::IsLoaded())
+		return CSourceBundle::GetAbsolutePath(path);
 	return path;
 }
 #else
@@ -186,6 +192,9 @@ std::string CFileDependTable::getAbsolutePath(const std::string& path)
 // Get absolute path. Returns empty string if path does not exist or other error.
 std::string CFileDependTable::getAbsolutePath(const std::string& path)
 {
+	if (CSourceBundle::IsLoaded())
+		return CSourceBundle::GetAbsolutePath(path);
+
 	std::string absolute_path;
 
 #ifdef PATH_MAX
@@ -313,6 +322,9 @@ bool CFileDependTable::BuildTable(CFolder* pParent, const std::string& sPath, fp
 
 std::size_t CFileDependTable::GetFileSize(const std::string& sPath)
 {
+	if (CSourceBundle::IsLoaded())
+		return CSourceBundle::GetFileSize(sPath);
+
 	struct stat sb;
 	std::size_t fileSize = 0;
 	if (stat(sPath.c_str(), &sb) == 0) 
@@ -325,6 +337,75 @@ std::size_t CFileDependTable::GetFileSize(const std::string& sPath)
 
 #endif
 
+bool CFileDependTable::BuildBundleTable(CFolder* pParent, const std::string& sPath, fp_fileFilter fp)
+{
+	assert(pParent != NULL);
+	bool bCheckExists = (pParent->GetSubs().size() > 0);
+
+	std::vector<std::string> entries;
+	CSourceBundle::ListFolder(sPath, entries);
+	for (std::vector<std::string>::const_iterator iter = entries.begin(); iter != entries.end(); ++iter)
+	{
+		std::string sFileName = *iter;
+		if (sFileName[sFileName.length()-1] != '/')
+		{
+			// File
+			if (!(*fp)(sFileName))
+				continue;
+
+			std::size_t fileSize = CSourceBundle::GetFileSize(sPath + "/" + sFileName);
+			CCodeFile* pFile = NULL;
+			bool bNew = true;
+			if (bCheckExists)
+			{
+				pFile = pParent->AddCodeFile(sFileName, fileSize, bNew);
+			}
+			else
+			{
+				pFile = new CCodeFile(sFileName.c_str(), fileSize);
+				pParent->AddFile(pFile);
+			}
+
+			if (bNew)
+			{
+				if (!m_begin)
+				{
+					m_begin = pFile;
+				}
+				else
+				{
+					m_flag->SetNext(pFile);
+				}
+				m_flag = pFile;
+
+				std::pair<std::string, CCodeFile*> newPair(std::string(sFileName), pFile);
+				m_fileDict.insert(newPair);
+			}
+		}
+		else
+		{
+			// Directory
+			sFileName = sFileName.substr(0, sFileName.length() - 1);
+			bool bNew = true;
+			CFolder* pFolder = NULL;
+			if (bCheckExists)
+			{
+				pFolder = pParent->AddFolder(sFileName, bNew);
+			}
+			else
+			{
+				pFolder = new CFolder(sFileName.c_str());
+				pParent->AddFile(pFolder);
+			}
+
+			if (!BuildBundleTable(pFolder, sPath + "/" + sFileName, fp))
+				return false;
+		}
+	}
+
+	return true;
+}
+
 void CFileDependTable::ReleaseTable()
 {
 	if (m_pRoot)
@@ -391,7 +472,9 @@ unsigned char CFileDependTable::ReadChar(std::istream &istr, unsigned int bom)
 
 void CFileDependTable::GetIncludes(const std::string &fileName, std::vector<std::string> &strIncludes)
 {
-	std::ifstream istr(fileName.c_str());
+	CSourceFile file;
+	file.Open(fileName);
+	std::istream &istr = file.Stream();
 	if (!istr.good())
 		return;
 
@@ -733,6 +816,9 @@ CCodeFile* CFileDependTable::GetFirstFile()
 CFileBase* CFileDependTable::FindFile(const std::string& filePath)
 {
 	CFolder* pFolder = m_pRoot;
+	// nothing was created, e.g. the code is not part of a project
+	if (!pFolder)
+		return NULL;
 	std::string sPath = Path::fromNativeSeparators(filePath);
 	// remove last '/' if exists
 	if (*sPath.rbegin() == '/')
@@ -774,8 +860,8 @@ bool CFileDependTable::BuildFileDependTree(std::string &sPath, fp_fileFilter fp)
 		sPath = sPath.substr(0, sPath.size() - 1);
 	}
 	std::string sNative = Path::toNativeSeparators(sPath);
-	bool bDir = FileLister::isDirectory(sNative);
-	if (!bDir && (!FileLister::fileExists(sPath) || !(*fp)(sPath)))
+	bool bDir = CSourceBundle::IsDirectory(sNative);
+	if (!bDir && (!CSourceBundle::FileExists(sPath) || !(*fp)(sPath)))
 		return true;
 
 	bool bNew = false;
@@ -798,7 +884,7 @@ bool CFileDependTable::BuildFileDependTree(std::string &sPath, fp_fileFilter fp)
 	{
 		pFolder = pFolder->AddFolder(entry.c_str(), bNew);
 
-		bool bRet = BuildTable(pFolder, sPath.c_str(), fp);
+		bool bRet = CSourceBundle::IsLoaded() ? BuildBundleTable(pFolder, sPath, fp) : BuildTable(pFolder, sPath.c_str(), fp);
 		if (!bRet)
 		{
 			ReleaseTable();
@@ -921,7 +1007,8 @@ std::string CFileBase::GetFullPath()
 {
 	std::string sFullPath = GetName();
 	CFileBase* pFile = GetParent();
-	while (pFile && pFile->GetName() != "root")
+	// stop at the root folder of the tree, a folder of the path may be named "root" too
+	while (pFile && pFile->GetParent())
 	{
 		sFullPath = pFile->GetName() + "/" + sFullPath;
 		pFile = pFile->GetParent();
@@ -1099,7 +1186,10 @@ CCodeFile* CCodeFile::GetNext()
 void CCodeFile::AddDependFile(CCodeFile* pFile)
 {
 	if (pFile)
+	{
 		m_depends.push_back(pFile);
+		pFile->m_beDepends.push_back(this);
+	}
 }
 
 std::vector<CCodeFile*>& CCodeFile::GetDepends()
@@ -1107,6 +1197,11 @@ std::vector<CCodeFile*>& CCodeFile::GetDepends()
 	return m_depends;
 }
 
+std::vector<CCodeFile*>& CCodeFile::GetBeDepends()
+{
+	return m_beDepends;
+}
+
 std::size_t CCodeFile::GetSize() const
 {
 	return m_size;
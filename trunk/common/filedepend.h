@@ -38,6 +38,8 @@ private:
 
 	void UpdateIncludes(const std::vector<std::string>& includePaths);
 	bool BuildTable(CFolder* pRoot, const std::string& sPath, fp_fileFilter fp);
+	// BuildTable() for the loaded source bundle
+	bool BuildBundleTable(CFolder* pRoot, const std::string& sPath, fp_fileFilter fp);
 	void ReleaseTable();
 
 	static unsigned char ReadChar(std::istream &istr, unsigned int bom);
@@ -76,6 +78,9 @@ public:
 
 	virtual void SetIgnore(bool ignore) { m_bIgnore = ignore; }
 	bool GetIgnore() const { return m_bIgnore; }
+	unsigned int GetID() const { return m_uID; }
+	// ids are below this count
+	static unsigned int GetIDCount() { return s_id; }
 	virtual ~CFileBase();
 protected:
 	CFileBase();
@@ -128,6 +133,8 @@ public:
 
 	void AddDependFile(CCodeFile* pFile);
 	std::vector<CCodeFile*>& GetDepends();
+	// files including this file directly
+	std::vector<CCodeFile*>& GetBeDepends();
 
 	
 	std::list<CCodeFile*>& GetAllDepends();
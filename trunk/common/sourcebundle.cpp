@@ -0,0 +1,443 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sourcebundle.h"
+#include "filedepend.h"
+#include "filelister.h"
+#include "path.h"
+
+#include <cstdlib>
+#include <cstring>
+
+CSourceBundle* CSourceBundle::s_pBundle = NULL;
+
+static const char* const BUNDLE_MAGIC = "TSCBUNDLE 1";
+
+static bool IsAbsolutePath(const std::string& sPath)
+{
+	return (!sPath.empty() && sPath[0] == '/') || (sPath.size() > 1 && sPath[1] == ':');
+}
+
+static bool ReadWholeFile(const std::string& sPath, std::string& content)
+{
+	std::ifstream fin(sPath.c_str(), std::ios::in | std::ios::binary);
+	if (!fin.is_open())
+		return false;
+	fin.seekg(0, std::ios::end);
+	const std::streamoff size = fin.tellg();
+	if (size < 0)
+		return false;
+	content.resize(static_cast<std::size_t>(size));
+	fin.seekg(0, std::ios::beg);
+	if (size > 0)
+		fin.read(&content[0], size);
+	return !fin.bad();
+}
+
+// lexical absolute path, relative paths are taken relative to @sCwd
+static std::string MakeAbsolute(const std::string& sPath, const std::string& sCwd)
+{
+	std::string sAbsolute = Path::fromNativeSeparators(Path::removeQuotationMarks(sPath));
+	if (!IsAbsolutePath(sAbsolute))
+		sAbsolute = sCwd + "/" + sAbsolute;
+	sAbsolute = Path::simplifyPath(sAbsolute);
+	if (sAbsolute.size() > 1 && *sAbsolute.rbegin() == '/')
+		sAbsolute.erase(sAbsolute.size() - 1);
+	return sAbsolute;
+}
+
+// the #include lines of @code, true in the pair for "file.h", false for <file.h>
+static void ScanIncludes(const std::string& code, std::vector<std::pair<std::string, bool> >& includes)
+{
+	std::string::size_type pos = 0;
+	while (pos < code.size())
+	{
+		std::string::size_type end = code.find('\n', pos);
+		if (end == std::string::npos)
+			end = code.size();
+
+		std::string::size_type i = pos;
+		while (i < end && (code[i] == ' ' || code[i] == '\t'))
+			++i;
+		if (i < end && code[i] == '#')
+		{
+			++i;
+			while (i < end && (code[i] == ' ' || code[i] == '\t'))
+				++i;
+			if (code.compare(i, 7, "include") == 0)
+			{
+				i += 7;
+				while (i < end && (code[i] == ' ' || code[i] == '\t'))
+					++i;
+				if (i < end && (code[i] == '"' || code[i] == '<'))
+				{
+					const char close = (code[i] == '"') ? '"' : '>';
+					const std::string::size_type nameEnd = code.find(close, i + 1);
+					if (nameEnd != std::string::npos && nameEnd < end && nameEnd > i + 1)
+						includes.push_back(std::make_pair(code.substr(i + 1, nameEnd - i - 1), close == '"'));
+				}
+			}
+		}
+		pos = end + 1;
+	}
+}
+
+// first existing header in the order the preprocessor probes (see openHeader())
+static bool FindHeader(const std::string& sName, const std::string& sDir, const std::vector<std::string>& includePaths, std::string& sFound)
+{
+	std::vector<std::string> candidates;
+	if (!sDir.empty())
+		candidates.push_back(sDir + sName);
+	candidates.push_back(sName);
+	for (std::vector<std::string>::const_iterator iter = includePaths.begin(); iter != includePaths.end(); ++iter)
+		candidates.push_back(*iter + sName);
+
+	for (std::vector<std::string>::const_iterator iter = candidates.begin(); iter != candidates.end(); ++iter)
+	{
+		const std::string sNative = Path::toNativeSeparators(*iter);
+		if (FileLister::fileExists(sNative) && !FileLister::isDirectory(sNative))
+		{
+			sFound = *iter;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool CSourceBundle::Pack(const std::string& sBundle,
+	const std::vector<std::string>& paths,
+	const std::vector<std::string>& includePaths,
+	const std::list<std::string>& userIncludes,
+	std::string& sMessage)
+{
+	// the same tree the check builds, without excluded paths: excluded files may still be included
+	CFileDependTable table;
+	if (!table.Create(paths, std::vector<std::string>(), includePaths))
+	{
+		sMessage = "could not find or open any of the paths given.";
+		return false;
+	}
+
+	const std::string sCwd = Path::fromNativeSeparators(Path::getAbsoluteFilePath("."));
+
+	std::map<std::string, std::string> aliases;
+	std::set<std::string> folders;
+	std::vector<std::string> givenPaths(paths);
+	givenPaths.insert(givenPaths.end(), includePaths.begin(), includePaths.end());
+	for (std::vector<std::string>::const_iterator iter = givenPaths.begin(); iter != givenPaths.end(); ++iter)
+	{
+		const std::string sReal = Path::fromNativeSeparators(Path::getAbsoluteFilePath(Path::toNativeSeparators(*iter)));
+		if (sReal.empty())
+			continue;
+		const std::string sLexical = MakeAbsolute(*iter, sCwd);
+		if (sLexical != sReal)
+			aliases[sLexical] = sReal;
+		if (FileLister::isDirectory(Path::toNativeSeparators(*iter)))
+			folders.insert(sReal);
+	}
+
+	std::vector<std::string> pending;
+	for (CCodeFile* pFile = table.GetFirstFile(); pFile; pFile = pFile->GetNext())
+		pending.push_back(pFile->GetFullPath());
+	pending.insert(pending.end(), userIncludes.begin(), userIncludes.end());
+
+	// absolute path -> content, headers found through includes are added while packing
+	std::map<std::string, std::string> files;
+	while (!pending.empty())
+	{
+		const std::string sPath = pending.back();
+		pending.pop_back();
+
+		const std::string sKey = MakeAbsolute(sPath, sCwd);
+		if (files.find(sKey) != files.end())
+			continue;
+		std::string& content = files[sKey];
+		if (!ReadWholeFile(Path::toNativeSeparators(sPath), content))
+		{
+			files.erase(sKey);
+			continue;
+		}
+
+		std::vector<std::pair<std::string, bool> > includes;
+		ScanIncludes(content, includes);
+		const std::string sDir = Path::getPathFromFilename(sKey);
+		for (std::vector<std::pair<std::string, bool> >::const_iterator iter = includes.begin(); iter != includes.end(); ++iter)
+		{
+			const std::string sName = Path::fromNativeSeparators(iter->first);
+			const std::string sIncluderDir = iter->second ? sDir : std::string();
+			std::string sFound;
+			if (!FindHeader(sName, sIncluderDir, includePaths, sFound))
+			{
+				// the preprocessor retries with the file name only
+				const std::string::size_type slash = sName.find_last_of('/');
+				if (slash == std::string::npos || !FindHeader(sName.substr(slash + 1), sIncluderDir, includePaths, sFound))
+					continue;
+			}
+			if (files.find(MakeAbsolute(sFound, sCwd)) == files.end())
+				pending.push_back(sFound);
+		}
+	}
+
+	std::ofstream fout(sBundle.c_str(), std::ios::out | std::ios::binary);
+	if (!fout.is_open())
+	{
+		sMessage = "can not write '" + sBundle + "'.";
+		return false;
+	}
+
+	fout << BUNDLE_MAGIC << '\n';
+	fout << "cwd " << sCwd << '\n';
+	for (std::map<std::string, std::string>::const_iterator iter = aliases.begin(); iter != aliases.end(); ++iter)
+		fout << "alias " << iter->first << '\t' << iter->second << '\n';
+	for (std::set<std::string>::const_iterator iter = folders.begin(); iter != folders.end(); ++iter)
+		fout << "folder " << *iter << '\n';
+	std::size_t uTotal = 0;
+	for (std::map<std::string, std::string>::const_iterator iter = files.begin(); iter != files.end(); ++iter)
+	{
+		fout << "file " << iter->second.size() << ' ' << iter->first << '\n';
+		uTotal += iter->second.size();
+	}
+	fout << "end\n";
+	for (std::map<std::string, std::string>::const_iterator iter = files.begin(); iter != files.end(); ++iter)
+		fout.write(iter->second.data(), iter->second.size());
+	fout.close();
+	if (!fout)
+	{
+		sMessage = "can not write '" + sBundle + "'.";
+		return false;
+	}
+
+	std::ostringstream oss;
+	oss << "packed " << files.size() << " files (" << uTotal << " bytes) into '" << sBundle << "'.";
+	sMessage = oss.str();
+	return true;
+}
+
+bool CSourceBundle::Load(const std::string& sBundle, std::string& sError)
+{
+	CSourceBundle* pBundle = new CSourceBundle;
+	if (!ReadWholeFile(sBundle, pBundle->m_data))
+	{
+		delete pBundle;
+		sError = "can not read '" + sBundle + "'.";
+		return false;
+	}
+
+	const std::string& data = pBundle->m_data;
+	std::string::size_type pos = 0;
+	std::size_t uOffset = 0;
+	bool bEnd = false;
+	bool bFirst = true;
+	while (!bEnd && pos < data.size())
+	{
+		const std::string::size_type eol = data.find('\n', pos);
+		if (eol == std::string::npos)
+			break;
+		const std::string line = data.substr(pos, eol - pos);
+		pos = eol + 1;
+
+		if (bFirst)
+		{
+			if (line != BUNDLE_MAGIC)
+				break;
+			bFirst = false;
+		}
+		else if (line == "end")
+			bEnd = true;
+		else if (line.compare(0, 4, "cwd ") == 0)
+			pBundle->m_sCwd = line.substr(4);
+		else if (line.compare(0, 6, "alias ") == 0)
+		{
+			const std::string::size_type tab = line.find('\t', 6);
+			if (tab != std::string::npos)
+				pBundle->m_aliases[line.substr(6, tab - 6)] = line.substr(tab + 1);
+		}
+		else if (line.compare(0, 7, "folder ") == 0)
+			pBundle->AddEntry(line.substr(7), true);
+		else if (line.compare(0, 5, "file ") == 0)
+		{
+			const std::string::size_type space = line.find(' ', 5);
+			if (space == std::string::npos)
+				break;
+			SFile file;
+			file.uOffset = uOffset;
+			file.uSize = static_cast<std::size_t>(std::strtoul(line.substr(5, space - 5).c_str(), NULL, 10));
+			uOffset += file.uSize;
+			const std::string sPath = line.substr(space + 1);
+			pBundle->m_files[sPath] = file;
+			pBundle->AddEntry(sPath, false);
+		}
+	}
+
+	if (!bEnd || pos + uOffset != data.size())
+	{
+		delete pBundle;
+		sError = "'" + sBundle + "' is not a bundle written by --pack-bundle=.";
+		return false;
+	}
+
+	// the offsets become offsets into m_data
+	for (std::map<std::string, SFile>::iterator iter = pBundle->m_files.begin(); iter != pBundle->m_files.end(); ++iter)
+		iter->second.uOffset += pos;
+
+	Unload();
+	s_pBundle = pBundle;
+	return true;
+}
+
+void CSourceBundle::Unload()
+{
+	delete s_pBundle;
+	s_pBundle = NULL;
+}
+
+void CSourceBundle::AddEntry(const std::string& sPath, bool bFolder)
+{
+	std::string sEntry = sPath;
+	if (bFolder)
+		m_folders[sEntry];
+	// register the entry in all parent folders
+	for (std::string::size_type slash = sEntry.rfind('/'); slash != std::string::npos; slash = sEntry.rfind('/'))
+	{
+		const std::string sParent = sEntry.substr(0, slash);
+		std::set<std::string>& entries = m_folders[sParent];
+		const std::string sName = sEntry.substr(slash + 1) + (bFolder ? "/" : "");
+		if (!entries.insert(sName).second)
+			break;
+		sEntry = sParent;
+		bFolder = true;
+	}
+}
+
+std::string CSourceBundle::Normalize(const std::string& sPath) const
+{
+	std::string sAbsolute = MakeAbsolute(sPath, m_sCwd);
+	for (std::map<std::string, std::string>::const_iterator iter = m_aliases.begin(); iter != m_aliases.end(); ++iter)
+	{
+		const std::string& sAlias = iter->first;
+		if (sAbsolute.compare(0, sAlias.size(), sAlias) == 0 &&
+			(sAbsolute.size() == sAlias.size() || sAbsolute[sAlias.size()] == '/'))
+		{
+			return iter->second + sAbsolute.substr(sAlias.size());
+		}
+	}
+	return sAbsolute;
+}
+
+const CSourceBundle::SFile* CSourceBundle::FindFile(const std::string& sPath) const
+{
+	std::map<std::string, SFile>::const_iterator iter = m_files.find(Normalize(sPath));
+	return (iter != m_files.end()) ? &iter->second : NULL;
+}
+
+bool CSourceBundle::FileExists(const std::string& sPath)
+{
+	if (!s_pBundle)
+		return FileLister::fileExists(sPath);
+	return s_pBundle->FindFile(sPath) != NULL || IsDirectory(sPath);
+}
+
+bool CSourceBundle::IsDirectory(const std::string& sPath)
+{
+	if (!s_pBundle)
+		return FileLister::isDirectory(sPath);
+	return s_pBundle->m_folders.count(s_pBundle->Normalize(sPath)) != 0;
+}
+
+std::size_t CSourceBundle::GetFileSize(const std::string& sPath)
+{
+	const SFile* pFile = s_pBundle ? s_pBundle->FindFile(sPath) : NULL;
+	return pFile ? pFile->uSize : 0;
+}
+
+std::string CSourceBundle::GetAbsolutePath(const std::string& sPath)
+{
+	if (!s_pBundle)
+		return std::string();
+	const std::string sAbsolute = s_pBundle->Normalize(sPath);
+	if (s_pBundle->m_files.count(sAbsolute) || s_pBundle->m_folders.count(sAbsolute))
+		return sAbsolute;
+	return std::string();
+}
+
+void CSourceBundle::ListFolder(const std::string& sPath, std::vector<std::string>& entries)
+{
+	entries.clear();
+	if (!s_pBundle)
+		return;
+	std::map<std::string, std::set<std::string> >::const_iterator iter = s_pBundle->m_folders.find(s_pBundle->Normalize(sPath));
+	if (iter == s_pBundle->m_folders.end())
+		return;
+	// std::set sorts like glob() in the "C" locale, the '/' of folders included
+	for (std::set<std::string>::const_iterator entry = iter->second.begin(); entry != iter->second.end(); ++entry)
+	{
+		// glob() does not list hidden files
+		if ((*entry)[0] != '.')
+			entries.push_back(*entry);
+	}
+}
+
+bool CSourceBundle::GetFile(const std::string& sPath, const char*& pData, std::size_t& uSize)
+{
+	const SFile* pFile = s_pBundle ? s_pBundle->FindFile(sPath) : NULL;
+	if (!pFile)
+		return false;
+	pData = s_pBundle->m_data.data() + pFile->uOffset;
+	uSize = pFile->uSize;
+	return true;
+}
+
+bool CSourceFile::Open(const std::string& sPath)
+{
+	Close();
+	if (CSourceBundle::IsLoaded())
+	{
+		const char* pData = NULL;
+		std::size_t uSize = 0;
+		m_bBundled = true;
+		if (CSourceBundle::GetFile(sPath, pData, uSize))
+		{
+			m_bundled.str(std::string(pData, uSize));
+			m_bOpen = true;
+		}
+	}
+	else
+	{
+		m_file.open(sPath.c_str());
+		m_bOpen = m_file.is_open();
+	}
+	return m_bOpen;
+}
+
+void CSourceFile::Close()
+{
+	if (m_file.is_open())
+		m_file.close();
+	m_file.clear();
+	m_bundled.str(std::string());
+	m_bundled.clear();
+	m_bBundled = false;
+	m_bOpen = false;
+}
+
+std::istream& CSourceFile::Stream()
+{
+	if (m_bBundled && m_bOpen)
+		return m_bundled;
+	return m_file;
+}
@@ -0,0 +1,103 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <set>
+#include <fstream>
+#include <sstream>
+
+// The analysis input (sources, headers of the include paths and the headers
+// they include) packed into one local file with --pack-bundle=. After Load()
+// the input files, existence checks and folder listings are answered from
+// the bundle instead of the disk. The original paths are kept, so the
+// reports do not change.
+class CSourceBundle
+{
+public:
+	// pack the trees of @paths and @includePaths, @userIncludes and the
+	// headers included by them into @sBundle
+	static bool Pack(const std::string& sBundle,
+		const std::vector<std::string>& paths,
+		const std::vector<std::string>& includePaths,
+		const std::list<std::string>& userIncludes,
+		std::string& sMessage);
+
+	// read @sBundle, the input is read from it from now on
+	static bool Load(const std::string& sBundle, std::string& sError);
+	static void Unload();
+	static bool IsLoaded() { return s_pBundle != NULL; }
+
+	// answered from the loaded bundle, or from the disk if none is loaded
+	static bool FileExists(const std::string& sPath);
+	static bool IsDirectory(const std::string& sPath);
+
+	// only valid if a bundle is loaded
+	static std::size_t GetFileSize(const std::string& sPath);
+	// absolute path of a file or folder of the bundle, empty if it is not in the bundle
+	static std::string GetAbsolutePath(const std::string& sPath);
+	// entries of a folder sorted like glob(), sub folders end with '/'
+	static void ListFolder(const std::string& sPath, std::vector<std::string>& entries);
+	static bool GetFile(const std::string& sPath, const char*& pData, std::size_t& uSize);
+
+private:
+	struct SFile
+	{
+		std::size_t uOffset;
+		std::size_t uSize;
+	};
+
+	CSourceBundle() {}
+
+	std::string Normalize(const std::string& sPath) const;
+	void AddEntry(const std::string& sPath, bool bFolder);
+	const SFile* FindFile(const std::string& sPath) const;
+
+	static CSourceBundle* s_pBundle;
+
+	// all file contents, the index points into it
+	std::string m_data;
+	// directory the bundle was packed in, relative paths are relative to it
+	std::string m_sCwd;
+	// given paths that are symbolic links -> their real path
+	std::map<std::string, std::string> m_aliases;
+	std::map<std::string, SFile> m_files;
+	std::map<std::string, std::set<std::string> > m_folders;
+};
+
+// an input file opened from the loaded bundle or from the disk
+class CSourceFile
+{
+public:
+	CSourceFile() : m_bBundled(false), m_bOpen(false) {}
+
+	bool Open(const std::string& sPath);
+	bool IsOpen() const { return m_bOpen; }
+	void Close();
+	std::istream& Stream();
+
+private:
+	std::ifstream m_file;
+	std::istringstream m_bundled;
+	bool m_bBundled;
+	bool m_bOpen;
+};
@@ -0,0 +1,172 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "baseline.h"
+#include "incremental.h"
+#include "path.h"
+#include "sourcebundle.h"
+
+#include <cctype>
+#include <iomanip>
+
+static const char baselineHeader[] = "TSCBASELINE 1";
+
+static bool isNameChar(char c)
+{
+    return std::isalnum((unsigned char)c) || c == '_' || c == '$';
+}
+
+static bool readHex(const std::string &str, Baseline::Fingerprint &value)
+{
+    if (str.empty() || str.size() > 16)
+        return false;
+    value = 0;
+    for (std::string::size_type pos = 0; pos < str.size(); ++pos) {
+        const char c = str[pos];
+        unsigned int digit;
+        if (c >= '0' && c <= '9')
+            digit = (unsigned int)(c - '0');
+        else if (c >= 'a' && c <= 'f')
+            digit = (unsigned int)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F')
+            digit = (unsigned int)(c - 'A' + 10);
+        else
+            return false;
+        value = (value << 4) | digit;
+    }
+    return true;
+}
+
+std::string Baseline::parseFile(std::istream &istr)
+{
+    std::string line;
+    bool header = false;
+    while (std::getline(istr, line)) {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        // Skip empty lines and comments
+        if (line.empty() || line[0] == '#')
+            continue;
+        if (!header) {
+            if (line != baselineHeader)
+                return "TscanCode: Failed to read baseline, it was not written by '--baseline-out='.";
+            header = true;
+            continue;
+        }
+        Fingerprint fingerprint;
+        if (!readHex(line, fingerprint))
+            return "TscanCode: Failed to parse baseline fingerprint: \"" + line + "\"";
+        _known.insert(fingerprint);
+    }
+    return "";
+}
+
+void Baseline::write(std::ostream &ostr) const
+{
+    ostr << baselineHeader << '\n';
+    ostr << std::hex << std::setfill('0');
+    for (std::set<Fingerprint>::const_iterator it = _findings.begin(); it != _findings.end(); ++it)
+        ostr << std::setw(16) << *it << '\n';
+    ostr << std::dec;
+}
+
+Baseline::Fingerprint Baseline::fingerprint(const ErrorLogger::ErrorMessage &msg, LineHashes &lineHashes)
+{
+    std::string file;
+    unsigned int line(0);
+    if (!msg._callStack.empty()) {
+        file = msg._callStack.back().getfile(false);
+        line = msg._callStack.back().line;
+    }
+
+    // the source line instead of its number, so that the fingerprint survives edits above it
+    unsigned long long context = 0;
+    if (!file.empty() && line > 0) {
+        LineHashes::iterator it = lineHashes.find(file);
+        if (it == lineHashes.end()) {
+            it = lineHashes.insert(std::make_pair(file, std::vector<unsigned long long>())).first;
+            CSourceFile fin;
+            if (fin.Open(file))
+                hashLines(fin.Stream(), it->second);
+        }
+        if (line <= it->second.size())
+            context = it->second[line - 1];
+    }
+
+    std::string path = Path::simplifyPath(Path::fromNativeSeparators(file));
+    while (path.compare(0, 2, "./") == 0)
+        path.erase(0, 2);
+
+    CFingerprint hash;
+    hash.Add(ErrorType::ToString(msg._type));
+    hash.Add(msg._id);
+    hash.Add(path);
+    hash.Add(msg._funcinfo);
+    hash.Add(context);
+    return hash.Value();
+}
+
+void Baseline::hashLines(std::istream &istr, std::vector<unsigned long long> &hashes)
+{
+    hashes.clear();
+    bool comment = false;
+    std::string line;
+    std::string normalized;
+    while (std::getline(istr, line)) {
+        // keep the tokens of the line, separated by one space where needed
+        normalized.clear();
+        bool space = false;
+        for (std::string::size_type pos = 0; pos < line.size(); ++pos) {
+            const char c = line[pos];
+            if (comment) {
+                if (c == '*' && pos + 1 < line.size() && line[pos + 1] == '/') {
+                    comment = false;
+                    space = true;
+                    ++pos;
+                }
+            } else if (c == '/' && pos + 1 < line.size() && line[pos + 1] == '/') {
+                break;
+            } else if (c == '/' && pos + 1 < line.size() && line[pos + 1] == '*') {
+                comment = true;
+                ++pos;
+            } else if (std::isspace((unsigned char)c)) {
+                space = true;
+            } else if (c == '\"' || c == '\'') {
+                // string and character literals are kept as they are
+                normalized += c;
+                for (++pos; pos < line.size(); ++pos) {
+                    normalized += line[pos];
+                    if (line[pos] == '\\' && pos + 1 < line.size())
+                        normalized += line[++pos];
+                    else if (line[pos] == c)
+                        break;
+                }
+                space = false;
+            } else {
+                if (space && !normalized.empty() && isNameChar(normalized[normalized.size() - 1]) && isNameChar(c))
+                    normalized += ' ';
+                normalized += c;
+                space = false;
+            }
+        }
+
+        CFingerprint hash;
+        hash.Add(normalized);
+        hashes.push_back(hash.Value());
+    }
+}
@@ -0,0 +1,97 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//---------------------------------------------------------------------------
+#ifndef baselineH
+#define baselineH
+//---------------------------------------------------------------------------
+
+#include <string>
+#include <istream>
+#include <ostream>
+#include <map>
+#include <set>
+#include <vector>
+#include "config.h"
+#include "errorlogger.h"
+
+/// @addtogroup Core
+/// @{
+
+/**
+ * @brief Fingerprints of known findings (--baseline=, --baseline-out=).
+ *
+ * A fingerprint combines the check id, the file, the enclosing function and
+ * a hash of the normalized source line of the finding. Line numbers are not
+ * part of it, so findings keep their fingerprint when code above them is
+ * added or removed.
+ */
+class TSCANCODELIB Baseline {
+public:
+    typedef unsigned long long Fingerprint;
+
+    /** @brief file name -> hash of each line */
+    typedef std::map<std::string, std::vector<unsigned long long> > LineHashes;
+
+    /**
+     * @brief Read a baseline written by write()
+     * @return error message. empty upon success
+     */
+    std::string parseFile(std::istream &istr);
+
+    /** @brief no known findings */
+    bool empty() const {
+        return _known.empty();
+    }
+
+    /** @brief is the finding in the baseline? */
+    bool isKnown(Fingerprint fingerprint) const {
+        return _known.find(fingerprint) != _known.end();
+    }
+
+    /** @brief add the findings of a checker, not thread safe */
+    void addFindings(const std::set<Fingerprint> &fingerprints) {
+        _findings.insert(fingerprints.begin(), fingerprints.end());
+    }
+
+    /** @brief add one finding and tell if it is known, not thread safe */
+    bool addFinding(Fingerprint fingerprint) {
+        _findings.insert(fingerprint);
+        return isKnown(fingerprint);
+    }
+
+    /** @brief write the findings of this run as the baseline of the next one */
+    void write(std::ostream &ostr) const;
+
+    /**
+     * @brief fingerprint of a finding
+     * @param msg the finding, _funcinfo is the enclosing function (ErrorLogger::GetScopeFuncInfo())
+     * @param lineHashes the lines of the files are read and hashed once and kept here
+     */
+    static Fingerprint fingerprint(const ErrorLogger::ErrorMessage &msg, LineHashes &lineHashes);
+
+    /** @brief hash every line of a source file, whitespace and comments are ignored */
+    static void hashLines(std::istream &istr, std::vector<unsigned long long> &hashes);
+
+private:
+    std::set<Fingerprint> _known;
+    std::set<Fingerprint> _findings;
+};
+
+/// @}
+//---------------------------------------------------------------------------
+#endif // baselineH
@@ -0,0 +1,217 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "changedlines.h"
+#include "path.h"
+
+#include <algorithm>
+#include <sstream>
+
+static std::string normalizePath(const std::string &file)
+{
+    std::string path = Path::simplifyPath(Path::fromNativeSeparators(file));
+    while (path.compare(0, 2, "./") == 0)
+        path.erase(0, 2);
+    return path;
+}
+
+static std::string fileName(const std::string &path)
+{
+    const std::string::size_type pos = path.rfind('/');
+    return pos == std::string::npos ? path : path.substr(pos + 1);
+}
+
+// does path end with the path components of tail?
+static bool endsWithPath(const std::string &path, const std::string &tail)
+{
+    if (tail.size() > path.size() || path.compare(path.size() - tail.size(), tail.size(), tail) != 0)
+        return false;
+    return tail.size() == path.size() || path[path.size() - tail.size() - 1] == '/';
+}
+
+static bool endsBefore(const std::pair<unsigned int, unsigned int> &range, const std::pair<unsigned int, unsigned int> &value)
+{
+    return range.second < value.first;
+}
+
+static bool readNumber(const std::string &str, std::string::size_type &pos, unsigned int &value)
+{
+    const std::string::size_type start = pos;
+    value = 0;
+    while (pos < str.size() && str[pos] >= '0' && str[pos] <= '9')
+        value = value * 10 + (unsigned int)(str[pos++] - '0');
+    return pos != start;
+}
+
+std::string ChangedLines::parseFile(std::istream &istr)
+{
+    std::string filedata;
+    std::string line;
+    while (std::getline(istr, line))
+        filedata += line + "\n";
+    filedata.erase(std::remove(filedata.begin(), filedata.end(), '\r'), filedata.end());
+
+    // a diff starts with a header, a list with a file name
+    std::istringstream istr2(filedata);
+    std::string::size_type pos = filedata.find_first_not_of("\n");
+    const bool isDiff = pos != std::string::npos &&
+                        (filedata.compare(pos, 5, "diff ") == 0 || filedata.compare(pos, 4, "--- ") == 0 ||
+                         filedata.compare(pos, 4, "+++ ") == 0 || filedata.compare(pos, 7, "Index: ") == 0 ||
+                         filedata.compare(pos, 3, "@@ ") == 0);
+    const std::string errmsg = isDiff ? parseDiff(istr2) : parseList(istr2);
+    merge();
+    return errmsg;
+}
+
+std::string ChangedLines::parseDiff(std::istream &istr)
+{
+    std::string file;
+    unsigned int newLine = 0;
+    unsigned int oldLeft = 0;
+    unsigned int newLeft = 0;
+    std::string line;
+    while (std::getline(istr, line)) {
+        if (oldLeft > 0 || newLeft > 0) {
+            // hunk body
+            const char c = line.empty() ? ' ' : line[0];
+            if (c == '+') {
+                add(file, newLine, newLine);
+                ++newLine;
+                if (newLeft > 0)
+                    --newLeft;
+            } else if (c == '-') {
+                // a removed line changes its neighbours
+                add(file, newLine > 1 ? newLine - 1 : 1, newLine > 0 ? newLine : 1);
+                if (oldLeft > 0)
+                    --oldLeft;
+            } else if (c == ' ') {
+                ++newLine;
+                if (oldLeft > 0)
+                    --oldLeft;
+                if (newLeft > 0)
+                    --newLeft;
+            }
+            continue;
+        }
+
+        if (line.compare(0, 4, "+++ ") == 0) {
+            file = line.substr(4);
+            const std::string::size_type tab = file.find('\t');
+            if (tab != std::string::npos)
+                file.erase(tab);
+            if (file == "/dev/null")
+                file.clear();
+            else if (file.compare(0, 2, "b/") == 0)
+                file.erase(0, 2);
+        } else if (line.compare(0, 4, "@@ -") == 0) {
+            // @@ -oldStart[,oldCount] +newStart[,newCount] @@
+            std::string::size_type pos = 4;
+            unsigned int oldStart = 0, oldCount = 1, newCount = 1;
+            bool ok = readNumber(line, pos, oldStart);
+            if (ok && pos < line.size() && line[pos] == ',')
+                ok = readNumber(line, ++pos, oldCount);
+            ok = ok && line.compare(pos, 2, " +") == 0;
+            pos += 2;
+            ok = ok && readNumber(line, pos, newLine);
+            if (ok && pos < line.size() && line[pos] == ',')
+                ok = readNumber(line, ++pos, newCount);
+            if (!ok)
+                return "TscanCode: Failed to parse diff hunk header: \"" + line + "\"";
+            oldLeft = oldCount;
+            newLeft = newCount;
+        }
+    }
+    return "";
+}
+
+std::string ChangedLines::parseList(std::istream &istr)
+{
+    std::string line;
+    while (std::getline(istr, line)) {
+        // Skip empty lines and comments
+        if (line.empty() || line[0] == '#' || line.compare(0, 2, "//") == 0)
+            continue;
+
+        // file:line or file:first-last
+        const std::string::size_type colon = line.rfind(':');
+        std::string::size_type pos = colon + 1;
+        unsigned int first = 0, last = 0;
+        bool ok = colon != std::string::npos && colon > 0 && readNumber(line, pos, first);
+        last = first;
+        if (ok && pos < line.size() && line[pos] == '-')
+            ok = readNumber(line, ++pos, last);
+        if (!ok || pos != line.size() || last < first)
+            return "TscanCode: Failed to parse changed line range: \"" + line + "\"";
+        add(line.substr(0, colon), first, last);
+    }
+    return "";
+}
+
+void ChangedLines::add(const std::string &file, unsigned int first, unsigned int last)
+{
+    if (file.empty())
+        return;
+    const std::string path = normalizePath(file);
+    _files[fileName(path)][path].push_back(std::make_pair(first, last));
+}
+
+void ChangedLines::merge()
+{
+    for (std::map<std::string, std::map<std::string, Ranges> >::iterator it = _files.begin(); it != _files.end(); ++it) {
+        for (std::map<std::string, Ranges>::iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
+            Ranges &ranges = it2->second;
+            std::sort(ranges.begin(), ranges.end());
+            Ranges merged;
+            for (Ranges::const_iterator range = ranges.begin(); range != ranges.end(); ++range) {
+                if (!merged.empty() && range->first <= merged.back().second + 1)
+                    merged.back().second = std::max(merged.back().second, range->second);
+                else
+                    merged.push_back(*range);
+            }
+            ranges.swap(merged);
+        }
+    }
+}
+
+const ChangedLines::Ranges *ChangedLines::find(const std::string &file) const
+{
+    const std::string path = normalizePath(file);
+    const std::map<std::string, std::map<std::string, Ranges> >::const_iterator it = _files.find(fileName(path));
+    if (it == _files.end())
+        return nullptr;
+    for (std::map<std::string, Ranges>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
+        if (endsWithPath(path, it2->first) || endsWithPath(it2->first, path))
+            return &it2->second;
+    }
+    return nullptr;
+}
+
+bool ChangedLines::isChanged(const std::string &file) const
+{
+    return find(file) != nullptr;
+}
+
+bool ChangedLines::overlaps(const std::string &file, unsigned int first, unsigned int last) const
+{
+    const Ranges *ranges = find(file);
+    if (!ranges)
+        return false;
+    // first range ending at or after the first line
+    Ranges::const_iterator range = std::lower_bound(ranges->begin(), ranges->end(), std::make_pair(first, first), endsBefore);
+    return range != ranges->end() && range->first <= last;
+}
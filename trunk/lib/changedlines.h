@@ -0,0 +1,74 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//---------------------------------------------------------------------------
+#ifndef changedlinesH
+#define changedlinesH
+//---------------------------------------------------------------------------
+
+#include <string>
+#include <istream>
+#include <map>
+#include <vector>
+#include "config.h"
+
+/// @addtogroup Core
+/// @{
+
+/**
+ * @brief Lines touched by a change (--diff-scope).
+ *
+ * Read from a unified diff or from a list of "file:line" and
+ * "file:first-last" entries. Paths in the diff are usually relative to the
+ * root of the repository, so a checked file matches an entry whose path is
+ * a trailing part of it.
+ */
+class TSCANCODELIB ChangedLines {
+public:
+    /**
+     * @brief Parse a unified diff or a list of file:line ranges
+     * @return error message. empty upon success
+     */
+    std::string parseFile(std::istream &istr);
+
+    /** @brief no ranges given, everything is checked */
+    bool empty() const {
+        return _files.empty();
+    }
+
+    /** @brief does the change touch the file? */
+    bool isChanged(const std::string &file) const;
+
+    /** @brief does the change touch one of the lines first..last of the file? */
+    bool overlaps(const std::string &file, unsigned int first, unsigned int last) const;
+
+private:
+    typedef std::vector<std::pair<unsigned int, unsigned int> > Ranges;
+
+    std::string parseDiff(std::istream &istr);
+    std::string parseList(std::istream &istr);
+    void add(const std::string &file, unsigned int first, unsigned int last);
+    void merge();
+    const Ranges *find(const std::string &file) const;
+
+    /** @brief file name -> path -> sorted, disjoint line ranges */
+    std::map<std::string, std::map<std::string, Ranges> > _files;
+};
+
+/// @}
+//---------------------------------------------------------------------------
+#endif // changedlinesH
@@ -62,6 +62,11 @@ public:
 
     /** run checks, the token list is simplified */
     virtual void runSimplifiedChecks(const Tokenizer *tokenizer, const Settings *settings, ErrorLogger *errorLogger) = 0;
+
+    /** the findings are local to function scopes, Tokenizer::isSkippedScope() functions are not checked */
+    virtual bool isFunctionScoped() const {
+        return false;
+    }
     
     
     /** run analysis, the token list is not simplified */
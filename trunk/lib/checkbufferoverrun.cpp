@@ -1189,6 +1189,8 @@ void CheckBufferOverrun::checkGlobalAndLocalVariable()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
 
         for (const Token *tok = scope->classStart; tok != scope->classEnd; tok = tok->next()) {
             // if the previous token exists, it must be either a variable name or "[;{}]"
@@ -1665,6 +1667,8 @@ void CheckBufferOverrun::checkBufferAllocatedWithStrlen()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token *tok = scope->classStart->next(); tok && tok != scope->classEnd; tok = tok->next()) {
             unsigned int dstVarId;
             unsigned int srcVarId;
@@ -1712,6 +1716,8 @@ void CheckBufferOverrun::checkStringArgument()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t functionIndex = 0; functionIndex < functions; ++functionIndex) {
         const Scope * const scope = symbolDatabase->functionScopes[functionIndex];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token *tok = scope->classStart; tok != scope->classEnd; tok = tok->next()) {
             if (!Token::Match(tok, "%name% (") || !_settings->library.hasminsize(tok->str()))
                 continue;
@@ -1889,6 +1895,8 @@ void CheckBufferOverrun::arrayIndexThenCheck()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * const scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token *tok = scope->classStart; tok && tok != scope->classEnd; tok = tok->next()) {
             if (Token::Match(tok, "%name% [ %var% ]")) {
                 tok = tok->tokAt(2);
@@ -2250,6 +2258,8 @@ void CheckBufferOverrun::checkSelfAddedSubscript()
 	const std::size_t functions = symbolDatabase->functionScopes.size();
 	for (std::size_t i = 0; i < functions; ++i) {
 		const Scope * const scope = symbolDatabase->functionScopes[i];
+		if (_tokenizer->isSkippedScope(scope))
+			continue;
 		for (const Token *tok = scope->classStart; tok && tok != scope->classEnd; tok = tok->next()) {
 			if (Token::Match(tok, "%name% [ %var% ]")) {
 				tok = tok->tokAt(2);
@@ -58,6 +58,10 @@ public:
 
 	
 
+    bool isFunctionScoped() const {
+        return true;
+    }
+
     void runSimplifiedChecks(const Tokenizer *tokenizer, const Settings *settings, ErrorLogger *errorLogger)
     {
 		CheckBufferOverrun checkBufferOverrun(tokenizer, settings, errorLogger);
@@ -448,28 +448,16 @@ bool CheckClass::canNotMove(const Scope *scope)
 
 void CheckClass::assignVar(const std::string &varname, const Scope *scope, std::vector<Usage> &usage)
 {
-    std::list<Variable>::const_iterator var;
-    unsigned int count = 0;
-
-    for (var = scope->varlist.begin(); var != scope->varlist.end(); ++var, ++count) {
-        if (var->name() == varname) {
-            usage[count].assign = true;
-            return;
-        }
-    }
+    const ClassMembers::MemberVar *var = scope->check->classMembers(scope).findVariable(varname);
+    if (var && var->origin == scope)
+        usage[var->index].assign = true;
 }
 
 void CheckClass::initVar(const std::string &varname, const Scope *scope, std::vector<Usage> &usage)
 {
-    std::list<Variable>::const_iterator var;
-    unsigned int count = 0;
-
-    for (var = scope->varlist.begin(); var != scope->varlist.end(); ++var, ++count) {
-        if (var->name() == varname) {
-            usage[count].init = true;
-            return;
-        }
-    }
+    const ClassMembers::MemberVar *var = scope->check->classMembers(scope).findVariable(varname);
+    if (var && var->origin == scope)
+        usage[var->index].init = true;
 }
 
 void CheckClass::assignAllVar(std::vector<Usage> &usage)
@@ -488,27 +476,10 @@ void CheckClass::clearAllVar(std::vector<Usage> &usage)
 
 bool CheckClass::isBaseClassFunc(const Token *tok, const Scope *scope)
 {
-    // Iterate through each base class...
-    for (std::size_t i = 0; i < scope->definedType->derivedFrom.size(); ++i) {
-        const Type *derivedFrom = scope->definedType->derivedFrom[i].type;
-
-        // Check if base class exists in database
-        if (derivedFrom && derivedFrom->classScope) {
-            const std::list<Function>& functionList = derivedFrom->classScope->functionList;
-            std::list<Function>::const_iterator func;
-
-            for (func = functionList.begin(); func != functionList.end(); ++func) {
-                if (func->tokenDef->str() == tok->str())
-                    return true;
-            }
-        }
-
-        // Base class not found so assume it is in it.
-        else
-            return true;
-    }
+    const ClassMembers &members = scope->check->classMembers(scope);
 
-    return false;
+    // Base class not found so assume it is in it.
+    return members.unknownBase || members.directBaseFunctions.find(tok->str()) != members.directBaseFunctions.end();
 }
 
 void CheckClass::initializeVarList(const Function &func, std::list<const Function *> &callstack, const Scope *scope, std::vector<Usage> &usage, bool bListOnly)
@@ -1809,78 +1780,34 @@ bool CheckClass::isMemberVar(const Scope *scope, const Token *tok) const
         }
     } while (again);
 
-    std::list<Variable>::const_iterator var;
-    for (var = scope->varlist.begin(); var != scope->varlist.end(); ++var) {
-        if (var->name() == tok->str()) {
-            if (tok->varId() == 0)
-                symbolDatabase->debugMessage(tok, "CheckClass::isMemberVar found used member variable \'" + tok->str() + "\' with varid 0");
-
-            return !var->isStatic();
-        }
-    }
-
-    // not found in this class
-    if (!scope->definedType->derivedFrom.empty()) {
-        // check each base class
-        for (std::size_t i = 0; i < scope->definedType->derivedFrom.size(); ++i) {
-            // find the base class
-            const Type *derivedFrom = scope->definedType->derivedFrom[i].type;
+    // the class and its base classes
+    const ClassMembers::MemberVar *var = symbolDatabase->classMembers(scope).findVariable(tok->str());
+    if (!var)
+        return false;
 
-            // find the function in the base class
-            if (derivedFrom && derivedFrom->classScope) {
-                if (isMemberVar(derivedFrom->classScope, tok))
-                    return true;
-            }
-        }
-    }
+    if (tok->varId() == 0)
+        symbolDatabase->debugMessage(tok, "CheckClass::isMemberVar found used member variable \'" + tok->str() + "\' with varid 0");
 
-    return false;
+    return var->isInstanceMember;
 }
 
 bool CheckClass::isMemberFunc(const Scope *scope, const Token *tok) const
 {
-    if (tok->function() && tok->function()->nestedIn == scope)
-        return !tok->function()->isStatic();
-
-    // not found in this class
-    if (!scope->definedType->derivedFrom.empty()) {
-        // check each base class
-        for (std::size_t i = 0; i < scope->definedType->derivedFrom.size(); ++i) {
-            // find the base class
-            const Type *derivedFrom = scope->definedType->derivedFrom[i].type;
-
-            // find the function in the base class
-            if (derivedFrom && derivedFrom->classScope) {
-                if (isMemberFunc(derivedFrom->classScope, tok))
-                    return true;
-            }
-        }
-    }
-
-    return false;
+    // declared in the class or one of its base classes?
+    const Function *func = tok->function();
+    if (!func || func->isStatic())
+        return false;
+    const ClassMembers &members = symbolDatabase->classMembers(scope);
+    return members.scopes.find(func->nestedIn) != members.scopes.end();
 }
 
 bool CheckClass::isConstMemberFunc(const Scope *scope, const Token *tok) const
 {
-    if (tok->function() && tok->function()->nestedIn == scope)
-        return tok->function()->isConst();
-
-    // not found in this class
-    if (!scope->definedType->derivedFrom.empty()) {
-        // check each base class
-        for (std::size_t i = 0; i < scope->definedType->derivedFrom.size(); ++i) {
-            // find the base class
-            const Type *derivedFrom = scope->definedType->derivedFrom[i].type;
-
-            // find the function in the base class
-            if (derivedFrom && derivedFrom->classScope) {
-                if (isConstMemberFunc(derivedFrom->classScope, tok))
-                    return true;
-            }
-        }
-    }
-
-    return false;
+    const Function *func = tok->function();
+    if (!func || !func->isConst())
+        return false;
+    const ClassMembers &members = symbolDatabase->classMembers(scope);
+    return members.scopes.find(func->nestedIn) != members.scopes.end();
 }
 
 namespace {
@@ -2230,6 +2230,8 @@ void CheckMemoryLeakInFunction::checkReallocUsage()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
 
         // Search for the "var = realloc(var, 100" pattern within this function
         for (const Token *tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
@@ -2295,6 +2297,8 @@ void CheckMemoryLeakInFunction::check()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
 
         checkScope(scope->classStart->next(), "", 0, scope->functionOf != nullptr, 1);
     }
@@ -199,6 +199,11 @@ public:
             symbolDatabase = 0;
     }
 
+    /** @brief the findings are local to function scopes */
+    bool isFunctionScoped() const {
+        return true;
+    }
+
     /** @brief run all simplified checks */
     void runSimplifiedChecks(const Tokenizer *tokenizr, const Settings *settings, ErrorLogger *errLog) {
         CheckMemoryLeakInFunction checkMemoryLeak(tokenizr, settings, errLog);
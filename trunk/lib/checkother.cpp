@@ -233,6 +233,8 @@ void CheckOther::checkCastIntToCharAndBack()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         std::map<unsigned int, std::string> vars;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
             // Quick check to see if any of the matches below have any chances
@@ -302,6 +304,8 @@ void CheckOther::clarifyCalculation()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
             // ? operator where lhs is arithmetical expression
             if (tok->str() != "?" || !tok->astOperand1() || !tok->astOperand1()->isCalculation())
@@ -355,6 +359,8 @@ void CheckOther::clarifyStatement()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart; tok && tok != scope->classEnd; tok = tok->next()) {
             if (Token::Match(tok, "* %name%") && tok->astOperand1()) {
                 const Token *tok2 = tok->previous();
@@ -422,6 +428,8 @@ void CheckOther::warningOldStylePointerCast()
     const SymbolDatabase *symbolDatabase = _tokenizer->getSymbolDatabase();
     for (std::size_t i = 0; i < symbolDatabase->functionScopes.size(); ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         const Token* tok;
         if (scope->function && scope->function->isConstructor())
             tok = scope->classDef;
@@ -489,6 +497,8 @@ void CheckOther::invalidPointerCast()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
             const Token* toTok = nullptr;
             const Token* nextTok = nullptr;
@@ -578,6 +588,8 @@ void CheckOther::checkPipeParameterSize()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
             if (Token::Match(tok, "pipe ( %var% )") ||
                 Token::Match(tok, "pipe2 ( %var% ,")) {
@@ -1092,6 +1104,8 @@ void CheckOther::checkSuspiciousEqualityComparison()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart; tok != scope->classEnd; tok = tok->next()) {
             if (Token::simpleMatch(tok, "for (")) {
                 const Token* const openParen = tok->next();
@@ -1141,6 +1155,8 @@ void CheckOther::invalidFunctionUsage()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
             if (!tok->isName() || !Token::Match(tok, "%name% ( !!)"))
                 continue;
@@ -1209,6 +1225,8 @@ void CheckOther::checkUnreachableCode()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
 
         for (const Token* tok = scope->classStart; tok && tok != scope->classEnd; tok = tok->next()) {
             const Token* secondBreak = 0;
@@ -1323,6 +1341,8 @@ void CheckOther::checkMemsetZeroBytes()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
             if (Token::Match(tok, "memset|bzero (")) {
 				//if memset second param is 0,not report error
@@ -1381,6 +1401,8 @@ void CheckOther::checkMemsetInvalid2ndParam()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok && (tok != scope->classEnd); tok = tok->next()) {
             if (Token::simpleMatch(tok, "memset (")) {
                 const Token* firstParamTok = tok->tokAt(2);
@@ -1711,6 +1733,8 @@ void CheckOther::checkCharVariable()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart; tok != scope->classEnd; tok = tok->next()) {
             if (Token::Match(tok, "%var% [")) {
                 if (!tok->variable() || !tok->variable()->isArray())
@@ -1983,6 +2007,8 @@ void CheckOther::checkMathFunctions()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
             if (tok->varId())
                 continue;
@@ -2079,6 +2105,8 @@ void CheckOther::checkMisusedScopedObject()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token *tok = scope->classStart; tok && tok != scope->classEnd; tok = tok->next()) {
             if ((tok->next()->type() || (tok->next()->function() && tok->next()->function()->isConstructor())) // TODO: The rhs of || should be removed; It is a workaround for a symboldatabase bug
                 && Token::Match(tok, "[;{}] %name% (")
@@ -2219,6 +2247,8 @@ void CheckOther::checkInvalidFree()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
 
             // Keep track of which variables were assigned addresses to newly-allocated memory
@@ -2558,6 +2588,8 @@ void CheckOther::checkComparisonFunctionIsAlwaysTrueOrFalse()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
             if (tok->isName() && Token::Match(tok, "isgreater|isless|islessgreater|isgreaterequal|islessequal ( %var% , %var% )")) {
                 const unsigned int varidLeft = tok->tokAt(2)->varId();// get the left varid
@@ -2605,6 +2637,8 @@ void CheckOther::checkSignOfUnsignedVariable()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         // check all the code in the function
         for (const Token *tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
             // Quick check to see if any of the matches below have any chances
@@ -2775,6 +2809,8 @@ void CheckOther::checkNegativeBitwiseShift()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
 			
             if (tok->str() != "<<" && tok->str() != ">>")
@@ -2842,6 +2878,8 @@ void CheckOther::checkIncompleteArrayFill()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
             if (Token::Match(tok, "memset|memcpy|memmove ( %var% ,") && Token::Match(tok->linkAt(1)->tokAt(-2), ", %num% )")) {
                 const Variable *var = tok->tokAt(2)->variable();
@@ -2888,6 +2926,8 @@ void CheckOther::checkVarFuncNullUB()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart; tok != scope->classEnd; tok = tok->next()) {
             // Is NULL passed to a function?
             if (Token::Match(tok,"[(,] NULL [,)]")) {
@@ -2976,6 +3016,8 @@ void CheckOther::checkIgnoredReturnValue()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
         for (const Token* tok = scope->classStart->next(); tok != scope->classEnd; tok = tok->next()) {
             if (tok->varId() || !Token::Match(tok, "%name% (") || tok->strAt(-1) == ".")
                 continue;
@@ -3099,6 +3141,8 @@ void CheckOther::checkUnusedLabel()
     const std::size_t functions = symbolDatabase->functionScopes.size();
     for (std::size_t i = 0; i < functions; ++i) {
         const Scope * scope = symbolDatabase->functionScopes[i];
+        if (_tokenizer->isSkippedScope(scope))
+            continue;
 
         for (const Token* tok = scope->classStart; tok != scope->classEnd; tok = tok->next()) {
             if (!tok->scope()->isExecutable())
@@ -90,6 +90,11 @@ public:
 #endif
     }
 
+    /** @brief the findings are local to function scopes */
+    bool isFunctionScoped() const {
+        return true;
+    }
+
     /** @brief Run checks against the simplified token list */
     void runSimplifiedChecks(const Tokenizer *tokenizer, const Settings *settings, ErrorLogger *errorLogger) {
         CheckOther checkOther(tokenizer, settings, errorLogger);
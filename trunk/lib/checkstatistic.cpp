@@ -2,6 +2,8 @@
 #include "symboldatabase.h"
 #include "globaltokenizer.h"
 
+#include <algorithm>
+
 // Register this check class (by creating a static instance of it)
 namespace {
 	CheckStatistic checkStatistic;
@@ -11,9 +13,11 @@ void CheckStatistic::checkFuncRetNull()
 {
 	std::map<std::string, std::map<const gt::CFunction*, std::list<FuncRetInfo> > >& threadData 
 		= CGlobalStatisticData::Instance()->GetFuncRetNullThreadData(_errorLogger);
+	const std::set<std::string>* filesBeforeWindows = CGlobalStatisticData::Instance()->GetFilesBeforeWindows(_errorLogger);
 
 	int curFileIndex = -1;
 	std::string curFile;
+	bool bUnique = false;
 	
 	for (const Token* tok = _tokenizer->list.front(); tok; tok = tok->next())
 	{
@@ -23,7 +27,9 @@ void CheckStatistic::checkFuncRetNull()
 			curFile = _tokenizer->list.file(tok);
 
 			std::map<std::string, std::map<const gt::CFunction*, std::list<FuncRetInfo> > >::iterator findFile = threadData.find(curFile);
-			if (findFile != threadData.end())
+			// an earlier window of the same file already recorded the code all windows share
+			bUnique = findFile != threadData.end() && filesBeforeWindows && filesBeforeWindows->count(curFile) == 0;
+			if (findFile != threadData.end() && !bUnique)
 			{
 				const Token* tok2 = tok;
 				while (tok2->next() && tok2->next()->fileIndex() == tok->fileIndex())
@@ -63,7 +69,9 @@ void CheckStatistic::checkFuncRetNull()
 
 				if (gtFunc)
 				{
-					infoList[gtFunc].push_back(op);
+					std::list<FuncRetInfo>& funcInfo = infoList[gtFunc];
+					if (!bUnique || std::find(funcInfo.begin(), funcInfo.end(), op) == funcInfo.end())
+						funcInfo.push_back(op);
 				}
 			}
 
@@ -346,10 +354,12 @@ void CheckStatistic::checkOutOfBounds()
 {
 	std::map<std::string, std::list<ArrayIndexInfo> >& threadData
 		= CGlobalStatisticData::Instance()->GetOutOfBoundsThreadData(_errorLogger);
+	const std::set<std::string>* filesBeforeWindows = CGlobalStatisticData::Instance()->GetFilesBeforeWindows(_errorLogger);
 
 	int curFileIndex = -1;
 	std::string curFile;
 	std::list<ArrayIndexInfo>* infoList = NULL;
+	bool bUnique = false;
 
 	for (const Token* tok = _tokenizer->list.front(); tok; tok = tok->next())
 	{
@@ -359,7 +369,8 @@ void CheckStatistic::checkOutOfBounds()
 			curFile = _tokenizer->list.file(tok);
 
 			std::map<std::string, std::list<ArrayIndexInfo> >::iterator findFile = threadData.find(curFile);
-			if (findFile != threadData.end())
+			bUnique = findFile != threadData.end() && filesBeforeWindows && filesBeforeWindows->count(curFile) == 0;
+			if (findFile != threadData.end() && !bUnique)
 			{
 				const Token* tok2 = tok;
 				while (tok2->next() && tok2->next()->fileIndex() == tok->fileIndex())
@@ -388,7 +399,7 @@ void CheckStatistic::checkOutOfBounds()
 		if (bOK)
 		{
 
-			CheckForBody(tokStart, tsIndex, tsBoundary, infoList);
+			CheckForBody(tokStart, tsIndex, tsBoundary, infoList, bUnique);
 		}
 	}
 }
@@ -481,7 +492,7 @@ const bool CheckStatistic::CheckForIsValid(const Token* tokFor, SExprLocation& t
 
 }
 
-void CheckStatistic::CheckForBody(const Token* tokStart, const SExprLocation& tsIndex, const SExprLocation& tsBoundary, std::list<ArrayIndexInfo>* info)
+void CheckStatistic::CheckForBody(const Token* tokStart, const SExprLocation& tsIndex, const SExprLocation& tsBoundary, std::list<ArrayIndexInfo>* info, bool bUnique)
 {
 	if (!info)
 	{
@@ -531,7 +542,8 @@ void CheckStatistic::CheckForBody(const Token* tokStart, const SExprLocation& ts
 		aii.ArrayType = GetTypeString(elArray);
 		aii.BoundType = GetTypeString(tsBoundary);
 
-		info->push_back(aii);
+		if (!bUnique || std::find(info->begin(), info->end(), aii) == info->end())
+			info->push_back(aii);
 	}
 }
 
@@ -86,10 +86,45 @@ static const Token *skipMembers(const Token *tok)
     return tok;
 }
 
+struct CheckStl::IteratorUsage {
+    const Variable *var;
+
+    // the iterator is followed from var->nameToken() up to this token
+    const Token *end;
+    bool started;
+    bool done;
+
+    // the validIterator flag says if the iterator has a valid value or not
+    bool validIterator;
+    const Scope* invalidationScope;
+
+    // The container this iterator can be used with
+    const Variable* container;
+    const Scope* containerAssignScope;
+
+    // When "validatingToken" is reached the validIterator is set to true
+    const Token* validatingToken;
+
+    const Token* eraseToken;
+
+    // the iterator skipped ahead, the tokens before this one are not looked at
+    const Token* resumeToken;
+
+    // last token the iterator was checked at
+    const Token* checked;
+};
+
 void CheckStl::iterators()
 {
     const SymbolDatabase *symbolDatabase = _tokenizer->getSymbolDatabase();
 
+    // The local iterators of each function. The body of a function is
+    // scanned once for all of its iterators.
+    std::map<const Scope *, std::vector<IteratorUsage> > functionIterators;
+
+    // varid -> position of the iterator in functionIterators
+    std::vector<std::size_t> usageIndex(symbolDatabase->getVariableListSize(), 0);
+
     // Using same iterator against different containers.
     // for (it = foo.begin(); it != bar.end(); ++it)
     for (unsigned int iteratorId = 1; iteratorId < symbolDatabase->getVariableListSize(); iteratorId++) {
@@ -115,148 +150,234 @@ void CheckStl::iterators()
                 continue;
         }
 
-        // the validIterator flag says if the iterator has a valid value or not
-        bool validIterator = Token::Match(var->nameToken()->next(), "[(=:]");
-        const Scope* invalidationScope = 0;
-
-        // The container this iterator can be used with
-        const Variable* container = 0;
-        const Scope* containerAssignScope = 0;
+        // the outermost executable scope, the function or lambda body
+        const Scope *functionScope = var->scope();
+        while (functionScope->nestedIn && functionScope->nestedIn->isExecutable())
+            functionScope = functionScope->nestedIn;
+
+        IteratorUsage usage;
+        usage.var = var;
+        usage.end = var->scope()->classEnd;
+        usage.started = false;
+        usage.done = false;
+        usage.validIterator = Token::Match(var->nameToken()->next(), "[(=:]");
+        usage.invalidationScope = 0;
+        usage.container = 0;
+        usage.containerAssignScope = 0;
+        usage.validatingToken = 0;
+        usage.eraseToken = 0;
+        usage.resumeToken = 0;
+        usage.checked = 0;
+
+        std::vector<IteratorUsage> &usages = functionIterators[functionScope];
+        usageIndex[iteratorId] = usages.size();
+        usages.push_back(usage);
+    }
 
-        // When "validatingToken" is reached the validIterator is set to true
-        const Token* validatingToken = 0;
+    for (std::map<const Scope *, std::vector<IteratorUsage> >::iterator it = functionIterators.begin(); it != functionIterators.end(); ++it) {
+        std::vector<IteratorUsage> &usages = it->second;
 
-        const Token* eraseToken = 0;
+        // Tokens where an iterator starts, ends, resumes or its state may
+        // change. Other iterators are only checked at tokens using them.
+        std::map<const Token *, std::vector<std::size_t> > events;
+        for (std::size_t i = 0; i < usages.size(); ++i) {
+            events[usages[i].var->nameToken()].push_back(i);
+            events[usages[i].end].push_back(i);
+        }
 
-        // Scan through the rest of the code and see if the iterator is
-        // used against other containers.
-        for (const Token *tok2 = var->nameToken(); tok2 && tok2 != var->scope()->classEnd; tok2 = tok2->next()) {
-            if (invalidationScope && tok2 == invalidationScope->classEnd)
-                validIterator = true; // Assume that the iterator becomes valid again
-            if (containerAssignScope && tok2 == containerAssignScope->classEnd)
-                container = 0; // We don't know which containers might be used with the iterator
+        std::vector<std::size_t> checkNow;
+        for (const Token *tok = it->first->classStart; tok && tok != it->first->classEnd; tok = tok->next()) {
+            checkNow.clear();
+
+            const std::map<const Token *, std::vector<std::size_t> >::iterator event = events.find(tok);
+            if (event != events.end()) {
+                for (std::size_t i = 0; i < event->second.size(); ++i) {
+                    IteratorUsage &usage = usages[event->second[i]];
+                    if (tok == usage.end)
+                        usage.done = true;
+                    if (tok == usage.var->nameToken())
+                        usage.started = true;
+                    if (tok == usage.resumeToken)
+                        usage.resumeToken = 0;
+                    checkNow.push_back(event->second[i]);
+                }
+                events.erase(event);
+            }
 
-            if (tok2 == validatingToken)
-                validIterator = true;
+            // Tokens of the patterns that use the iterator
+            const Token * const candidates[] = { tok, tok->next(), tok->tokAt(3), tok->tokAt(4), tok->tokAt(5) };
+            for (std::size_t i = 0; i < sizeof(candidates) / sizeof(*candidates); ++i) {
+                const unsigned int varId = candidates[i] ? candidates[i]->varId() : 0;
+                if (varId == 0 || varId >= usageIndex.size())
+                    continue;
+                const std::size_t index = usageIndex[varId];
+                if (index < usages.size() && usages[index].var->declarationId() == varId)
+                    checkNow.push_back(index);
+            }
 
-			// Is iterator compared against different container?
-			if (tok2 && Token::Match(tok2, "%varid% !=|== %name% . end|rend|cend|crend ( )", iteratorId) && container && tok2->tokAt(2)->varId() != container->declarationId()) {
-				iteratorsError(tok2, container->name(), tok2->strAt(2));
-				tok2 = tok2->tokAt(6);
-			}
-			else if (Token::Match(tok2, ". erase ( ++ %varid%", iteratorId) || Token::Match(tok2, ". erase ( %varid% ++", iteratorId))
-			{
-				//eg.std::map<uint32_t, std::vector<struct _Relation> >::iterator relationIter; can match "vector"
-				//if (Token::findsimplematch(var->typeStartToken(), "vector", var->typeEndToken()))
-				//only vector,deque report error
-				if (Token::Match(var->typeStartToken(), "std| ::| vector|deque"))
-				{
-					const Token* tokI = tok2->tokAt(3);
-					if (tokI->str() == "++")
-					{
-						tokI = tokI->next();
-					}
-					unexpectedIteratorError(tokI, tokI->str());
-				}
-			}
-			// Is the iterator used in a insert/erase operation?
-			else if (Token::Match(tok2, "%var% . insert|erase ( *| %varid% )|,", iteratorId)) {
-				const Token* itTok = tok2->tokAt(4);
-				if (itTok->str() == "*") {
-					if (tok2->strAt(2) == "insert")
-						continue;
-
-                    itTok = itTok->next();
-                }
-                // It is bad to insert/erase an invalid iterator
-                if (!validIterator)
-                    invalidIteratorError(tok2, itTok->str());
-
-                // If insert/erase is used on different container then
-                // report an error
-                if (container && tok2->varId() != container->declarationId()) {
-                    // skip error message if container is a set..
-                    const Variable *variableInfo = tok2->variable();
-                    const Token *decltok = variableInfo ? variableInfo->typeStartToken() : nullptr;
-
-                    if (Token::simpleMatch(decltok, "const| std :: set"))
-                        continue; // No warning
-
-                    // skip error message if the iterator is erased/inserted by value
-                    if (itTok->previous()->str() == "*")
-                        continue;
+            // bailout handling applies to all iterators
+            if (Token::Match(tok, "return|break|else")) {
+                for (std::size_t i = 0; i < usages.size(); ++i)
+                    checkNow.push_back(i);
+            }
 
-                    // Show error message, mismatching iterator is used.
-                    iteratorsError(tok2, container->name(), tok2->str());
-                }
+            for (std::size_t i = 0; i < checkNow.size(); ++i) {
+                IteratorUsage &usage = usages[checkNow[i]];
+                if (!usage.started || usage.done || usage.resumeToken || usage.checked == tok)
+                    continue;
+                usage.checked = tok;
 
-                // invalidate the iterator if it is erased
-                else if (tok2->strAt(2) == "erase" && (tok2->strAt(4) != "*" || (container && tok2->varId() == container->declarationId()))) {
-                    validIterator = false;
-                    eraseToken = tok2;
-                    invalidationScope = tok2->scope();
+                const Token *tok2 = checkIteratorUsage(usage, tok);
+                if (tok2 != tok) {
+                    usage.resumeToken = tok2->next();
+                    if (!usage.resumeToken)
+                        usage.done = true;
+                    else
+                        events[usage.resumeToken].push_back(checkNow[i]);
                 }
 
-                // skip the operation
-                tok2 = itTok->next();
+                if (usage.validatingToken)
+                    events[usage.validatingToken].push_back(checkNow[i]);
+                if (usage.invalidationScope)
+                    events[usage.invalidationScope->classEnd].push_back(checkNow[i]);
+                if (usage.containerAssignScope)
+                    events[usage.containerAssignScope->classEnd].push_back(checkNow[i]);
             }
+        }
+    }
+}
 
-            // it = foo.erase(..
-            // taking the result of an erase is ok
-            else if (Token::Match(tok2, "%varid% = %name% .", iteratorId) &&
-                     Token::simpleMatch(skipMembers(tok2->tokAt(2)), "erase (")) {
-                // the returned iterator is valid
-                validatingToken = tok2->linkAt(5);
-                tok2 = tok2->tokAt(5);
-            }
+const Token *CheckStl::checkIteratorUsage(IteratorUsage &usage, const Token *tok2)
+{
+    const Variable *var = usage.var;
+    const unsigned int iteratorId = var->declarationId();
+
+    if (usage.invalidationScope && tok2 == usage.invalidationScope->classEnd)
+        usage.validIterator = true; // Assume that the iterator becomes valid again
+    if (usage.containerAssignScope && tok2 == usage.containerAssignScope->classEnd)
+        usage.container = 0; // We don't know which containers might be used with the iterator
 
-            // Reassign the iterator
-            else if (Token::Match(tok2, "%varid% = %name% . begin|rbegin|cbegin|crbegin|find (", iteratorId)) {
-                validatingToken = tok2->linkAt(5);
-                container = tok2->tokAt(2)->variable();
-                containerAssignScope = tok2->scope();
+    if (tok2 == usage.validatingToken)
+        usage.validIterator = true;
 
-                // skip ahead
-                tok2 = tok2->tokAt(5);
+    // Is iterator compared against different container?
+    if (tok2 && Token::Match(tok2, "%varid% !=|== %name% . end|rend|cend|crend ( )", iteratorId) && usage.container && tok2->tokAt(2)->varId() != usage.container->declarationId()) {
+        iteratorsError(tok2, usage.container->name(), tok2->strAt(2));
+        tok2 = tok2->tokAt(6);
+    }
+    else if (Token::Match(tok2, ". erase ( ++ %varid%", iteratorId) || Token::Match(tok2, ". erase ( %varid% ++", iteratorId))
+    {
+        //eg.std::map<uint32_t, std::vector<struct _Relation> >::iterator relationIter; can match "vector"
+        //if (Token::findsimplematch(var->typeStartToken(), "vector", var->typeEndToken()))
+        //only vector,deque report error
+        if (Token::Match(var->typeStartToken(), "std| ::| vector|deque"))
+        {
+            const Token* tokI = tok2->tokAt(3);
+            if (tokI->str() == "++")
+            {
+                tokI = tokI->next();
             }
+            unexpectedIteratorError(tokI, tokI->str());
+        }
+    }
+    // Is the iterator used in a insert/erase operation?
+    else if (Token::Match(tok2, "%var% . insert|erase ( *| %varid% )|,", iteratorId)) {
+        const Token* itTok = tok2->tokAt(4);
+        if (itTok->str() == "*") {
+            if (tok2->strAt(2) == "insert")
+                return tok2;
+
+            itTok = itTok->next();
+        }
+        // It is bad to insert/erase an invalid iterator
+        if (!usage.validIterator)
+            invalidIteratorError(tok2, itTok->str());
+
+        // If insert/erase is used on different container then
+        // report an error
+        if (usage.container && tok2->varId() != usage.container->declarationId()) {
+            // skip error message if container is a set..
+            const Variable *variableInfo = tok2->variable();
+            const Token *decltok = variableInfo ? variableInfo->typeStartToken() : nullptr;
+
+            if (Token::simpleMatch(decltok, "const| std :: set"))
+                return tok2; // No warning
+
+            // skip error message if the iterator is erased/inserted by value
+            if (itTok->previous()->str() == "*")
+                return tok2;
+
+            // Show error message, mismatching iterator is used.
+            iteratorsError(tok2, usage.container->name(), tok2->str());
+        }
 
-            // Reassign the iterator
-            else if (Token::Match(tok2, "%varid% = %any%", iteratorId)) {
-                // Assume that the iterator becomes valid.
-                // TODO: add checking that checks if the iterator becomes valid or not
-                validatingToken = Token::findmatch(tok2->tokAt(2), "[;)]");
+        // invalidate the iterator if it is erased
+        else if (tok2->strAt(2) == "erase" && (tok2->strAt(4) != "*" || (usage.container && tok2->varId() == usage.container->declarationId()))) {
+            usage.validIterator = false;
+            usage.eraseToken = tok2;
+            usage.invalidationScope = tok2->scope();
+        }
 
-                // skip ahead
-                tok2 = tok2->tokAt(2);
-            }
+        // skip the operation
+        tok2 = itTok->next();
+    }
 
-            // Passing iterator to function. Iterator might be initialized
-            else if (Token::Match(tok2, "%varid% ,|)", iteratorId)) {
-                validIterator = true;
-            }
+    // it = foo.erase(..
+    // taking the result of an erase is ok
+    else if (Token::Match(tok2, "%varid% = %name% .", iteratorId) &&
+             Token::simpleMatch(skipMembers(tok2->tokAt(2)), "erase (")) {
+        // the returned iterator is valid
+        usage.validatingToken = tok2->linkAt(5);
+        tok2 = tok2->tokAt(5);
+    }
 
-            // Dereferencing invalid iterator?
-            else if (!validIterator && Token::Match(tok2, "* %varid%", iteratorId)) {
-                dereferenceErasedError(eraseToken, tok2, tok2->strAt(1));
-                tok2 = tok2->next();
-            } else if (!validIterator && Token::Match(tok2, "%varid% . %name%", iteratorId)) {
-                dereferenceErasedError(eraseToken, tok2, tok2->str());
-                tok2 = tok2->tokAt(2);
-            }
+    // Reassign the iterator
+    else if (Token::Match(tok2, "%varid% = %name% . begin|rbegin|cbegin|crbegin|find (", iteratorId)) {
+        usage.validatingToken = tok2->linkAt(5);
+        usage.container = tok2->tokAt(2)->variable();
+        usage.containerAssignScope = tok2->scope();
 
-            // bailout handling. Assume that the iterator becomes valid if we see return/break.
-            // TODO: better handling
-            else if (Token::Match(tok2, "return|break")) {
-                validatingToken = Token::findsimplematch(tok2->next(), ";");
-            }
+        // skip ahead
+        tok2 = tok2->tokAt(5);
+    }
 
-            // bailout handling. Assume that the iterator becomes valid if we see else.
-            // TODO: better handling
-            else if (tok2 && tok2->str() == "else") {
-                validIterator = true;
-            }
-        }
+    // Reassign the iterator
+    else if (Token::Match(tok2, "%varid% = %any%", iteratorId)) {
+        // Assume that the iterator becomes valid.
+        // TODO: add checking that checks if the iterator becomes valid or not
+        usage.validatingToken = Token::findmatch(tok2->tokAt(2), "[;)]");
+
+        // skip ahead
+        tok2 = tok2->tokAt(2);
+    }
+
+    // Passing iterator to function. Iterator might be initialized
+    else if (Token::Match(tok2, "%varid% ,|)", iteratorId)) {
+        usage.validIterator = true;
+    }
+
+    // Dereferencing invalid iterator?
+    else if (!usage.validIterator && Token::Match(tok2, "* %varid%", iteratorId)) {
+        dereferenceErasedError(usage.eraseToken, tok2, tok2->strAt(1));
+        tok2 = tok2->next();
+    } else if (!usage.validIterator && Token::Match(tok2, "%varid% . %name%", iteratorId)) {
+        dereferenceErasedError(usage.eraseToken, tok2, tok2->str());
+        tok2 = tok2->tokAt(2);
     }
+
+    // bailout handling. Assume that the iterator becomes valid if we see return/break.
+    // TODO: better handling
+    else if (Token::Match(tok2, "return|break")) {
+        usage.validatingToken = Token::findsimplematch(tok2->next(), ";");
+    }
+
+    // bailout handling. Assume that the iterator becomes valid if we see else.
+    // TODO: better handling
+    else if (tok2 && tok2->str() == "else") {
+        usage.validIterator = true;
+    }
+
+    return tok2;
 }
 
 
@@ -434,23 +555,22 @@ public:
 		if (!Token::simpleMatch(tok, ") {"))
 			return;
 
-		EraseCheckLoop c(checkStl, it->varId(), it);
+		// all paths of this loop live in the arena and are freed together
+		ExecutionPathArena arena;
+		EraseCheckLoop c(checkStl, it->varId(), it, &arena);
 		std::list<ExecutionPath *> checks;
 		checks.push_back(c.copy());
 		ExecutionPath::checkScope(tok->tokAt(2), checks);
 
 		c.end(checks, tok->link());
 
-		while (!checks.empty()) {
-			delete checks.back();
-			checks.pop_back();
-		}
+		ExecutionPath::bailOut(checks);
 	}
 
 private:
 	/** Startup constructor */
-	EraseCheckLoop(Check *o, unsigned int varid, const Token* usetoken)
-		: ExecutionPath(o, varid), eraseToken(0), useToken(usetoken) {
+	EraseCheckLoop(Check *o, unsigned int varid, const Token* usetoken, ExecutionPathArena *a)
+		: ExecutionPath(o, varid, a), eraseToken(0), useToken(usetoken) {
 	}
 
 	/** @brief token where iterator is erased (non-zero => the iterator is invalid) */
@@ -461,7 +581,7 @@ private:
 
 	/** @brief Copy this check. Called from the ExecutionPath baseclass. */
 	ExecutionPath *copy() {
-		return new EraseCheckLoop(*this);
+		return new (allocate(sizeof(EraseCheckLoop))) EraseCheckLoop(*this);
 	}
 
 	/** @brief is another execution path equal? */
@@ -472,6 +592,11 @@ private:
 		return (eraseToken == c->eraseToken);
 	}
 
+	/** @brief hash of the state compared in is_equal() */
+	std::size_t hash() const {
+		return reinterpret_cast<std::size_t>(eraseToken);
+	}
+
 	/** @brief no implementation => compiler error if used by accident */
 	void operator=(const EraseCheckLoop &);
 
@@ -165,6 +165,12 @@ public:
 	void checkCompareFunction();
 
 private:
+    /** @brief state of a local iterator in iterators() */
+    struct IteratorUsage;
+
+    /** @brief check the use of an iterator at a token, returns the last token that was looked at */
+    const Token *checkIteratorUsage(IteratorUsage &usage, const Token *tok2);
+
     void readingEmptyStlContainer_parseUsage(const Token* tok, bool map, std::set<unsigned int>& empty, bool noerror);
 
     void missingComparisonError(const Token *incrementToken1, const Token *incrementToken2);
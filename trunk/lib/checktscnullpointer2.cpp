@@ -8,6 +8,8 @@
 #include "checktscnullpointer2.h"
 #include "symboldatabase.h"
 #include "globaltokenizer.h"
+#include "taskpool.h"
+#include <exception>
 #include <fstream>
 
 extern bool iscast(const Token *tok);
@@ -18,7 +20,7 @@ namespace {
 	CheckTSCNullPointer2 instance;
 }
 
-CExprValue CExprValue::EmptyEV;
+const CExprValue CExprValue::EmptyEV;
 
 const CValueInfo CValueInfo::PossibleNull(0, true, true);
 const CValueInfo CValueInfo::Unknown;
@@ -2088,30 +2090,167 @@ void CheckTSCNullPointer2::TSCNullPointerCheck2()
 
 	const SymbolDatabase *symbolDatabase = _tokenizer->getSymbolDatabase();
 
+	std::vector<const Scope*> scopes;
 	const std::size_t functions = symbolDatabase->functionScopes.size();
 	for (std::size_t i = 0; i < functions; ++i) 
 	{
 		const Scope * scope = symbolDatabase->functionScopes[i];
+		if (_tokenizer->isSkippedScope(scope))
+			continue;
 		//if (scope->function == 0 || !scope->function->hasBody()) // We only look for functions with a body
 		//	continue;
+		scopes.push_back(scope);
+	}
+
+	// the dump file follows the tokens in order, it is only written by the serial check
+	if (_settings->_functionJobs > 1 && scopes.size() > 1 && !m_dump)
+	{
+		CheckFunctionScopesParallel(scopes);
+	}
+	else
+	{
+		for (std::size_t i = 0; i < scopes.size(); ++i)
+		{
+			CheckFunctionScope(scopes[i]);
+		}
+	}
 
-		const Token *tok = scope->classStart;
+	CloseDumpFile();
+}
+
+void CheckTSCNullPointer2::CheckFunctionScope(const Scope* scope)
+{
+	const Token *tok = scope->classStart;
 
-		const Token* end = scope->classEnd;
-		if (tok && end)
+	const Token* end = scope->classEnd;
+	if (tok && end)
+	{
+		end = end->next();
+		for (; tok && tok != end; tok = tok->next())
 		{
-			end = end->next();
-			for (; tok && tok != end; tok = tok->next())
-			{
-				tok = HandleOneToken(tok);
-			}
-			ReportFuncRetNullErrors();
+			tok = HandleOneToken(tok);
+		}
+		ReportFuncRetNullErrors();
+
+		Clear();
+	}
+}
+
+namespace {
+	// keeps the findings of the function a worker is checking
+	class CFunctionErrorLogger : public ErrorLogger
+	{
+	public:
+		CFunctionErrorLogger() : m_errors(nullptr)
+		{
+		}
+
+		void SetErrors(std::list<ErrorLogger::ErrorMessage>* errors)
+		{
+			m_errors = errors;
+		}
+
+		void reportOut(const std::string &)
+		{
+		}
+
+		void reportErr(const ErrorLogger::ErrorMessage &msg)
+		{
+			m_errors->push_back(msg);
+		}
+
+	private:
+		std::list<ErrorLogger::ErrorMessage>* m_errors;
+	};
 
-			Clear();
+	// the check state of one thread, reused for the functions it takes
+	struct SFunctionWorker
+	{
+		CFunctionErrorLogger Logger;
+		CheckTSCNullPointer2 Checker;
+
+		SFunctionWorker(const Tokenizer* tokenizer, const Settings* settings) : Checker(tokenizer, settings, &Logger)
+		{
 		}
+	};
+
+	struct SFunctionResult
+	{
+		std::list<ErrorLogger::ErrorMessage> Errors;
+		// the exception that aborted the check of the function, rethrown by the calling thread
+		std::exception_ptr Failure;
+	};
+
+	struct SFunctionTasks
+	{
+		const std::vector<const Scope*>* Scopes;
+		std::vector<SFunctionWorker*> Workers;
+		std::vector<SFunctionResult> Results;
+	};
+}
+
+void CheckTSCNullPointer2::CheckFunctionScopesParallel(const std::vector<const Scope*>& scopes)
+{
+	const unsigned int jobs = scopes.size() < _settings->_functionJobs ? (unsigned int)scopes.size() : _settings->_functionJobs;
+
+	SFunctionTasks tasks;
+	tasks.Scopes = &scopes;
+	tasks.Results.resize(scopes.size());
+	for (unsigned int i = 0; i < jobs; ++i)
+	{
+		SFunctionWorker* worker = new SFunctionWorker(_tokenizer, _settings);
+		worker->Checker.m_nameVarMap = m_nameVarMap;
+		tasks.Workers.push_back(worker);
 	}
 
-	CloseDumpFile();
+	TaskPool::run(CheckFunctionScopeTask, &tasks, scopes.size(), jobs);
+
+	for (std::size_t i = 0; i < tasks.Workers.size(); ++i)
+	{
+		delete tasks.Workers[i];
+	}
+
+	// same order as the serial check, which stops at the first aborted function
+	for (std::size_t i = 0; i < tasks.Results.size(); ++i)
+	{
+		const SFunctionResult& result = tasks.Results[i];
+		for (std::list<ErrorLogger::ErrorMessage>::const_iterator I = result.Errors.begin(), E = result.Errors.end(); I != E; ++I)
+		{
+			if (_errorLogger)
+				_errorLogger->reportErr(*I);
+			else
+				reportError(*I);
+		}
+		if (result.Failure)
+		{
+			std::rethrow_exception(result.Failure);
+		}
+	}
+}
+
+void CheckTSCNullPointer2::CheckFunctionScopeTask(void* context, unsigned int thread, std::size_t index)
+{
+	SFunctionTasks& tasks = *static_cast<SFunctionTasks*>(context);
+	CheckTSCNullPointer2& check = tasks.Workers[thread]->Checker;
+	SFunctionResult& result = tasks.Results[index];
+
+	tasks.Workers[thread]->Logger.SetErrors(&result.Errors);
+	try
+	{
+		check.CheckFunctionScope((*tasks.Scopes)[index]);
+	}
+	catch (...)
+	{
+		// an exception must not leave a pool thread, whatever it is
+		result.Failure = std::current_exception();
+
+		// the next function of this worker starts from a clean state
+		while (!check.m_stackLocalVars.empty())
+		{
+			check.m_stackLocalVars.pop();
+		}
+		check.Clear();
+	}
 }
 
 void CheckTSCNullPointer2::HandleReturnToken(const Token * tok)
@@ -7392,6 +7531,8 @@ void CheckTSCNullPointer2::checkMissingDerefOperator()
 		E = _tokenizer->getSymbolDatabase()->functionScopes.end(); I != E; ++I)
 	{
 		const Scope* s = *I;
+		if (_tokenizer->isSkippedScope(s))
+			continue;
 		for (const Token* tok = s->classStart, *tokE = s->classEnd; tok && tok != tokE; tok = tok->next())
 		{
 			if (tok->str() != "=")
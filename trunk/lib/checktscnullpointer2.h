@@ -156,7 +156,7 @@ private:
 class CExprValue
 {
 public:
-	static CExprValue EmptyEV;
+	static const CExprValue EmptyEV;
 
 	CExprValue(const SExprLocation& exprLoc, const CValueInfo& value) : m_type(CT_NONE)
 	{
@@ -903,7 +903,7 @@ public:
     
     /** @brief This constructor is used when running checks. */
     CheckTSCNullPointer2(const Tokenizer *tokenizer, const Settings *settings, ErrorLogger *errorLogger)
-    : Check(myName(), tokenizer, settings, errorLogger) {
+    : Check(myName(), tokenizer, settings, errorLogger), m_dump(false), m_lineno(0) {
     }
     
     /** @brief Run checks against the normal token list */
@@ -914,6 +914,11 @@ public:
 
     }
     
+    /** @brief the findings are local to function scopes */
+    bool isFunctionScoped() const {
+        return true;
+    }
+
     /** @brief Run checks against the simplified token list */
     void runSimplifiedChecks(const Tokenizer *tokenizer, const Settings *settings, ErrorLogger *errorLogger) {
 			CheckTSCNullPointer2 CheckTSCNullPointer2(tokenizer, settings, errorLogger);
@@ -935,6 +940,14 @@ private:
 	// the main check method
 	void TSCNullPointerCheck2();
 
+	// check one function scope, the state is cleared afterwards
+	void CheckFunctionScope(const Scope* scope);
+
+	// check the function scopes with --function-jobs= threads, each with its own
+	// worker instance; the findings are reported in the order of scopes
+	void CheckFunctionScopesParallel(const std::vector<const Scope*>& scopes);
+	static void CheckFunctionScopeTask(void* context, unsigned int thread, std::size_t index);
+
 	// check for missingDerefOperator
 	void checkMissingDerefOperator();
 	void reportMissingDerefOperatorError(const SExprLocation& elAssign, const SExprLocation& elCheckNull);
@@ -157,7 +157,7 @@ void CheckUninitVar::check()
 
     // check every executable scope
     for (scope = symbolDatabase->scopeList.begin(); scope != symbolDatabase->scopeList.end(); ++scope) {
-        if (scope->isExecutable()) {
+        if (scope->isExecutable() && !_tokenizer->isSkippedScope(&*scope)) {
             checkScope(&*scope);
         }
     }
@@ -1316,7 +1316,7 @@ void CheckUninitVar::deadPointer()
 
     // check every executable scope
     for (scope = symbolDatabase->scopeList.begin(); scope != symbolDatabase->scopeList.end(); ++scope) {
-        if (!scope->isExecutable())
+        if (!scope->isExecutable() || _tokenizer->isSkippedScope(&*scope))
             continue;
         // Dead pointers..
         for (const Token* tok = scope->classStart; tok != scope->classEnd; tok = tok->next()) {
@@ -45,6 +45,11 @@ public:
         : Check(myName(), tokenizer, settings, errorLogger), bCheckCtor(false),bGoInner(false), bCtorIf(false), tokCaller(nullptr) {
     }
 
+    /** @brief the findings are local to function scopes */
+    bool isFunctionScoped() const {
+        return true;
+    }
+
     /** @brief Run checks against the simplified token list */
     void runSimplifiedChecks(const Tokenizer *tokenizer, const Settings *settings, ErrorLogger *errorLogger) {
         CheckUninitVar checkUninitVar(tokenizer, settings, errorLogger);
@@ -0,0 +1,277 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "codewindows.h"
+
+#include <cctype>
+
+static bool isNameChar(char c)
+{
+    return std::isalnum((unsigned char)c) || c == '_' || c == '$';
+}
+
+CodeWindows::CodeWindows(const std::string &code, std::size_t windowSize)
+    : _code(code)
+{
+    findBodies();
+
+    // consecutive bodies of about windowSize bytes
+    _windows.push_back(0);
+    std::size_t size = 0;
+    for (std::size_t i = 0; i < _bodies.size(); ++i) {
+        if (size > 0 && size >= windowSize) {
+            _windows.push_back(i);
+            size = 0;
+        }
+        size += _bodies[i].end - _bodies[i].head;
+    }
+}
+
+void CodeWindows::getWindow(std::size_t index, std::string &window) const
+{
+    const std::size_t first = _windows[index];
+    const std::size_t last = index + 1 < _windows.size() ? _windows[index + 1] : _bodies.size();
+
+    window.clear();
+    window.reserve(_code.size());
+    std::size_t pos = 0;
+    for (std::size_t i = 0; i < _bodies.size(); ++i) {
+        if (i >= first && i < last)
+            continue;
+        const Body &body = _bodies[i];
+        const std::size_t begin = body.keepHead ? body.open : body.head;
+        window.append(_code, pos, begin - pos);
+        if (body.keepHead)
+            window += ';';
+        appendLines(begin, body.end, window);
+        pos = body.end;
+    }
+    window.append(_code, pos, std::string::npos);
+}
+
+void CodeWindows::findBodies()
+{
+    // nesting inside a function or class body, 0 at namespace level
+    unsigned int depth = 0;
+    bool functionBody = false;
+    Body body;
+
+    // start of the declaration before the next '{' at namespace level
+    std::size_t head = 0;
+    unsigned int parens = 0;
+
+    for (std::size_t pos = 0; pos < _code.size(); ++pos) {
+        const char c = _code[pos];
+
+        // directives such as #file and #endfile
+        if (c == '#' && isLineStart(pos)) {
+            pos = _code.find('\n', pos);
+            if (pos == std::string::npos)
+                break;
+            continue;
+        }
+
+        if (c == '\"' || c == '\'') {
+            pos = skipLiteral(pos);
+            continue;
+        }
+
+        if (depth > 0) {
+            if (c == '{')
+                ++depth;
+            else if (c == '}' && --depth == 0) {
+                if (functionBody) {
+                    body.end = pos + 1;
+                    _bodies.push_back(body);
+                }
+                head = pos + 1;
+                parens = 0;
+            }
+            continue;
+        }
+
+        if (c == '(')
+            ++parens;
+        else if (c == ')' && parens > 0)
+            --parens;
+        else if (c == ';' && parens == 0)
+            head = pos + 1;
+        else if (c == '}') {
+            // end of a namespace
+            head = pos + 1;
+            parens = 0;
+        } else if (c == '{') {
+            bool isBlock = false;
+            bool keepHead = false;
+            functionBody = parens == 0 && isFunctionHead(head, pos, isBlock, keepHead);
+            if (isBlock) {
+                // namespace or extern "C" block, its content is at namespace level
+                head = pos + 1;
+                continue;
+            }
+            body.head = head;
+            body.open = pos;
+            body.keepHead = keepHead;
+            depth = 1;
+        }
+    }
+}
+
+bool CodeWindows::isFunctionHead(std::size_t head, std::size_t open, bool &isBlock, bool &keepHead) const
+{
+    // the tokens of the declaration up to the parameter list
+    std::vector<std::string> tokens;
+    unsigned int parens = 0;
+    bool parameters = false;
+    bool assignment = false;
+    bool functionTry = false;
+
+    for (std::size_t pos = head; pos < open; ++pos) {
+        const char c = _code[pos];
+        if (c == '#' && isLineStart(pos)) {
+            pos = _code.find('\n', pos);
+            if (pos == std::string::npos || pos > open)
+                break;
+            continue;
+        }
+        if (std::isspace((unsigned char)c))
+            continue;
+
+        std::string token;
+        if (c == '\"' || c == '\'') {
+            const std::size_t end = skipLiteral(pos);
+            token = "\"";
+            pos = end;
+        } else if (isNameChar(c)) {
+            const std::size_t begin = pos;
+            while (pos + 1 < open && isNameChar(_code[pos + 1]))
+                ++pos;
+            token = _code.substr(begin, pos + 1 - begin);
+        } else if (c == ':' && pos + 1 < open && _code[pos + 1] == ':') {
+            token = "::";
+            ++pos;
+        } else
+            token = c;
+
+        if (token == "(") {
+            if (parens++ == 0 && !parameters) {
+                parameters = true;
+                tokens.push_back(token);
+            }
+        } else if (token == ")") {
+            if (parens > 0)
+                --parens;
+        } else if (parens == 0) {
+            if (token == "=")
+                assignment = true;
+            else if (token == "try")
+                functionTry = true;
+            if (!parameters)
+                tokens.push_back(token);
+        }
+    }
+
+    if (tokens.empty())
+        return false;
+
+    std::size_t first = 0;
+    if (tokens[0] == "template") {
+        // skip the template parameters
+        int level = 0;
+        for (first = 1; first < tokens.size(); ++first) {
+            if (tokens[first] == "<")
+                ++level;
+            else if (tokens[first] == ">" && --level <= 0) {
+                ++first;
+                break;
+            }
+        }
+        if (first >= tokens.size())
+            return false;
+    }
+
+    if (tokens[first] == "namespace" || (tokens.size() == 2 && tokens[0] == "extern" && tokens[1] == "\"")) {
+        isBlock = true;
+        return false;
+    }
+
+    if (!parameters || assignment || functionTry ||
+        tokens[first] == "class" || tokens[first] == "typedef" || tokens[first] == "namespace")
+        return false;
+
+    // the function name is the last token before the parameters, or the operator
+    std::size_t name = tokens.size() - 1;
+    if (tokens[name] != "(" || name <= first)
+        return false;
+    --name;
+    for (std::size_t i = first; i < tokens.size(); ++i) {
+        if (tokens[i] == "operator")
+            name = i;
+    }
+    if (name > first && tokens[name - 1] == "~")
+        --name;
+
+    // "struct S *f(int i)" is a function returning a struct, while the parentheses of
+    // "struct __attribute__((packed)) S" or "struct S : B<sizeof(int)>" belong to a type definition
+    if (tokens[first] == "struct" || tokens[first] == "union" || tokens[first] == "enum") {
+        if (name < first + 2 || tokens[name] == "__attribute__" || tokens[name] == "__declspec" ||
+            tokens[name] == "alignas" || tokens[name] == "_Alignas")
+            return false;
+        for (std::size_t i = first; i < name; ++i) {
+            if (tokens[i] == ":")
+                return false;
+        }
+    }
+
+    // a qualified name is declared elsewhere, the whole definition is removed
+    keepHead = !(name > first && tokens[name - 1] == "::");
+    return true;
+}
+
+bool CodeWindows::isLineStart(std::size_t pos) const
+{
+    return pos == 0 || _code[pos - 1] == '\n';
+}
+
+std::size_t CodeWindows::skipLiteral(std::size_t pos) const
+{
+    const char quote = _code[pos];
+    for (++pos; pos < _code.size(); ++pos) {
+        if (_code[pos] == '\\')
+            ++pos;
+        else if (_code[pos] == quote)
+            return pos;
+        else if (_code[pos] == '\n')
+            return pos - 1;
+    }
+    return _code.size();
+}
+
+void CodeWindows::appendLines(std::size_t begin, std::size_t end, std::string &window) const
+{
+    for (std::size_t pos = begin; pos < end; ++pos) {
+        if (_code[pos] == '#' && isLineStart(pos)) {
+            std::size_t eol = _code.find('\n', pos);
+            if (eol == std::string::npos || eol > end)
+                eol = end;
+            window.append(_code, pos, eol - pos);
+            pos = eol - 1;
+        } else if (_code[pos] == '\n')
+            window += '\n';
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//---------------------------------------------------------------------------
+#ifndef codewindowsH
+#define codewindowsH
+//---------------------------------------------------------------------------
+
+#include <string>
+#include <vector>
+#include "config.h"
+
+/// @addtogroup Core
+/// @{
+
+/**
+ * @brief Split the preprocessed code of a large configuration into windows
+ * of function bodies (--window-size=).
+ *
+ * The function bodies at namespace level are grouped in order into windows
+ * of about the given size. The code of a window is the whole code with the
+ * bodies of the other windows removed: a function keeps its head as a
+ * declaration, a qualified member function is removed with its head. The
+ * newlines and the #file directives are kept, so line numbers and file
+ * names do not change. Class definitions, global declarations and bodies
+ * that are not recognized are in every window.
+ */
+class TSCANCODELIB CodeWindows {
+public:
+    /**
+     * @brief Find the function bodies of @p code
+     * @param code preprocessed code, must outlive this object
+     * @param windowSize size of the function bodies of a window in bytes
+     */
+    CodeWindows(const std::string &code, std::size_t windowSize);
+
+    /** @brief number of windows, 1 if the code has at most one window of bodies */
+    std::size_t size() const {
+        return _windows.size();
+    }
+
+    /** @brief the code with the function bodies of window @p index only */
+    void getWindow(std::size_t index, std::string &window) const;
+
+private:
+    /** @brief a function definition at namespace level */
+    struct Body {
+        /** @brief start of the declaration */
+        std::size_t head;
+
+        /** @brief position of '{' */
+        std::size_t open;
+
+        /** @brief position after '}' */
+        std::size_t end;
+
+        /** @brief the head declares the function, keep it when the body is removed */
+        bool keepHead;
+    };
+
+    void findBodies();
+    bool isFunctionHead(std::size_t head, std::size_t open, bool &isBlock, bool &keepHead) const;
+    bool isLineStart(std::size_t pos) const;
+    std::size_t skipLiteral(std::size_t pos) const;
+    void appendLines(std::size_t begin, std::size_t end, std::string &window) const;
+
+    const std::string &_code;
+    std::vector<Body> _bodies;
+
+    /** @brief index of the first body of each window */
+    std::vector<std::size_t> _windows;
+};
+
+/// @}
+//---------------------------------------------------------------------------
+#endif // codewindowsH
@@ -0,0 +1,306 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dumpwriter.h"
+
+// The buffer is handed to the stream once it grows past this size
+static const std::size_t DUMP_BUFFER_SIZE = 64 * 1024;
+
+DumpWriter::DumpWriter(std::ostream &out, DUMP_FORMATS format, unsigned int sections)
+    : _out(out)
+    , _format(format)
+    , _sections(sections)
+    , _depth(1)
+{
+    _buf.reserve(DUMP_BUFFER_SIZE + 1024);
+}
+
+DumpWriter::~DumpWriter()
+{
+    flush();
+}
+
+unsigned int DumpWriter::parseSections(const std::string &str)
+{
+    unsigned int sections = 0;
+    std::string::size_type pos = 0;
+    while (pos <= str.size()) {
+        std::string::size_type end = str.find(',', pos);
+        if (end == std::string::npos)
+            end = str.size();
+        const std::string name = str.substr(pos, end - pos);
+        if (name == "tokens")
+            sections |= DUMP_TOKENS;
+        else if (name == "scopes")
+            sections |= DUMP_SCOPES;
+        else if (name == "variables")
+            sections |= DUMP_VARIABLES;
+        else if (name == "values")
+            sections |= DUMP_VALUES;
+        else if (name == "all")
+            sections |= DUMP_ALL;
+        else
+            return 0;
+        pos = end + 1;
+    }
+    return sections;
+}
+
+void DumpWriter::beginDocument(const std::string &cfg)
+{
+    if (_format == DUMP_XML) {
+        _buf += "<?xml version=\"1.0\"?>\n<dump cfg=\"";
+        appendEscaped(cfg);
+        _buf += "\">\n";
+    } else {
+        beginElement("dump");
+        attrStr("cfg", cfg);
+        endElement();
+    }
+    _depth = 1;
+}
+
+void DumpWriter::endDocument()
+{
+    if (_format == DUMP_XML)
+        _buf += "</dump>\n";
+    flush();
+}
+
+void DumpWriter::openList(const char name[])
+{
+    if (_format != DUMP_XML)
+        return;
+    indent();
+    _buf += '<';
+    _buf += name;
+    _buf += ">\n";
+    ++_depth;
+}
+
+void DumpWriter::closeList(const char name[])
+{
+    if (_format == DUMP_XML)
+        closeElement(name);
+}
+
+void DumpWriter::beginElement(const char name[])
+{
+    if (_format == DUMP_XML) {
+        indent();
+        _buf += '<';
+        _buf += name;
+    } else {
+        _buf += "{\"kind\":\"";
+        _buf += name;
+        _buf += '\"';
+    }
+}
+
+void DumpWriter::endElement(bool hasChildren)
+{
+    if (_format == DUMP_XML) {
+        if (hasChildren) {
+            _buf += ">\n";
+            ++_depth;
+        } else
+            _buf += "/>\n";
+    } else
+        _buf += "}\n";
+
+    if (_buf.size() >= DUMP_BUFFER_SIZE)
+        flush();
+}
+
+void DumpWriter::closeElement(const char name[])
+{
+    if (_format != DUMP_XML)
+        return;
+    if (_depth > 0)
+        --_depth;
+    indent();
+    _buf += "</";
+    _buf += name;
+    _buf += ">\n";
+}
+
+void DumpWriter::attrPtr(const char name[], const void *p)
+{
+    attrName(name);
+    if (_format == DUMP_XML) {
+        _buf += '\"';
+        appendPtr(p);
+        _buf += '\"';
+    } else if (p) {
+        _buf += '\"';
+        appendPtr(p);
+        _buf += '\"';
+    } else
+        _buf += "null";
+}
+
+void DumpWriter::attrStr(const char name[], const std::string &str)
+{
+    attrName(name);
+    _buf += '\"';
+    appendEscaped(str);
+    _buf += '\"';
+}
+
+void DumpWriter::attrLit(const char name[], const char value[])
+{
+    attrName(name);
+    _buf += '\"';
+    _buf += value;
+    _buf += '\"';
+}
+
+void DumpWriter::attrInt(const char name[], long long value)
+{
+    attrName(name);
+    if (_format == DUMP_XML) {
+        _buf += '\"';
+        appendInt(value);
+        _buf += '\"';
+    } else
+        appendInt(value);
+}
+
+void DumpWriter::attrBool(const char name[], bool value)
+{
+    attrName(name);
+    if (_format == DUMP_XML)
+        _buf += value ? "\"true\"" : "\"false\"";
+    else
+        _buf += value ? "true" : "false";
+}
+
+void DumpWriter::parent(const char name[], const void *p)
+{
+    if (_format != DUMP_XML)
+        attrPtr(name, p);
+}
+
+void DumpWriter::flush()
+{
+    if (!_buf.empty()) {
+        _out.write(_buf.data(), static_cast<std::streamsize>(_buf.size()));
+        _buf.clear();
+    }
+}
+
+void DumpWriter::indent()
+{
+    _buf.append(2U * _depth, ' ');
+}
+
+void DumpWriter::attrName(const char name[])
+{
+    if (_format == DUMP_XML) {
+        _buf += ' ';
+        _buf += name;
+        _buf += '=';
+    } else {
+        _buf += ",\"";
+        _buf += name;
+        _buf += "\":";
+    }
+}
+
+void DumpWriter::appendInt(long long value)
+{
+    char digits[24];
+    std::size_t pos = sizeof(digits);
+    unsigned long long u = value < 0 ? 0ULL - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+    do {
+        digits[--pos] = static_cast<char>('0' + (u % 10U));
+        u /= 10U;
+    } while (u);
+    if (value < 0)
+        digits[--pos] = '-';
+    _buf.append(digits + pos, sizeof(digits) - pos);
+}
+
+void DumpWriter::appendPtr(const void *p)
+{
+    if (!p) {
+        _buf += '0';
+        return;
+    }
+    static const char hex[] = "0123456789abcdef";
+    char digits[2 * sizeof(void *) + 2];
+    std::size_t pos = sizeof(digits);
+    std::size_t u = reinterpret_cast<std::size_t>(p);
+    while (u) {
+        digits[--pos] = hex[u & 0xfU];
+        u >>= 4;
+    }
+    digits[--pos] = 'x';
+    digits[--pos] = '0';
+    _buf.append(digits + pos, sizeof(digits) - pos);
+}
+
+void DumpWriter::appendEscaped(const std::string &str)
+{
+    // characters in string literals outside ' '..'z' are replaced by 'x'.
+    // JSON must be valid UTF-8, other bytes >= 0x80 are written as \u00XX.
+    static const char hex[] = "0123456789abcdef";
+    const bool isstring = !str.empty() && str[0] == '\"';
+    for (std::size_t i = 0U; i < str.length(); i++) {
+        const char c = str[i];
+        if (_format == DUMP_XML) {
+            switch (c) {
+            case '<':
+                _buf += "&lt;";
+                continue;
+            case '>':
+                _buf += "&gt;";
+                continue;
+            case '&':
+                _buf += "&amp;";
+                continue;
+            case '\"':
+                _buf += "&quot;";
+                continue;
+            default:
+                break;
+            }
+        } else if (c == '\"' || c == '\\') {
+            _buf += '\\';
+            _buf += c;
+            continue;
+        }
+
+        if (c == '\0')
+            _buf += (_format == DUMP_XML) ? "\\0" : "\\\\0";
+        else if (c == 0x1)
+            continue;
+        else if (isstring && (c < ' ' || c > 'z'))
+            _buf += 'x';
+        else if (_format != DUMP_XML && c >= 0 && c < ' ')
+            _buf += ' ';
+        else if (_format != DUMP_XML && c < 0) {
+            const unsigned char u = static_cast<unsigned char>(c);
+            _buf += "\\u00";
+            _buf += hex[u >> 4];
+            _buf += hex[u & 0xfU];
+        }
+        else
+            _buf += c;
+    }
+}
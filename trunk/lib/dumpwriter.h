@@ -0,0 +1,111 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//---------------------------------------------------------------------------
+#ifndef dumpwriterH
+#define dumpwriterH
+//---------------------------------------------------------------------------
+
+#include <string>
+#include <ostream>
+#include "config.h"
+
+enum DUMP_FORMATS {
+    DUMP_XML = 0,
+    DUMP_JSONL
+};
+
+enum DUMP_SECTIONS {
+    DUMP_TOKENS = 1,
+    DUMP_SCOPES = 2,
+    DUMP_VARIABLES = 4,
+    DUMP_VALUES = 8,
+    DUMP_ALL = DUMP_TOKENS | DUMP_SCOPES | DUMP_VARIABLES | DUMP_VALUES
+};
+
+/**
+ * @brief Writer for the --dump output.
+ *
+ * Everything is formatted into one reusable buffer that is handed to the
+ * stream in large blocks, so writing a dump allocates nothing per token or
+ * attribute. With DUMP_JSONL every element becomes one flat JSON record per
+ * line and nesting is expressed through parent() references instead.
+ */
+class TSCANCODELIB DumpWriter {
+public:
+    DumpWriter(std::ostream &out, DUMP_FORMATS format = DUMP_XML, unsigned int sections = DUMP_ALL);
+    ~DumpWriter();
+
+    DUMP_FORMATS format() const {
+        return _format;
+    }
+
+    bool wants(DUMP_SECTIONS section) const {
+        return (_sections & section) != 0;
+    }
+
+    /** @brief parse a comma separated section list, returns 0 if a name is unknown */
+    static unsigned int parseSections(const std::string &str);
+
+    void beginDocument(const std::string &cfg);
+    void endDocument();
+
+    /** @brief open and close a container element, e.g. <tokenlist>. Not written as JSONL. */
+    void openList(const char name[]);
+    void closeList(const char name[]);
+
+    /** @brief start an element, followed by attributes and endElement() */
+    void beginElement(const char name[]);
+
+    /**
+     * @brief finish the element started by beginElement()
+     * @param hasChildren the element is left open and closed by closeElement()
+     */
+    void endElement(bool hasChildren = false);
+    void closeElement(const char name[]);
+
+    void attrPtr(const char name[], const void *p);
+    void attrStr(const char name[], const std::string &str);
+    void attrLit(const char name[], const char value[]);
+    void attrInt(const char name[], long long value);
+    void attrBool(const char name[], bool value);
+
+    /** @brief reference to the enclosing element, only written as JSONL */
+    void parent(const char name[], const void *p);
+
+    void flush();
+
+private:
+    void indent();
+    void attrName(const char name[]);
+    void appendInt(long long value);
+    void appendPtr(const void *p);
+    void appendEscaped(const std::string &str);
+
+    /** no copying */
+    DumpWriter(const DumpWriter &);
+    DumpWriter& operator=(const DumpWriter &);
+
+    std::ostream &_out;
+    std::string _buf;
+    const DUMP_FORMATS _format;
+    const unsigned int _sections;
+    unsigned int _depth;
+};
+
+//---------------------------------------------------------------------------
+#endif // dumpwriterH
@@ -21,11 +21,108 @@
 #include "token.h"
 #include "symboldatabase.h"
 #include <memory>
+#include <new>
 #include <set>
+#include <unordered_map>
 #include <iterator>
 #include <iostream>
 
 
+// every slot starts with a header holding its size, slots are aligned to SLOT_ALIGN
+static const std::size_t SLOT_ALIGN = 16;
+static const std::size_t MAX_SLOT_SIZE = 512;
+static const std::size_t BLOCK_SIZE = 16 * 1024;
+
+ExecutionPathArena::ExecutionPathArena()
+    : _freeLists(MAX_SLOT_SIZE / SLOT_ALIGN + 1, (void *)0), _cur(0), _left(0)
+{
+}
+
+ExecutionPathArena::~ExecutionPathArena()
+{
+    for (std::vector<char *>::const_iterator it = _blocks.begin(); it != _blocks.end(); ++it)
+        ::operator delete(*it);
+}
+
+void *ExecutionPathArena::allocate(std::size_t size)
+{
+    const std::size_t slot = (size + 2 * SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+    char *p;
+    if (slot > MAX_SLOT_SIZE) {
+        p = static_cast<char *>(::operator new(slot));
+    } else if (_freeLists[slot / SLOT_ALIGN]) {
+        p = static_cast<char *>(_freeLists[slot / SLOT_ALIGN]);
+        _freeLists[slot / SLOT_ALIGN] = *reinterpret_cast<void **>(p + SLOT_ALIGN);
+    } else {
+        if (_left < slot) {
+            _cur = static_cast<char *>(::operator new(BLOCK_SIZE));
+            _left = BLOCK_SIZE;
+            _blocks.push_back(_cur);
+        }
+        p = _cur;
+        _cur += slot;
+        _left -= slot;
+    }
+    *reinterpret_cast<std::size_t *>(p) = slot;
+    return p + SLOT_ALIGN;
+}
+
+void ExecutionPathArena::deallocate(void *ptr)
+{
+    char *p = static_cast<char *>(ptr) - SLOT_ALIGN;
+    const std::size_t slot = *reinterpret_cast<const std::size_t *>(p);
+    if (slot > MAX_SLOT_SIZE) {
+        ::operator delete(p);
+    } else {
+        *reinterpret_cast<void **>(ptr) = _freeLists[slot / SLOT_ALIGN];
+        _freeLists[slot / SLOT_ALIGN] = p;
+    }
+}
+
+
+void *ExecutionPath::allocate(std::size_t size) const
+{
+    return arena ? arena->allocate(size) : ::operator new(size);
+}
+
+void ExecutionPath::release(ExecutionPath *c)
+{
+    ExecutionPathArena * const a = c->arena;
+    c->~ExecutionPath();
+    if (a)
+        a->deallocate(c);
+    else
+        ::operator delete(c);
+}
+
+void ExecutionPath::mergeEqual(std::list<ExecutionPath *> &checks)
+{
+    if (checks.size() < 2)
+        return;
+
+    std::unordered_multimap<std::size_t, const ExecutionPath *> seen;
+    for (std::list<ExecutionPath *>::iterator it = checks.begin(); it != checks.end();) {
+        const std::size_t h = (*it)->stateHash();
+        bool duplicate = false;
+        typedef std::unordered_multimap<std::size_t, const ExecutionPath *>::const_iterator SeenIter;
+        const std::pair<SeenIter, SeenIter> range = seen.equal_range(h);
+        for (SeenIter it2 = range.first; it2 != range.second; ++it2) {
+            if (it2->second->sameState(**it)) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) {
+            release(*it);
+            checks.erase(it++);
+        } else {
+            seen.insert(std::make_pair(h, *it));
+            ++it;
+        }
+    }
+}
+
+
 
 // default : bail out if the condition is has variable handling
 bool ExecutionPath::parseCondition(const Token &tok, std::list<ExecutionPath *> & checks)
@@ -47,7 +144,7 @@ bool ExecutionPath::parseCondition(const Token &tok, std::list<ExecutionPath *>
 
     for (std::list<ExecutionPath *>::iterator it = checks.begin(); it != checks.end();) {
         if ((*it)->varId > 0 && (*it)->numberOfIf >= 1) {
-            delete *it;
+            release(*it);
             checks.erase(it++);
         } else {
             ++it;
@@ -91,6 +188,8 @@ static void parseIfSwitchBody(const Token * const tok,
 {
     std::set<unsigned int> countif2;
     std::list<ExecutionPath *> c;
+    typedef std::unordered_multimap<std::size_t, const ExecutionPath *> StateIndex;
+    StateIndex index;
     if (!checks.empty()) {
         std::list<ExecutionPath *>::const_iterator it;
         for (it = checks.begin(); it != checks.end(); ++it) {
@@ -98,29 +197,30 @@ static void parseIfSwitchBody(const Token * const tok,
                 c.push_back((*it)->copy());
             if ((*it)->varId != 0)
                 countif2.insert((*it)->varId);
+            index.insert(std::make_pair((*it)->stateHash(), *it));
         }
     }
     ExecutionPath::checkScope(tok, c);
     while (!c.empty()) {
         if (c.back()->varId == 0) {
-            delete c.back();
+            ExecutionPath::release(c.back());
             c.pop_back();
             continue;
         }
 
         bool duplicate = false;
-        std::list<ExecutionPath *>::const_iterator it;
-        for (it = checks.begin(); it != checks.end(); ++it) {
-            if (*(*it) == *c.back() && (*it)->numberOfIf == c.back()->numberOfIf) {
+        const std::pair<StateIndex::const_iterator, StateIndex::const_iterator> range = index.equal_range(c.back()->stateHash());
+        for (StateIndex::const_iterator it = range.first; it != range.second; ++it) {
+            if (it->second->sameState(*c.back())) {
                 duplicate = true;
-                countif2.erase((*it)->varId);
+                countif2.erase(it->second->varId);
                 break;
             }
         }
         if (!duplicate)
             newchecks.push_back(c.back());
         else
-            delete c.back();
+            ExecutionPath::release(c.back());
         c.pop_back();
     }
 
@@ -134,7 +234,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
     if (!tok || tok->str() == "}" || checks.empty())
         return;
 
-    const std::auto_ptr<ExecutionPath> check(checks.front()->copy());
+    const std::unique_ptr<ExecutionPath, void (*)(ExecutionPath *)> check(checks.front()->copy(), &ExecutionPath::release);
 
     for (; tok; tok = tok->next()) {
         // might be a noreturn function..
@@ -160,7 +260,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
 
         if (tok && Token::simpleMatch(tok, "while (")) {
             // parse condition
-            if (checks.size() > 10 || check->parseCondition(*tok->tokAt(2), checks)) {
+            if (checks.size() > maxPaths || check->parseCondition(*tok->tokAt(2), checks)) {
                 ExecutionPath::bailOut(checks);
                 return;
             }
@@ -206,7 +306,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
 
             if (tok->str() == "switch") {
                 // parse condition
-                if (checks.size() > 10 || check->parseCondition(*tok->next(), checks)) {
+                if (checks.size() > maxPaths || check->parseCondition(*tok->next(), checks)) {
                     ExecutionPath::bailOut(checks);
                     return;
                 }
@@ -236,6 +336,9 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
                     if (countif.find((*it)->varId) != countif.end())
                         (*it)->numberOfIf++;
                 }
+
+                // cases that end in the same state are joined here
+                ExecutionPath::mergeEqual(checks);
             }
             // no switch
             else {
@@ -247,7 +350,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
                 // it is not certain that a for/while will be executed:
                 for (std::list<ExecutionPath *>::iterator it = checks.begin(); it != checks.end();) {
                     if ((*it)->numberOfIf > 0) {
-                        delete *it;
+                        ExecutionPath::release(*it);
                         checks.erase(it++);
                     } else
                         ++it;
@@ -382,7 +485,7 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
                 tok = tok->next();
 
                 // parse condition
-                if (checks.size() > 10 || check->parseCondition(*tok->next(), checks)) {
+                if (checks.size() > maxPaths || check->parseCondition(*tok->next(), checks)) {
                     ExecutionPath::bailOut(checks);
                     ExecutionPath::bailOut(newchecks);
                     return;
@@ -442,12 +545,15 @@ void ExecutionPath::checkScope(const Token *tok, std::list<ExecutionPath *> &che
             // Delete checks that have numberOfIf >= 2
             for (it = checks.begin(); it != checks.end();) {
                 if ((*it)->varId > 0 && (*it)->numberOfIf >= 2) {
-                    delete *it;
+                    ExecutionPath::release(*it);
                     checks.erase(it++);
                 } else {
                     ++it;
                 }
             }
+
+            // branches that end in the same state are joined here
+            ExecutionPath::mergeEqual(checks);
         }
 
 
@@ -488,9 +594,6 @@ void checkExecutionPaths(const SymbolDatabase *symbolDatabase, ExecutionPath *c)
         c->end(checks, i->classEnd);
 
         // Cleanup
-        while (!checks.empty()) {
-            delete checks.back();
-            checks.pop_back();
-        }
+        ExecutionPath::bailOut(checks);
     }
 }
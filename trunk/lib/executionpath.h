@@ -19,13 +19,40 @@
 #ifndef executionpathH
 #define executionpathH
 
+#include <cstddef>
 #include <list>
+#include <vector>
 #include "config.h"
 
 class Token;
 class Check;
 class SymbolDatabase;
 
+/**
+ * Storage for the execution path states of one function.
+ * States are carved out of large blocks and recycled through per-size
+ * free lists, so the copies made for every branch don't hit the heap.
+ * Everything is released at once when the arena goes out of scope.
+ **/
+class TSCANCODELIB ExecutionPathArena {
+public:
+    ExecutionPathArena();
+    ~ExecutionPathArena();
+
+    void *allocate(std::size_t size);
+    void deallocate(void *p);
+
+private:
+    /** No implementation */
+    ExecutionPathArena(const ExecutionPathArena &);
+    void operator=(const ExecutionPathArena &);
+
+    std::vector<char *> _blocks;
+    std::vector<void *> _freeLists;
+    char *_cur;
+    std::size_t _left;
+};
+
 /**
  * Base class for Execution Paths checking
  * An execution path is a linear list of statements. There are no "if"/.. to worry about.
@@ -38,19 +65,39 @@ private:
 protected:
     Check * const owner;
 
+    /** arena the copies of this path are allocated from, 0 => heap */
+    ExecutionPathArena * const arena;
+
     /** Are two execution paths equal? */
     virtual bool is_equal(const ExecutionPath *) const = 0;
 
-public:
-    ExecutionPath(Check *c, unsigned int id) : owner(c), numberOfIf(0), varId(id)
-    { }
+    /**
+     * Hash of the state compared by is_equal(). Paths that are equal must
+     * have the same hash, this is used to merge equal paths at join points.
+     **/
+    virtual std::size_t hash() const {
+        return 0;
+    }
+
+    /** storage for a copy, use as "new (allocate(sizeof(T))) T(*this)" in copy() */
+    void *allocate(std::size_t size) const;
 
     virtual ~ExecutionPath()
     { }
 
+public:
+    ExecutionPath(Check *c, unsigned int id, ExecutionPathArena *a = 0) : owner(c), arena(a), numberOfIf(0), varId(id)
+    { }
+
     /** Implement this in each derived class. This function must create a copy of the current instance */
     virtual ExecutionPath *copy() = 0;
 
+    /** destroy a path created by copy() */
+    static void release(ExecutionPath *c);
+
+    /** max number of parallel execution paths before bailing out */
+    static const std::size_t maxPaths = 32;
+
     /** print checkdata */
     void print() const;
 
@@ -65,7 +112,7 @@ public:
      **/
     static void bailOut(std::list<ExecutionPath *> &checks) {
         while (!checks.empty()) {
-            delete checks.back();
+            release(checks.back());
             checks.pop_back();
         }
     }
@@ -82,7 +129,7 @@ public:
         std::list<ExecutionPath *>::iterator it = checks.begin();
         while (it != checks.end()) {
             if ((*it)->varId == varid) {
-                delete *it;
+                release(*it);
                 checks.erase(it++);
             } else {
                 ++it;
@@ -124,6 +171,22 @@ public:
         return bool(varId == e.varId && is_equal(&e));
     }
 
+    /** hash over varId, numberOfIf and the derived state */
+    std::size_t stateHash() const {
+        return (hash() * 31U + varId) * 31U + numberOfIf;
+    }
+
+    /** same variable, same state and same number of if blocks */
+    bool sameState(const ExecutionPath &e) const {
+        return numberOfIf == e.numberOfIf && *this == e;
+    }
+
+    /**
+     * Merge equal execution paths, the first one of each kind is kept.
+     * @param checks the execution paths
+     **/
+    static void mergeEqual(std::list<ExecutionPath *> &checks);
+
     static void checkScope(const Token *tok, std::list<ExecutionPath *> &checks);
 };
 
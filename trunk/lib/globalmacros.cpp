@@ -4,18 +4,34 @@
 #include "tokenize.h"
 #include "settings.h"
 #include <fstream>
+#include <cstdio>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
 
 char PreprocessorMacro::macroChar = char(1);
 
-G_M_MAP CGlobalMacros::s_global_macros;
+std::vector<M_MAP> CGlobalMacros::s_macroSlots;
+
+G_S_M_MAP CGlobalMacros::s_spilled_macros;
 
 CFileDependTable* CGlobalMacros::s_fileDependTable = nullptr;
 
+std::size_t CGlobalMacros::s_memoryBudget = 0;
+
+std::size_t CGlobalMacros::s_residentSize = 0;
+
 TSC_LOCK CGlobalMacros::MacroLock;
 
-G_T_MAP CGlobalTypedefs::s_global_typedefs;
+std::vector<T_MAP> CGlobalTypedefs::s_typedefSlots;
+
+std::map<CCodeFile*, const SGTypeDefView*> CGlobalTypedefs::s_visible_typedefs;
+
+std::list<SGTypeDefView> CGlobalTypedefs::s_typedef_views;
 
-TSC_LOCK CGlobalTypedefs::TypedefLock;
+std::unordered_set<std::string> CGlobalTypedefs::s_typedef_names;
 
 /**
 * Remove heading and trailing whitespaces from the input parameter.
@@ -136,9 +152,8 @@ void getparams(const std::string &line,
 }
 
 
-bool CGlobalTypedefs::ExtractGTypeDef(TokenList& tokenList, SGTypeDef& gTypedef)
+bool CGlobalTypedefs::ExtractGTypeDef(Token* tok, SGTypeDef& gTypedef)
 {
-	Token* tok = tokenList.front();
 	if (tok->str() != "typedef")
 	{
 		return false;
@@ -327,15 +342,86 @@ bool CGlobalTypedefs::ExtractGTypeDef(TokenList& tokenList, SGTypeDef& gTypedef)
 	return true;
 }
 
+void CGlobalTypedefs::InitSlots(std::size_t fileCount)
+{
+	s_typedefSlots.clear();
+	s_typedefSlots.resize(fileCount);
+}
+
 void CGlobalTypedefs::AddTypedefs(T_MAP& macroMap, CCodeFile* pFile)
 {
-	if (macroMap.empty())
+	if (macroMap.empty() || pFile->GetID() >= s_typedefSlots.size())
 	{
 		return;
 	}
-	TSC_LOCK_ENTER(&TypedefLock);
-	s_global_typedefs[pFile] = macroMap;
-	TSC_LOCK_LEAVE(&TypedefLock);
+	s_typedefSlots[pFile->GetID()].swap(macroMap);
+}
+
+void CGlobalTypedefs::BuildVisibleTypedefs(CFileDependTable* table)
+{
+	s_visible_typedefs.clear();
+	s_typedef_views.clear();
+	s_typedef_names.clear();
+
+	for (std::vector<T_MAP>::const_iterator I = s_typedefSlots.begin(), E = s_typedefSlots.end(); I != E; ++I)
+	{
+		for (T_MAP::const_iterator I2 = I->begin(), E2 = I->end(); I2 != E2; ++I2)
+		{
+			s_typedef_names.insert(I2->first);
+		}
+	}
+
+	std::map<std::vector<const T_MAP*>, const SGTypeDefView*> views;
+	for (CCodeFile* pFile = table->GetFirstFile(); pFile; pFile = pFile->GetNext())
+	{
+		// typedef tables of the files, in the order their typedefs take precedence
+		std::vector<const T_MAP*> layers;
+		std::list<CCodeFile*>& allDepends = pFile->GetAllDepends();
+		for (std::list<CCodeFile*>::iterator I = allDepends.begin(), E = allDepends.end(); I != E; ++I)
+		{
+			if ((*I)->GetID() < s_typedefSlots.size() && !s_typedefSlots[(*I)->GetID()].empty())
+			{
+				layers.push_back(&s_typedefSlots[(*I)->GetID()]);
+			}
+		}
+		if (layers.empty())
+		{
+			continue;
+		}
+
+		const SGTypeDefView*& view = views[layers];
+		if (!view)
+		{
+			s_typedef_views.push_back(SGTypeDefView());
+			s_typedef_views.back().Layers.swap(layers);
+			view = &s_typedef_views.back();
+		}
+		s_visible_typedefs[pFile] = view;
+	}
+}
+
+const SGTypeDef* SGTypeDefView::Find(const std::string& name) const
+{
+	for (std::vector<const T_MAP*>::const_iterator I = Layers.begin(), E = Layers.end(); I != E; ++I)
+	{
+		T_MAP::const_iterator iter = (*I)->find(name);
+		if (iter != (*I)->end())
+		{
+			return &iter->second;
+		}
+	}
+	return NULL;
+}
+
+bool CGlobalTypedefs::IsTypedefName(const std::string& name)
+{
+	return s_typedef_names.count(name) != 0;
+}
+
+const SGTypeDefView* CGlobalTypedefs::GetVisibleTypedefs(CCodeFile* pFile)
+{
+	std::map<CCodeFile*, const SGTypeDefView*>::const_iterator iter = s_visible_typedefs.find(pFile);
+	return iter != s_visible_typedefs.end() ? iter->second : NULL;
 }
 
 void CGlobalTypedefs::DumpTypedef()
@@ -346,16 +432,17 @@ void CGlobalTypedefs::DumpTypedef()
 	CFileDependTable::CreateLogDirectory();
 	ofs.open(Path::toNativeSeparators(sPath).c_str(), std::ios_base::trunc);
 
-	std::map<CCodeFile*, std::map<std::string, SGTypeDef > >::iterator iter = s_global_typedefs.begin();
-	std::map<CCodeFile*, std::map<std::string, SGTypeDef > >::iterator iterEnd = s_global_typedefs.end();
-
-	while (iter != iterEnd)
+	CFileDependTable* table = CGlobalMacros::GetFileTable();
+	for (CCodeFile* pFile = table ? table->GetFirstFile() : NULL; pFile; pFile = pFile->GetNext())
 	{
-		CCodeFile* pFile = iter->first;
-		std::string sFile = pFile ? Path::toNativeSeparators(pFile->GetFullPath()) : "User Defined";
-		ofs << sFile << std::endl;
-		std::map<std::string, SGTypeDef >::iterator iterSub = iter->second.begin();
-		std::map<std::string, SGTypeDef >::iterator iterSubEnd = iter->second.end();
+		if (pFile->GetID() >= s_typedefSlots.size() || s_typedefSlots[pFile->GetID()].empty())
+		{
+			continue;
+		}
+		T_MAP& typedefs = s_typedefSlots[pFile->GetID()];
+		ofs << Path::toNativeSeparators(pFile->GetFullPath()) << std::endl;
+		std::map<std::string, SGTypeDef >::iterator iterSub = typedefs.begin();
+		std::map<std::string, SGTypeDef >::iterator iterSubEnd = typedefs.end();
 		for (;iterSub != iterSubEnd;iterSub++)
 		{
 			std::string sType;
@@ -368,13 +455,137 @@ void CGlobalTypedefs::DumpTypedef()
 			ofs << "\t\t[" << iterSub->second.Name << "] => [" << sType << "]" << std::endl;
 		}
 		ofs << std::endl;
-		iter++;
 	}
 
 	ofs.close();
 }
 
-PreprocessorMacro* CGlobalMacros::FindMacro(const std::string& macroName, CCodeFile* pFile, std::map<std::string, PreprocessorMacro*>& macroBuffer)
+/**
+* Append-only temporary file holding the definitions of spilled macros. It is
+* written while the macros are collected and mapped read-only before lookups start,
+* so the definitions are paged in by the OS on demand.
+*/
+class CMacroSpillFile
+{
+public:
+	CMacroSpillFile() : m_file(nullptr), m_size(0), m_data(nullptr), m_mapped(false)
+#ifdef _WIN32
+		, m_mapping(NULL)
+#endif
+	{
+	}
+
+	~CMacroSpillFile()
+	{
+		Close();
+	}
+
+	bool Append(const std::string& text, SSpilledMacro& entry)
+	{
+		if (!m_file)
+		{
+			m_file = std::tmpfile();
+			if (!m_file)
+				return false;
+		}
+		if (std::fwrite(text.data(), 1, text.size(), m_file) != text.size())
+			return false;
+
+		entry.Offset = m_size;
+		entry.Length = text.size();
+		m_size += text.size();
+		return true;
+	}
+
+	void Map()
+	{
+		if (!m_file || m_data || !m_size)
+			return;
+		std::fflush(m_file);
+
+#ifdef _WIN32
+		HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(m_file));
+		m_mapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m_mapping)
+		{
+			m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+		}
+#else
+		void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fileno(m_file), 0);
+		if (p != MAP_FAILED)
+		{
+			m_data = static_cast<const char*>(p);
+		}
+#endif
+		m_mapped = (m_data != nullptr);
+
+		// no mapping, read it back instead
+		if (!m_data)
+		{
+			char* data = new char[m_size];
+			std::rewind(m_file);
+			if (std::fread(data, 1, m_size, m_file) != m_size)
+			{
+				delete[] data;
+				return;
+			}
+			m_data = data;
+		}
+	}
+
+	void Close()
+	{
+		if (m_data)
+		{
+			if (!m_mapped)
+				delete[] m_data;
+#ifdef _WIN32
+			else
+				UnmapViewOfFile(m_data);
+#else
+			else
+				munmap(const_cast<char*>(m_data), m_size);
+#endif
+		}
+#ifdef _WIN32
+		if (m_mapping)
+			CloseHandle(m_mapping);
+		m_mapping = NULL;
+#endif
+		if (m_file)
+			std::fclose(m_file);
+		m_file = nullptr;
+		m_data = nullptr;
+		m_size = 0;
+		m_mapped = false;
+	}
+
+	const char* Data() const { return m_data; }
+	std::size_t Size() const { return m_size; }
+
+private:
+	FILE* m_file;
+	std::size_t m_size;
+	const char* m_data;
+	bool m_mapped;
+#ifdef _WIN32
+	HANDLE m_mapping;
+#endif
+};
+
+static CMacroSpillFile s_spillFile;
+
+static PreprocessorMacro* LoadSpilledMacro(const SSpilledMacro& entry)
+{
+	const char* data = s_spillFile.Data();
+	if (!data || entry.Offset + entry.Length > s_spillFile.Size())
+	{
+		return NULL;
+	}
+	return new PreprocessorMacro(std::string(data + entry.Offset, entry.Length), Settings::Instance());
+}
+
+PreprocessorMacro* CGlobalMacros::FindMacro(const std::string& macroName, CCodeFile* pFile, std::map<std::string, PreprocessorMacro*>& macroBuffer, std::list<PreprocessorMacro*>& loadedMacros)
 {
 	if (macroBuffer.count(macroName))
 	{
@@ -403,11 +614,28 @@ PreprocessorMacro* CGlobalMacros::FindMacro(const std::string& macroName, CCodeF
 		{
 			continue;
 		}
-		if (s_global_macros.count(*iter))
+		if ((*iter)->GetID() < s_macroSlots.size())
+		{
+			const M_MAP& macros = s_macroSlots[(*iter)->GetID()];
+			M_MAP::const_iterator iterMacro = macros.find(macroName);
+			if (iterMacro != macros.end())
+			{
+				PreprocessorMacro* pMacro = iterMacro->second;
+				macroBuffer[macroName] = pMacro;
+				return pMacro;
+			}
+		}
+		G_S_M_MAP::const_iterator iterSpilled = s_spilled_macros.find(*iter);
+		if (iterSpilled != s_spilled_macros.end())
 		{
-			if (s_global_macros[*iter].count(macroName))
+			S_M_MAP::const_iterator iterMacro = iterSpilled->second.find(macroName);
+			if (iterMacro != iterSpilled->second.end())
 			{
-				PreprocessorMacro* pMacro = s_global_macros[*iter][macroName];
+				PreprocessorMacro* pMacro = LoadSpilledMacro(iterMacro->second);
+				if (pMacro)
+				{
+					loadedMacros.push_back(pMacro);
+				}
 				macroBuffer[macroName] = pMacro;
 				return pMacro;
 			}
@@ -419,26 +647,113 @@ PreprocessorMacro* CGlobalMacros::FindMacro(const std::string& macroName, CCodeF
 
 void CGlobalMacros::Uninitialize()
 {
-	typedef std::map< CCodeFile*, std::map<std::string, PreprocessorMacro *> >::iterator MMI;
+	typedef std::vector<M_MAP>::iterator MMI;
 	typedef std::map<std::string, PreprocessorMacro *>::iterator MI;
-	for (MMI I = s_global_macros.begin(), E = s_global_macros.end(); I != E; ++I)
+	for (MMI I = s_macroSlots.begin(), E = s_macroSlots.end(); I != E; ++I)
 	{
-		for (MI I2 = I->second.begin(), E2 = I->second.end(); I2 != E2; ++I2)
+		for (MI I2 = I->begin(), E2 = I->end(); I2 != E2; ++I2)
 		{
 			PreprocessorMacro* macro = I2->second;
 			delete macro;
 		}
-		I->second.clear();
 	}
-	s_global_macros.clear();
+	std::vector<M_MAP>().swap(s_macroSlots);
+	s_spilled_macros.clear();
+	s_spillFile.Close();
+	s_residentSize = 0;
 	SetFileTable(nullptr);
 }
 
+std::size_t CGlobalMacros::MacroSize(const PreprocessorMacro* macro)
+{
+	std::size_t size = sizeof(PreprocessorMacro) + macro->macro().capacity();
+	for (const Token* tok = macro->tokens(); tok; tok = tok->next())
+	{
+		size += sizeof(Token) + tok->str().capacity();
+	}
+	return size;
+}
+
+void CGlobalMacros::SpillMacros(M_MAP& macroMap, CCodeFile* pFile)
+{
+	S_M_MAP& spilled = s_spilled_macros[pFile];
+	for (M_MAP::iterator I = macroMap.begin(), E = macroMap.end(); I != E; )
+	{
+		SSpilledMacro entry;
+		if (!s_spillFile.Append(I->second->macro(), entry))
+		{
+			++I;
+			continue;
+		}
+		spilled[I->first] = entry;
+		delete I->second;
+		macroMap.erase(I++);
+	}
+}
+
+void CGlobalMacros::InitSlots(std::size_t fileCount)
+{
+	s_macroSlots.clear();
+	s_macroSlots.resize(fileCount);
+}
+
 void CGlobalMacros::AddMacros(M_MAP& macroMap, CCodeFile* pFile)
 {
-	TSC_LOCK_ENTER(&MacroLock);
-	s_global_macros[pFile] = macroMap;
-	TSC_LOCK_LEAVE(&MacroLock);
+	if (pFile->GetID() >= s_macroSlots.size())
+	{
+		for (M_MAP::iterator I = macroMap.begin(), E = macroMap.end(); I != E; ++I)
+		{
+			delete I->second;
+		}
+		macroMap.clear();
+		return;
+	}
+
+	// the spill file and the resident size are shared, the slots are not
+	if (s_memoryBudget)
+	{
+		std::size_t size = 0;
+		for (M_MAP::const_iterator I = macroMap.begin(), E = macroMap.end(); I != E; ++I)
+		{
+			size += MacroSize(I->second);
+		}
+
+		TSC_LOCK_ENTER(&MacroLock);
+		if (s_residentSize + size > s_memoryBudget)
+		{
+			SpillMacros(macroMap, pFile);
+		}
+		else
+		{
+			s_residentSize += size;
+		}
+		TSC_LOCK_LEAVE(&MacroLock);
+	}
+
+	// whatever was not spilled stays in memory
+	s_macroSlots[pFile->GetID()].swap(macroMap);
+}
+
+void CGlobalMacros::MapSpilledMacros()
+{
+	s_spillFile.Map();
+}
+
+void CGlobalMacros::reportSpill()
+{
+	if (s_spilled_macros.empty())
+	{
+		return;
+	}
+
+	std::size_t count = 0;
+	for (G_S_M_MAP::const_iterator I = s_spilled_macros.begin(), E = s_spilled_macros.end(); I != E; ++I)
+	{
+		count += I->second.size();
+	}
+	std::cout << "[Preprocess] [Spill] " << (s_residentSize >> 10) << " KB of macros resident, "
+		<< count << " macros of " << s_spilled_macros.size() << " files spilled, "
+		<< (s_spillFile.Size() >> 10) << " KB on disk" << std::endl;
 }
 
 void CGlobalMacros::reportStatus(int threadIndex, bool bStart, std::size_t fileindex, std::size_t filecount, std::size_t sizedone, std::size_t sizetotal, const std::string& fileName)
@@ -459,28 +774,38 @@ void CGlobalMacros::DumpMacros()
 	CFileDependTable::CreateLogDirectory();
 	ofs.open(Path::toNativeSeparators(sPath).c_str(), std::ios_base::trunc);
 
-	std::map<CCodeFile*, std::map<std::string, PreprocessorMacro *> >::iterator iter = s_global_macros.begin();
-	std::map<CCodeFile*, std::map<std::string, PreprocessorMacro *> >::iterator iterEnd = s_global_macros.end();
-
-	while (iter != iterEnd)
+	for (CCodeFile* pFile = s_fileDependTable ? s_fileDependTable->GetFirstFile() : NULL; pFile; pFile = pFile->GetNext())
 	{
-		CCodeFile* pFile = iter->first;
-		std::string sFile = pFile ? Path::toNativeSeparators(pFile->GetFullPath()) : "User Defined";
-		ofs << sFile << std::endl;
-		std::map<std::string, PreprocessorMacro *>::iterator iterSub = iter->second.begin();
-		std::map<std::string, PreprocessorMacro *>::iterator iterSubEnd = iter->second.end();
+		if (pFile->GetID() >= s_macroSlots.size() || s_macroSlots[pFile->GetID()].empty())
+		{
+			continue;
+		}
+		M_MAP& macros = s_macroSlots[pFile->GetID()];
+		ofs << Path::toNativeSeparators(pFile->GetFullPath()) << std::endl;
+		std::map<std::string, PreprocessorMacro *>::iterator iterSub = macros.begin();
+		std::map<std::string, PreprocessorMacro *>::iterator iterSubEnd = macros.end();
 		for (;iterSub != iterSubEnd;iterSub++)
 		{
 			ofs << "\t\t[" << iterSub->second->macro() << "]" << std::endl;
 		}
 		ofs << std::endl;
-		iter++;
+	}
+
+	const char* spillData = s_spillFile.Data();
+	for (G_S_M_MAP::const_iterator I = s_spilled_macros.begin(), E = s_spilled_macros.end(); spillData && I != E; ++I)
+	{
+		ofs << (I->first ? Path::toNativeSeparators(I->first->GetFullPath()) : "User Defined") << " [spilled]" << std::endl;
+		for (S_M_MAP::const_iterator I2 = I->second.begin(), E2 = I->second.end(); I2 != E2; ++I2)
+		{
+			ofs << "\t\t[" << std::string(spillData + I2->second.Offset, I2->second.Length) << "]" << std::endl;
+		}
+		ofs << std::endl;
 	}
 
 	ofs.close();
 }
 
-std::vector<std::string> PreprocessorMacro::expandInnerMacros(const std::vector<std::string> &params1, std::map<std::string, PreprocessorMacro *> &macroBuffer, CCodeFile* pCodeFile) const
+std::vector<std::string> PreprocessorMacro::expandInnerMacros(const std::vector<std::string> &params1, std::map<std::string, PreprocessorMacro *> &macroBuffer, std::list<PreprocessorMacro*>& loadedMacros, CCodeFile* pCodeFile) const
 {
 	std::string innerMacroName;
 
@@ -513,13 +838,13 @@ std::vector<std::string> PreprocessorMacro::expandInnerMacros(const std::vector<
 			getparams(param, pos, innerparams, num, endFound);
 			if (pos == param.length() - 1 && num == 0 && endFound && innerparams.size() == params1.size()) {
 				// Is inner macro defined?
-				PreprocessorMacro* innerMacro = CGlobalMacros::FindMacro(innerMacroName, pCodeFile, macroBuffer);
+				PreprocessorMacro* innerMacro = CGlobalMacros::FindMacro(innerMacroName, pCodeFile, macroBuffer, loadedMacros);
 				if (innerMacro) {
 					// expand the inner macro
 					std::string innercode;
 					//std::map<std::string,PreprocessorMacro *> innermacros = macroBuffer;
 					//innermacros.erase(innerMacroName);
-					innerMacro->code(innerparams, macroBuffer, innercode, pCodeFile);//ignore TSC
+					innerMacro->code(innerparams, macroBuffer, loadedMacros, innercode, pCodeFile);//ignore TSC
 					params2[ipar] = innercode;
 				}
 			}
@@ -564,7 +889,7 @@ PreprocessorMacro::PreprocessorMacro(const std::string &macro, const Settings* s
 	}
 }
 
-bool PreprocessorMacro::code(const std::vector<std::string> &params2, std::map<std::string, PreprocessorMacro *> &macroBuffer, std::string &macrocode, CCodeFile* pCodeFile) const
+bool PreprocessorMacro::code(const std::vector<std::string> &params2, std::map<std::string, PreprocessorMacro *> &macroBuffer, std::list<PreprocessorMacro*>& loadedMacros, std::string &macrocode, CCodeFile* pCodeFile) const
 {
 	if (_nopar || (_params.empty() && _variadic)) {
 		macrocode = _macro.substr(1 + _macro.find(')'));
@@ -611,7 +936,7 @@ bool PreprocessorMacro::code(const std::vector<std::string> &params2, std::map<s
 	}
 
 	else {
-		const std::vector<std::string> givenparams = expandInnerMacros(params2, macroBuffer, pCodeFile);
+		const std::vector<std::string> givenparams = expandInnerMacros(params2, macroBuffer, loadedMacros, pCodeFile);
 
 		const Token *tok = tokens();
 		while (tok && tok->str() != ")")
@@ -670,7 +995,7 @@ bool PreprocessorMacro::code(const std::vector<std::string> &params2, std::map<s
 
 					// expand nopar macro
 					if (tok->strAt(-1) != "##") {
-						PreprocessorMacro* macro = CGlobalMacros::FindMacro(str, pCodeFile, macroBuffer);
+						PreprocessorMacro* macro = CGlobalMacros::FindMacro(str, pCodeFile, macroBuffer, loadedMacros);
 						if (macro && macro->_macro.find('(') == std::string::npos) {
 							str = macro->_macro;
 							if (str.find(' ') != std::string::npos)
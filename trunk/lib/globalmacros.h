@@ -7,6 +7,9 @@
 
 #include <vector>
 #include <map>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
 #ifdef TSC_THREADING_MODEL_WIN
 #include <windows.h>
 #endif
@@ -47,7 +50,7 @@ private:
 
 	/** @brief expand inner macro */
 	std::vector<std::string> expandInnerMacros(const std::vector<std::string> &params1,
-		std::map<std::string, PreprocessorMacro *> &macroBuffer, CCodeFile* pCodeFile) const;
+		std::map<std::string, PreprocessorMacro *> &macroBuffer, std::list<PreprocessorMacro*>& loadedMacros, CCodeFile* pCodeFile) const;
 
 
 public:
@@ -91,10 +94,11 @@ public:
 	* get expanded code for this macro
 	* @param params2 macro parameters
 	* @param macros macro definitions (recursion)
+	* @param loadedMacros owns the spilled macros paged back while expanding
 	* @param macrocode output string
 	* @return true if the expanding was successful
 	*/
-	bool code(const std::vector<std::string> &params2, std::map<std::string, PreprocessorMacro *> &macroBuffer, std::string &macrocode, CCodeFile* pCodeFile) const;
+	bool code(const std::vector<std::string> &params2, std::map<std::string, PreprocessorMacro *> &macroBuffer, std::list<PreprocessorMacro*>& loadedMacros, std::string &macrocode, CCodeFile* pCodeFile) const;
 
 	/** character that is inserted in expanded macros */
 	static char macroChar;
@@ -103,23 +107,56 @@ public:
 
 
 typedef std::map<std::string, PreprocessorMacro*> M_MAP;
-typedef std::map< CCodeFile*, std::map<std::string, PreprocessorMacro*> > G_M_MAP;
+
+/** definition text of a spilled macro in the spill file */
+struct SSpilledMacro
+{
+	std::size_t Offset;
+	std::size_t Length;
+};
+
+typedef std::map<std::string, SSpilledMacro> S_M_MAP;
+typedef std::map< CCodeFile*, S_M_MAP > G_S_M_MAP;
 
 class TSCANCODELIB CGlobalMacros
 {
 public:
 
 	//void ClearGlobalMacros();
-	static PreprocessorMacro* FindMacro(const std::string& macroName, CCodeFile* pFile, std::map<std::string, PreprocessorMacro*>& macroBuffer);
+	/**
+	* Find a macro visible from @pFile. Spilled macros are paged back as new
+	* objects which are appended to @loadedMacros, the caller deletes them.
+	*/
+	static PreprocessorMacro* FindMacro(const std::string& macroName, CCodeFile* pFile, std::map<std::string, PreprocessorMacro*>& macroBuffer, std::list<PreprocessorMacro*>& loadedMacros);
 
 	static void Uninitialize();
 
+	/**
+	* Create one slot per code file, called before the files are added.
+	* Each file is added by one worker into its own slot, so no lock is
+	* taken unless macros are spilled.
+	*/
+	static void InitSlots(std::size_t fileCount);
+
+	/** move the macros of @pFile into its slot, @macroMap is left empty */
 	static void AddMacros(M_MAP& macroMap, CCodeFile* pFile);
 
 	static void reportStatus(int threadIndex, bool bStart, std::size_t fileindex, std::size_t filecount, std::size_t sizedone, std::size_t sizetotal, const std::string& fileName);
 
 	static void DumpMacros();
 
+	/**
+	* Resident size of the macro definitions in bytes (--memory-budget), once reached
+	* the macros of further files are written to the spill file instead.
+	* 0 keeps everything in memory.
+	*/
+	static void SetMemoryBudget(std::size_t budget) { s_memoryBudget = budget; }
+
+	/** map the spill file for reading, called once all files have been added */
+	static void MapSpilledMacros();
+
+	static void reportSpill();
+
 	static void SetFileTable(CFileDependTable* table)
 	{
 		s_fileDependTable = table;
@@ -131,8 +168,16 @@ public:
 	}
 
 private:
-	static G_M_MAP s_global_macros;
+	static std::size_t MacroSize(const PreprocessorMacro* macro);
+	static void SpillMacros(M_MAP& macroMap, CCodeFile* pFile);
+
+private:
+	// macros of each code file, indexed by CFileBase::GetID()
+	static std::vector<M_MAP> s_macroSlots;
+	static G_S_M_MAP s_spilled_macros;
 	static CFileDependTable* s_fileDependTable;
+	static std::size_t s_memoryBudget;
+	static std::size_t s_residentSize;
 
 public:
 
@@ -147,18 +192,47 @@ struct SGTypeDef
 };
 
 typedef std::map<std::string, SGTypeDef> T_MAP;
-typedef std::map< CCodeFile*, std::map<std::string, SGTypeDef> > G_T_MAP;
+
+// global typedefs visible in a code file, from the file itself and everything it includes.
+// Each layer is the typedef table of one of those files, shared by every file including it.
+struct SGTypeDefView
+{
+	// layers in the order their typedefs take precedence
+	std::vector<const T_MAP*> Layers;
+
+	// NULL if no layer defines the name
+	const SGTypeDef* Find(const std::string& name) const;
+};
 
 class TSCANCODELIB CGlobalTypedefs
 {
 public:
-	static bool ExtractGTypeDef(TokenList& tokenList, SGTypeDef& gTypedef);
+	// tok is the "typedef" token
+	static bool ExtractGTypeDef(Token* tok, SGTypeDef& gTypedef);
 
+	// one slot per code file, called before the files are added
+	static void InitSlots(std::size_t fileCount);
+
+	// move the typedefs of pFile into its slot, without a lock
 	static void AddTypedefs(T_MAP& macroMap, CCodeFile* pFile);
 
-	static void DumpTypedef();
+	// build the visible typedefs of every code file, once all typedefs are added
+	static void BuildVisibleTypedefs(CFileDependTable* table);
+
+	// NULL if no global typedef is visible in the file
+	static const SGTypeDefView* GetVisibleTypedefs(CCodeFile* pFile);
 
+	// is the name a global typedef in any file?
+	static bool IsTypedefName(const std::string& name);
 
-	static G_T_MAP s_global_typedefs;
-	static TSC_LOCK TypedefLock;
+	static void DumpTypedef();
+
+private:
+	// typedefs of each code file, indexed by CFileBase::GetID()
+	static std::vector<T_MAP> s_typedefSlots;
+	static std::map<CCodeFile*, const SGTypeDefView*> s_visible_typedefs;
+	// files with the same typedef headers share one view
+	static std::list<SGTypeDefView> s_typedef_views;
+	// names of all global typedefs, most name tokens are rejected here
+	static std::unordered_set<std::string> s_typedef_names;
 };
@@ -9,6 +9,8 @@
 #include "globaltokenizer.h"
 #include "settings.h"
 #include <stack>
+#include <algorithm>
+#include <functional>
 
 namespace gt
 {
@@ -42,6 +44,7 @@ namespace gt
             return false;
         }
 
+		assert(!m_bFrozen);
 		m_scopeMap[scope->GetName()] = scope;
 		scope->SetParent(this);
 		return true;
@@ -53,6 +56,7 @@ namespace gt
             return false;
         }
         
+        assert(!m_bFrozen);
         m_funcMap.insert(FuncPair(func->GetName(), func));
         func->SetParent(this);
         return true;
@@ -78,13 +82,105 @@ namespace gt
 		return I->second;
     }
 
+	template<typename T>
+	static bool CompareFrozenHash(const std::pair<std::size_t, T*>& entry, std::size_t hash)
+	{
+		return entry.first < hash;
+	}
+
+	template<typename T>
+	static bool CompareFrozenEntry(const std::pair<std::size_t, T*>& e1, const std::pair<std::size_t, T*>& e2)
+	{
+		return e1.first < e2.first;
+	}
+
 	const CScope* CScope::FindChildScope(const std::string& name) const
 	{
-		if (!HasChildScope(name))
+		if (m_bFrozen)
+		{
+			const std::size_t hash = std::hash<std::string>()(name);
+			for (std::vector<std::pair<std::size_t, CScope*> >::const_iterator I = std::lower_bound(m_frozenScopes.begin(), m_frozenScopes.end(), hash, CompareFrozenHash<CScope>),
+				E = m_frozenScopes.end(); I != E && I->first == hash; ++I)
+			{
+				if (I->second->GetName() == name)
+					return I->second;
+			}
 			return nullptr;
+		}
 
 		ScopeCI I = m_scopeMap.find(name);
-		return I->second;
+		return I == m_scopeMap.end() ? nullptr : I->second;
+	}
+
+	void CScope::FindFunctions(const std::string& name, std::vector<CFunction*>& buffer, CFunction* const*& first, CFunction* const*& last) const
+	{
+		first = last = nullptr;
+		if (!m_bFrozen)
+		{
+			buffer.clear();
+			std::pair<FuncCI, FuncCI> range = m_funcMap.equal_range(name);
+			for (FuncCI I = range.first; I != range.second; ++I)
+			{
+				buffer.push_back(I->second);
+			}
+			if (!buffer.empty())
+			{
+				first = &buffer[0];
+				last = first + buffer.size();
+			}
+			return;
+		}
+
+		const std::size_t hash = std::hash<std::string>()(name);
+		std::vector<std::pair<std::size_t, CFunction*> >::const_iterator I = std::lower_bound(m_frozenFuncs.begin(), m_frozenFuncs.end(), hash, CompareFrozenHash<CFunction>);
+		const std::vector<std::pair<std::size_t, CFunction*> >::const_iterator E = m_frozenFuncs.end();
+		while (I != E && I->first == hash && I->second->GetName() != name)
+			++I;
+		if (I == E || I->first != hash)
+			return;
+
+		// the range is handed out as plain pointers into the contiguous function array
+		first = &m_frozenFuncPtrs[I - m_frozenFuncs.begin()];
+		last = first;
+		while (I != E && I->first == hash && I->second->GetName() == name)
+		{
+			++I;
+			++last;
+		}
+	}
+
+	void CScope::Freeze()
+	{
+		for (ScopeCI I = m_scopeMap.begin(), E = m_scopeMap.end(); I != E; ++I)
+		{
+			I->second->Freeze();
+		}
+
+		std::hash<std::string> hasher;
+		m_frozenScopes.clear();
+		m_frozenScopes.reserve(m_scopeMap.size());
+		for (ScopeCI I = m_scopeMap.begin(), E = m_scopeMap.end(); I != E; ++I)
+		{
+			m_frozenScopes.push_back(std::make_pair(hasher(I->first), I->second));
+		}
+		std::stable_sort(m_frozenScopes.begin(), m_frozenScopes.end(), CompareFrozenEntry<CScope>);
+
+		// the multimap keeps functions of one name together and RecordFunc has ordered them,
+		// a stable sort by hash keeps both
+		m_frozenFuncs.clear();
+		m_frozenFuncs.reserve(m_funcMap.size());
+		for (FuncCI I = m_funcMap.begin(), E = m_funcMap.end(); I != E; ++I)
+		{
+			m_frozenFuncs.push_back(std::make_pair(hasher(I->first), I->second));
+		}
+		std::stable_sort(m_frozenFuncs.begin(), m_frozenFuncs.end(), CompareFrozenEntry<CFunction>);
+		m_frozenFuncPtrs.resize(m_frozenFuncs.size());
+		for (std::size_t i = 0; i < m_frozenFuncs.size(); ++i)
+		{
+			m_frozenFuncPtrs[i] = m_frozenFuncs[i].second;
+		}
+
+		m_bFrozen = true;
 	}
     
     CFunction* CScope::TryGetFunc(const CFunction* func)
@@ -267,7 +363,7 @@ namespace gt
 		}
 	}
 
-	void RecursiveDump(std::ofstream& fs, const CScope* scope, unsigned tab)
+	void RecursiveDump(std::ostream& fs, const CScope* scope, unsigned tab)
 	{
 		for (unsigned i = 0; i < tab; ++i)
 		{
@@ -392,7 +488,7 @@ namespace gt
 #endif // TSC2_DUMP_TYPE_TREE
 
 
-	void CScope::Dump(std::ofstream& fs) const
+	void CScope::Dump(std::ostream& fs) const
 	{
 		unsigned tab = 0;
 		RecursiveDump(fs, this, tab);
@@ -753,6 +849,26 @@ namespace gt
 		}
 
 
+		//merge call sites, deref ones are kept only when both agree like the derefed vars
+		std::set<CFuncData::SCallSite>& oldSites = oldData.GetCallSites();
+		const std::set<CFuncData::SCallSite>& newSites = newData.GetCallSites();
+		for (std::set<CFuncData::SCallSite>::iterator I = oldSites.begin(), E = oldSites.end(); I != E; )
+		{
+			if (I->eKind == CFuncData::SCallSite::ckDeref && !newSites.count(*I))
+			{
+				oldSites.erase(I++);
+				continue;
+			}
+			++I;
+		}
+		for (std::set<CFuncData::SCallSite>::const_iterator I = newSites.begin(), E = newSites.end(); I != E; ++I)
+		{
+			if (I->eKind != CFuncData::SCallSite::ckDeref)
+			{
+				oldSites.insert(*I);
+			}
+		}
+
 		std::set<SVarEntry>& oldDeref = m_funcData.GetDerefedVars();
 		const std::set<SVarEntry>& newDeref = newData.GetDerefedVars();
 		
@@ -2422,6 +2538,7 @@ namespace gt
 	{
 		InitFuncRetFlag(gtFunc, func.functionScope);
 		InitFuncDerefedVars(gtFunc, func.functionScope);
+		InitCallSites(func.functionScope);
 		//InitExitFlag(gtFunc, func);
 		InitFunctionData(gtFunc, func);
 		return true;
@@ -2431,6 +2548,7 @@ namespace gt
 	{
 		InitFuncRetFlag(gtFunc, func);
 		InitFuncDerefedVars(gtFunc, func);
+		InitCallSites(func);
 		//InitExitFlag(gtFunc, func);
 		//InitFunctionData(gtFunc, func);
 		return true;
@@ -2516,6 +2634,10 @@ namespace gt
 								// consider as checking null
 								if (Token::Match(tokP, "?|(|,|==|!=|!|&&|%oror%"))
 								{
+									if (pVar->isArgument() && !safeExprList.count(pVar->declarationId()))
+									{
+										HandleDerefCallSite(tok, gtFunc);
+									}
 									safeExprList.insert(pVar->declarationId());
 								}
 								else if (tokP->str() == "=")
@@ -2597,6 +2719,119 @@ namespace gt
 		}
 	}
 
+	// name of the function called by @tokPar, with its "::" qualification
+	static bool GetCallSiteName(const Token* tokPar, std::string& name)
+	{
+		if (!tokPar || tokPar->str() != "(")
+		{
+			return false;
+		}
+		const Token* tokName = tokPar->astOperand1();
+		if (!tokName || tokName->next() != tokPar || !tokName->isName()
+			|| Token::Match(tokName, "if|while|for|switch|return|sizeof|catch|decltype|typeof"))
+		{
+			return false;
+		}
+
+		name = tokName->str();
+		const Token* tok = tokName->previous();
+		if (tok && tok->str() == ".")
+		{
+			// only calls through this, other objects need the type of the object
+			return Token::simpleMatch(tok->previous(), "this");
+		}
+		while (tok && tok->str() == "::")
+		{
+			const Token* tokPrev = tok->previous();
+			if (!tokPrev || Token::Match(tokPrev, "return|throw|case|else|[;{}(),=!?:]|&&|%oror%"))
+			{
+				name = "::" + name;
+				break;
+			}
+			else if (tokPrev->isName())
+			{
+				name = tokPrev->str() + "::" + name;
+				tok = tokPrev->previous();
+			}
+			else
+			{
+				// template or other qualification which can't be resolved by name
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void CFuncData::InitCallSites(const ::Scope* func)
+	{
+		if (!func || !func->classStart)
+		{
+			return;
+		}
+
+		std::string name;
+		// a return, break, throw or goto before a call may skip it
+		bool bMayLeave = false;
+		for (const Token* tok = func->classStart->next(); tok && tok != func->classEnd; tok = tok->next())
+		{
+			if (Token::Match(tok, "return|break|throw|goto"))
+			{
+				bMayLeave = true;
+			}
+
+			if (tok->str() == "return")
+			{
+				const Token* tokCall = tok->astOperand1();
+				if (GetCallSiteName(tokCall, name))
+				{
+					std::vector<const Token*> args;
+					getParamsbyAst(tokCall, args);
+					m_callSites.insert(SCallSite(name, SCallSite::ckReturn, args.size()));
+				}
+			}
+			// a call statement which is always executed
+			else if (!bMayLeave && tok->str() == "(" && !tok->astParent() && tok->scope() == func && GetCallSiteName(tok, name))
+			{
+				std::vector<const Token*> args;
+				getParamsbyAst(tok, args);
+				m_callSites.insert(SCallSite(name, SCallSite::ckExit, args.size()));
+			}
+		}
+	}
+
+	void CFuncData::HandleDerefCallSite(const Token* tok, const CFunction* gtFunc)
+	{
+		const Token* tokCall = tok->astParent();
+		while (tokCall && tokCall->str() == ",")
+		{
+			tokCall = tokCall->astParent();
+		}
+
+		std::string name;
+		if (!GetCallSiteName(tokCall, name))
+		{
+			return;
+		}
+
+		const int paramIndex = gtFunc->GetParamIndex(tok->str());
+		const CVariable* param = gtFunc->GetVariableByIndex(paramIndex);
+		if (!param || param->GetParamName() != tok->str())
+		{
+			return;
+		}
+
+		std::vector<const Token*> args;
+		getParamsbyAst(tokCall, args);
+		for (std::size_t i = 0; i < args.size(); ++i)
+		{
+			if (args[i] == tok)
+			{
+				m_callSites.insert(SCallSite(name, SCallSite::ckDeref, args.size(), (int)i, paramIndex));
+				break;
+			}
+		}
+	}
+
 	const std::set<SVarEntry>& CFuncData::GetDerefedVars() const
 	{
 		return m_derefedVars;
@@ -2665,4 +2900,337 @@ namespace gt
 		
 	}
 
+	// rounds of propagation inside one component, the summaries only grow
+	// so this is a guard rather than a limit which is reached in practice
+	static const unsigned MAX_SCC_ROUNDS = 16;
+
+	CCallGraph::CCallGraph()
+		: m_root(nullptr)
+	{
+
+	}
+
+	void CCallGraph::Clear()
+	{
+		m_nodes.clear();
+		m_nodeIndex.clear();
+		m_edges.clear();
+		m_components.clear();
+		m_recursive.clear();
+		m_levels.clear();
+		m_root = nullptr;
+	}
+
+	void CCallGraph::Build(CScope* root)
+	{
+		Clear();
+		if (!root)
+		{
+			return;
+		}
+		m_root = root;
+
+		CollectFunctions(root);
+
+		m_edges.resize(m_nodes.size());
+		for (std::size_t i = 0; i < m_nodes.size(); ++i)
+		{
+			const std::set<CFuncData::SCallSite>& sites = m_nodes[i]->GetFuncData().GetCallSites();
+			for (std::set<CFuncData::SCallSite>::const_iterator I = sites.begin(), E = sites.end(); I != E; ++I)
+			{
+				CFunction* callee = ResolveCall(m_nodes[i], *I);
+				if (!callee)
+				{
+					continue;
+				}
+				std::map<const CFunction*, std::size_t>::const_iterator iter = m_nodeIndex.find(callee);
+				if (iter != m_nodeIndex.end())
+				{
+					SEdge edge = { &*I, iter->second };
+					m_edges[i].push_back(edge);
+				}
+			}
+		}
+
+		FindSCC();
+	}
+
+	void CCallGraph::CollectFunctions(CScope* scope)
+	{
+		for (ScopeCI I = scope->GetScopeMap().begin(), E = scope->GetScopeMap().end(); I != E; ++I)
+		{
+			CollectFunctions(I->second);
+		}
+
+		for (FuncCI I = scope->GetFunctionMap().begin(), E = scope->GetFunctionMap().end(); I != E; ++I)
+		{
+			if (I->second->HasScope() && !m_nodeIndex.count(I->second))
+			{
+				m_nodeIndex[I->second] = m_nodes.size();
+				m_nodes.push_back(I->second);
+			}
+		}
+	}
+
+	// returns false if @scope has no function named @name, otherwise @callee is the only
+	// function with a body matching @args, or null if there is none or it's overloaded
+	static bool FindCalleeInScope(const CScope* scope, const std::string& name, unsigned args, CFunction*& callee)
+	{
+		std::pair<FuncCI, FuncCI> range = scope->GetFunctionMap().equal_range(name);
+		if (range.first == range.second)
+		{
+			return false;
+		}
+
+		callee = nullptr;
+		for (FuncCI I = range.first; I != range.second; ++I)
+		{
+			CFunction* func = I->second;
+			if (!func->HasScope() || args < func->GetMinArgCount() || args > func->GetArgCount())
+			{
+				continue;
+			}
+			if (callee)
+			{
+				callee = nullptr;
+				break;
+			}
+			callee = func;
+		}
+		return true;
+	}
+
+	CFunction* CCallGraph::ResolveCall(const CFunction* caller, const CFuncData::SCallSite& site) const
+	{
+		const std::string& sCallee = site.sCallee;
+		const bool bGlobal = (0 == sCallee.compare(0, 2, "::"));
+
+		std::vector<std::string> names;
+		std::string::size_type start = bGlobal ? 2 : 0;
+		for (;;)
+		{
+			std::string::size_type pos = sCallee.find("::", start);
+			names.push_back(sCallee.substr(start, pos == std::string::npos ? pos : pos - start));
+			if (pos == std::string::npos)
+			{
+				break;
+			}
+			start = pos + 2;
+		}
+
+		const CScope* scope = bGlobal ? m_root : caller->GetParent();
+		CFunction* callee = nullptr;
+		if (names.size() == 1)
+		{
+			// check in enclosing scopes, the first one knowing the name hides the others
+			while (scope)
+			{
+				if (FindCalleeInScope(scope, names[0], site.nArgs, callee))
+				{
+					return callee;
+				}
+				scope = bGlobal ? nullptr : scope->GetParent();
+			}
+			return nullptr;
+		}
+
+		// find start of qualification
+		if (!bGlobal)
+		{
+			while (scope && scope->GetName() != names[0] && !scope->FindChildScope(names[0]))
+			{
+				scope = scope->GetParent();
+			}
+		}
+		if (scope && (bGlobal || scope->GetName() != names[0]))
+		{
+			scope = scope->FindChildScope(names[0]);
+		}
+		for (std::size_t i = 1; scope && i + 1 < names.size(); ++i)
+		{
+			scope = scope->FindChildScope(names[i]);
+		}
+
+		if (scope)
+		{
+			FindCalleeInScope(scope, names.back(), site.nArgs, callee);
+		}
+		return callee;
+	}
+
+	// Tarjan's algorithm without recursion, call chains can be deep.
+	// Components are completed callees first, so their level is known at once.
+	void CCallGraph::FindSCC()
+	{
+		const std::size_t none = (std::size_t)-1;
+		const std::size_t count = m_nodes.size();
+		std::vector<std::size_t> index(count, none);
+		std::vector<std::size_t> lowLink(count, 0);
+		std::vector<std::size_t> component(count, none);
+		std::vector<bool> onStack(count, false);
+		std::vector<std::size_t> stack;
+		std::vector<int> componentLevel;
+		// node and its next edge to visit
+		std::vector<std::pair<std::size_t, std::size_t> > visit;
+		std::size_t nextIndex = 0;
+
+		for (std::size_t root = 0; root < count; ++root)
+		{
+			if (index[root] != none)
+			{
+				continue;
+			}
+
+			index[root] = lowLink[root] = nextIndex++;
+			stack.push_back(root);
+			onStack[root] = true;
+			visit.push_back(std::make_pair(root, (std::size_t)0));
+
+			while (!visit.empty())
+			{
+				const std::size_t v = visit.back().first;
+				if (visit.back().second < m_edges[v].size())
+				{
+					const std::size_t w = m_edges[v][visit.back().second++].nCallee;
+					if (index[w] == none)
+					{
+						index[w] = lowLink[w] = nextIndex++;
+						stack.push_back(w);
+						onStack[w] = true;
+						visit.push_back(std::make_pair(w, (std::size_t)0));
+					}
+					else if (onStack[w])
+					{
+						lowLink[v] = TSC_MIN(lowLink[v], index[w]);
+					}
+					continue;
+				}
+
+				visit.pop_back();
+				if (!visit.empty())
+				{
+					const std::size_t u = visit.back().first;
+					lowLink[u] = TSC_MIN(lowLink[u], lowLink[v]);
+				}
+				if (lowLink[v] != index[v])
+				{
+					continue;
+				}
+
+				const std::size_t c = m_components.size();
+				m_components.push_back(std::vector<std::size_t>());
+				std::vector<std::size_t>& members = m_components.back();
+				std::size_t w;
+				do
+				{
+					w = stack.back();
+					stack.pop_back();
+					onStack[w] = false;
+					component[w] = c;
+					members.push_back(w);
+				} while (w != v);
+
+				// components without edges have nothing to solve and aren't scheduled
+				int level = -1;
+				bool bRecursive = members.size() > 1;
+				for (std::vector<std::size_t>::const_iterator I = members.begin(), E = members.end(); I != E; ++I)
+				{
+					for (std::vector<SEdge>::const_iterator I2 = m_edges[*I].begin(), E2 = m_edges[*I].end(); I2 != E2; ++I2)
+					{
+						const std::size_t cw = component[I2->nCallee];
+						if (cw == c)
+						{
+							bRecursive = true;
+							level = TSC_MAX(level, 0);
+						}
+						else
+						{
+							level = TSC_MAX(level, componentLevel[cw] + 1);
+						}
+					}
+				}
+				componentLevel.push_back(level);
+				m_recursive.push_back(bRecursive);
+				if (level >= 0)
+				{
+					if (m_levels.size() <= (std::size_t)level)
+					{
+						m_levels.resize(level + 1);
+					}
+					m_levels[level].push_back(c);
+				}
+			}
+		}
+	}
+
+	bool CCallGraph::ApplyEdge(CFunction* caller, const SEdge& edge) const
+	{
+		CFuncData& data = caller->GetFuncData();
+		const CFuncData& calleeData = m_nodes[edge.nCallee]->GetFuncData();
+		const CFuncData::SCallSite& site = *edge.pSite;
+
+		switch (site.eKind)
+		{
+		case CFuncData::SCallSite::ckReturn:
+			if (calleeData.GetFuncRetNull() == CFuncData::fNull && data.GetFuncRetNull() != CFuncData::fNull)
+			{
+				data.SetRetNullFlag(CFuncData::fNull);
+				return true;
+			}
+			break;
+		case CFuncData::SCallSite::ckExit:
+			if (calleeData.GetExitFlag() == CFuncData::fExit && data.GetExitFlag() != CFuncData::fExit)
+			{
+				data.SetExitFlag(CFuncData::fExit);
+				return true;
+			}
+			break;
+		case CFuncData::SCallSite::ckDeref:
+			{
+				const CVariable* param = site.iParamIndex < 0 ? nullptr : caller->GetVariableByIndex(site.iParamIndex);
+				if (!param)
+				{
+					break;
+				}
+				const std::set<SVarEntry>& calleeDeref = calleeData.GetDerefedVars();
+				for (std::set<SVarEntry>::const_iterator I = calleeDeref.begin(), E = calleeDeref.end(); I != E; ++I)
+				{
+					if (I->eType == Argument && I->iParamIndex == site.iArgIndex)
+					{
+						return data.GetDerefedVars().insert(SVarEntry(param->GetParamName(), Argument, site.iParamIndex)).second;
+					}
+				}
+			}
+			break;
+		default:
+			break;
+		}
+		return false;
+	}
+
+	void CCallGraph::SolveComponent(std::size_t level, std::size_t index)
+	{
+		const std::size_t c = m_levels[level][index];
+		const std::vector<std::size_t>& members = m_components[c];
+		for (unsigned round = 0; round < MAX_SCC_ROUNDS; ++round)
+		{
+			bool bChanged = false;
+			for (std::vector<std::size_t>::const_iterator I = members.begin(), E = members.end(); I != E; ++I)
+			{
+				const std::vector<SEdge>& edges = m_edges[*I];
+				for (std::vector<SEdge>::const_iterator I2 = edges.begin(), E2 = edges.end(); I2 != E2; ++I2)
+				{
+					if (ApplyEdge(m_nodes[*I], *I2))
+					{
+						bChanged = true;
+					}
+				}
+			}
+			if (!bChanged || !m_recursive[c])
+			{
+				break;
+			}
+		}
+	}
+
 };
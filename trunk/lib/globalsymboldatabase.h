@@ -208,6 +208,40 @@ namespace gt
 				return os;
 			}
 		}; 
+
+		// a call in the function body which carries the callee's summary into this one,
+		// resolved against the merged data by CCallGraph
+		struct SCallSite
+		{
+			enum Kind
+			{
+				ckReturn,	// return callee(...);
+				ckExit,		// callee(...); in the outermost block
+				ckDeref,	// unchecked param @iParamIndex passed as argument @iArgIndex
+			};
+			std::string sCallee; // "::" qualified as written
+			Kind eKind;
+			unsigned nArgs;
+			int iArgIndex;
+			int iParamIndex;
+
+			SCallSite(const std::string& callee, Kind kind, unsigned args, int argIndex = -1, int paramIndex = -1)
+				: sCallee(callee), eKind(kind), nArgs(args), iArgIndex(argIndex), iParamIndex(paramIndex)
+			{}
+
+			bool operator < (const SCallSite& other) const
+			{
+				if (eKind != other.eKind)
+					return eKind < other.eKind;
+				if (sCallee != other.sCallee)
+					return sCallee < other.sCallee;
+				if (nArgs != other.nArgs)
+					return nArgs < other.nArgs;
+				if (iArgIndex != other.iArgIndex)
+					return iArgIndex < other.iArgIndex;
+				return iParamIndex < other.iParamIndex;
+			}
+		};
 		
 
 		explicit CFuncData();
@@ -221,6 +255,8 @@ namespace gt
 		void InitFunctionData(CFunction* gtFunc, const ::Function &func);
 
 		void HandleDerefTok(const Token* tok, std::set<unsigned>& safeExprList, const CFunction* gtFunc);
+		void InitCallSites(const ::Scope* func);
+		void HandleDerefCallSite(const Token* tok, const CFunction* gtFunc);
 
 
 		void SetRetNullFlag(RetNullFlag flag){ m_flagRetNull = flag; }
@@ -239,6 +275,8 @@ namespace gt
 		void SetOutScopeVarState(const std::set<SOutScopeVarState>& vVar) { m_vOutScopeVar = vVar; }
 		void AssignThis(bool bAssign) { m_bAssignThis = bAssign; }
 		bool AssignThis() const { return m_bAssignThis != 0; }
+		const std::set<SCallSite>& GetCallSites() const { return m_callSites; }
+		std::set<SCallSite>& GetCallSites() { return m_callSites; }
 	private:
 		//int foo(T** t) || (T*& t)
 		//return value is xxx means param at @index is not null
@@ -248,6 +286,7 @@ namespace gt
 		//outter scope variable made null or not null by this function
 		std::set<SOutScopeVarState> m_vOutScopeVar;
 		std::set<SVarEntry> m_derefedVars;
+		std::set<SCallSite> m_callSites;
 		RetNullFlag   m_flagRetNull : 8;
 		ExitFlag      m_flagExit : 7;
 		unsigned int  m_bAssignThis : 1;
@@ -267,7 +306,7 @@ namespace gt
 		};
 	public:
 		explicit CScope(Kind kind, const std::string& name)
-			: m_name(name), m_parent(nullptr), m_kind(kind), m_needInit(Type::Unknown)
+			: m_name(name), m_parent(nullptr), m_kind(kind), m_needInit(Type::Unknown), m_bFrozen(false)
 		{
 
 		}
@@ -321,6 +360,15 @@ namespace gt
 
 		const CScope* FindChildScope(const std::string& name) const;
 
+		// build the read-only lookup index of this scope and its children, no scope
+		// or function may be added afterwards. The check pass only reads frozen data.
+		void Freeze();
+		bool IsFrozen() const { return m_bFrozen; }
+
+		// functions named @name as a contiguous range. Before the scope is frozen they
+		// are looked up in the function map and the range points into @buffer.
+		void FindFunctions(const std::string& name, std::vector<CFunction*>& buffer, CFunction* const*& first, CFunction* const*& last) const;
+
 		const std::multimap<std::string, CFunction*>& GetFunctionMap() const
 		{
 			return m_funcMap;
@@ -378,7 +426,7 @@ namespace gt
 			return s;
 		}
 
-		void Dump(std::ofstream& fs) const;
+		void Dump(std::ostream& fs) const;
 
 	protected:
 		virtual void InitScopeMap(std::multimap<std::string, CScope*>& globalMap);
@@ -397,6 +445,12 @@ namespace gt
 		Kind m_kind;
 		std::set<std::string> m_usingList;
 		Type::NeedInitialization m_needInit;
+
+		// frozen index, sorted by name hash, entries of one name are adjacent
+		std::vector<std::pair<std::size_t, CScope*> > m_frozenScopes;
+		std::vector<std::pair<std::size_t, CFunction*> > m_frozenFuncs;
+		std::vector<CFunction*> m_frozenFuncPtrs;
+		bool m_bFrozen;
 	};
 
 	class CGlobalScope : public CScope
@@ -773,6 +827,47 @@ namespace gt
 		CScope* m_gtType;
 		Type::NeedInitialization m_needInit;
 	};
+
+	/**
+	 * Call graph of the merged functions, condensed into strongly connected components.
+	 * A component only calls components of lower levels, so all components of one level
+	 * can be solved in parallel once the previous levels are done.
+	 */
+	class TSCANCODELIB CCallGraph
+	{
+	public:
+		CCallGraph();
+
+		void Build(CScope* root);
+		void Clear();
+
+		std::size_t GetLevelCount() const { return m_levels.size(); }
+		std::size_t GetComponentCount(std::size_t level) const { return m_levels[level].size(); }
+
+		// propagate callee summaries into the functions of a component, until nothing changes
+		void SolveComponent(std::size_t level, std::size_t index);
+
+	private:
+		struct SEdge
+		{
+			const CFuncData::SCallSite* pSite;
+			std::size_t nCallee;
+		};
+
+		void CollectFunctions(CScope* scope);
+		CFunction* ResolveCall(const CFunction* caller, const CFuncData::SCallSite& site) const;
+		void FindSCC();
+		bool ApplyEdge(CFunction* caller, const SEdge& edge) const;
+
+	private:
+		std::vector<CFunction*> m_nodes;
+		std::map<const CFunction*, std::size_t> m_nodeIndex;
+		std::vector<std::vector<SEdge> > m_edges;
+		std::vector<std::vector<std::size_t> > m_components;
+		std::vector<bool> m_recursive;
+		std::vector<std::vector<std::size_t> > m_levels;
+		CScope* m_root;
+	};
 };
 
 
@@ -11,7 +11,10 @@
 #include "settings.h"
 #include "filedepend.h"
 #include "path.h"
+#include "workcounters.h"
+#include "sideoutput.h"
 #include <fstream>
+#include <sstream>
 #ifdef USE_GLOE
 #include "glog/logging.h"
 #endif // USE_GLOE
@@ -40,91 +43,82 @@ CGlobalTokenizer* CGlobalTokenizer::Instance()
     return s_instance;
 }
 
-void CGlobalTokenizer::Merge(bool dump)
+void CGlobalTokenizer::OpenSideOutputs()
 {
-	bool bRecordFuncInfo = Settings::Instance()->recordFuncinfo();
-	if (bRecordFuncInfo)
+	const Settings* settings = Settings::Instance();
+	if (settings->recordFuncinfo())
+	{
+		SideOutput::open(SIDE_OUTPUT_FUNCINFO, "funcinfo.txt");
+	}
+	if (settings->checkLua())
 	{
-		//clear file before content is written
-		std::ofstream myFuncinfo("funcinfo.txt", std::ios::trunc);
+		SideOutput::open(SIDE_OUTPUT_LUA_EXPORT, settings->luaPath + "/cpp.lua.exp");
 	}
+	if (settings->debugDumpGlobal)
+	{
+		CFileDependTable::CreateLogDirectory();
+		SideOutput::open(SIDE_OUTPUT_GLOBAL_DUMP, CFileDependTable::GetProgramDirectory() + "log/gt_data_");
+	}
+}
+
+void CGlobalTokenizer::Merge(bool dump)
+{
+	unsigned index = 0;
     for (std::map<void*, CGlobalTokenizeData*>::iterator I = m_threadData.begin(), E = m_threadData.end(); I != E; ++I) 
 	{
 		if (dump)
 		{
-			static unsigned index = 0;
-			CFileDependTable::CreateLogDirectory();
-			std::stringstream ss;
-			ss << CFileDependTable::GetProgramDirectory();
-			ss << "log/gt_data_" << index++ << ".log";
-			I->second->Dump(ss.str().c_str());
+			std::ostringstream data;
+			I->second->Dump(data);
+			std::ostringstream key;
+			key << index++ << ".log";
+			SideOutput::append(SIDE_OUTPUT_GLOBAL_DUMP, key.str(), data.str());
 		}
 
         m_oneData.Merge(*(I->second));
-		if (bRecordFuncInfo)
-		{
-			I->second->DumpFuncinfo();
-		}
-		if (Settings::Instance()->checkLua()) {
-			I->second->MergeLuaInfoToOneData(m_oneLuaData, m_oneData.GetExportClass());
-		}
 		SAFE_DELETE(I->second);
     }
     m_threadData.clear();
 
+	// funcinfo.txt, cpp.lua.exp and the dumps are merged and written while the global data is completed
+	SideOutput::flush();
+
 	m_oneData.RelateTypeInfo();
 
 
 	const_cast<gt::CGlobalScope*>(m_oneData.GetData())->RecordFunc();
-	//	dump info for lua
-	if (Settings::Instance()->checkLua())
-	{
-		std::ofstream myLuainfo(Settings::Instance()->luaPath+"/cpp.lua.exp", std::ios::out);
-		if (myLuainfo)
-		{
-			for (std::set<std::string>::const_iterator iter = m_oneLuaData.begin(), end = m_oneLuaData.end(); iter != end; ++iter)
-			{
-				myLuainfo << "[exp]" << *iter << "\n";
-			}
-			for (std::set<std::string>::const_iterator iter = m_oneData.GetExportClass().begin(), end = m_oneData.GetExportClass().end();
-				iter != end; ++iter)
-			{
-				myLuainfo << "[lua.exp.cls]" << *iter << "\n";
-			}
-			m_oneData.GetExportClass().clear();
-			m_oneLuaData.clear();
-		}
-	}
-
-
-
-
-
+	// the merged data is read-only from here on, worker threads look it up without locking
+	const_cast<gt::CGlobalScope*>(m_oneData.GetData())->Freeze();
+	m_callGraph.Build(const_cast<gt::CGlobalScope*>(m_oneData.GetData()));
+}
 
-	if (dump)
-	{
-		std::stringstream ss;
-		ss << CFileDependTable::GetProgramDirectory();
-		ss << "log/gt_data_merged.log";
-		m_oneData.Dump(ss.str().c_str());
-	}
+void CGlobalTokenizer::DumpMergedData()
+{
+	std::stringstream ss;
+	ss << CFileDependTable::GetProgramDirectory();
+	ss << "log/gt_data_merged.log";
+	m_oneData.Dump(ss.str().c_str());
 }
 
 
 
 CGlobalTokenizeData* CGlobalTokenizer::GetGlobalData(void* pKey)
 {
-	if (!m_threadData.count(pKey))
+	// threads register their data while others are already looking up theirs
+	TSC_LOCK_ENTER(&m_lock);
+	CGlobalTokenizeData*& data = m_threadData[pKey];
+	if (!data)
 	{
-		m_threadData[pKey] = new CGlobalTokenizeData;
+		data = new CGlobalTokenizeData;
 	}
+	TSC_LOCK_LEAVE(&m_lock);
 	
-    return m_threadData[pKey];
+    return data;
 }
 
 CGlobalTokenizer::CGlobalTokenizer() : m_bAnalyze(false)
 {
-    
+	TSC_LOCK_INIT(&m_lock);
 }
 
 CGlobalTokenizer::~CGlobalTokenizer()
@@ -133,7 +127,7 @@ CGlobalTokenizer::~CGlobalTokenizer()
 	{
 		SAFE_DELETE(I->second);
 	}
-	
+	TSC_LOCK_DELETE(&m_lock);
 }
 
 gt::CFuncData::RetNullFlag CGlobalTokenizer::CheckFuncReturnNull(const Token* tokFunc)
@@ -429,40 +423,35 @@ const gt::CFunction* CGlobalTokenizer::FindFunction(const gt::CScope* gtScope, c
 	if (!end)
 		return nullptr;
 
-	std::vector<const Token *> arguments;
-
-	// find all the arguments for this function call
+	// count the arguments for this function call
+	std::size_t args = 0;
 	const Token *arg = tok->tokAt(2);
 	while (arg && arg != end) {
-		arguments.push_back(arg);
+		++args;
 		arg = arg->nextArgument();
 	}
 
-	std::vector<const gt::CFunction *> matches;
-
-	const std::multimap<std::string, gt::CFunction*>& functionMap = gtScope->GetFunctionMap();
-
-	// find all the possible functions that could match
-	const std::size_t args = arguments.size();
-	for (std::multimap<std::string, gt::CFunction*>::const_iterator it = functionMap.find(tok->str());
-	it != functionMap.end() && it->first == tok->str(); ++it)
+	// the first possible function is the match
+	std::vector<gt::CFunction*> unfrozen;
+	gt::CFunction* const* it;
+	gt::CFunction* const* itEnd;
+	gtScope->FindFunctions(tok->str(), unfrozen, it, itEnd);
+	for (; it != itEnd; ++it)
 	{
-		const gt::CFunction *func = it->second;
+		const gt::CFunction *func = *it;
 
 		if (args == func->GetArgCount() || (args < func->GetArgCount() && args >= func->GetMinArgCount()))
 		{
 			if (!requireScope || func->HasScope())
 			{
-				matches.push_back(func);
+				return func;
 			}
 		}
 	}
 
-	if (matches.empty())
-	{
-		// check in base classes
-		FindFunctionInBase(gtScope, tok, args, requireScope, matches);
-	}
+	// check in base classes
+	std::vector<const gt::CFunction *> matches;
+	FindFunctionInBase(gtScope, tok, args, requireScope, matches);
 	
 	if (matches.empty()) 
 	{
@@ -481,20 +470,8 @@ const gt::CScope* CGlobalTokenizer::FindScope(const Scope* scope, const std::lis
 		return nullptr;
 	}
 
-	std::list<std::string> typeList;
-	while (scope)
-	{
-		typeList.push_front(scope->className);
-		scope = scope->nestedIn;
-	}
-	if (!missedScope.empty())
-		typeList.insert(typeList.end(), missedScope.begin(), missedScope.end());
-
-	const gt::CScope* gtScope = m_oneData.GetData();
-	std::list<std::string>::const_iterator I = typeList.begin(), E = typeList.end();
-	if (*I == emptyString)
-		++I;
-	for (; gtScope && I != E; ++I)
+	const gt::CScope* gtScope = FindNestedScope(scope);
+	for (std::list<std::string>::const_iterator I = missedScope.begin(), E = missedScope.end(); gtScope && I != E; ++I)
 	{
 		gtScope = gtScope->FindChildScope(*I);
 	}
@@ -502,6 +479,18 @@ const gt::CScope* CGlobalTokenizer::FindScope(const Scope* scope, const std::lis
 	return gtScope;
 }
 
+const gt::CScope* CGlobalTokenizer::FindNestedScope(const Scope* scope) const
+{
+	if (!scope->nestedIn)
+	{
+		const gt::CScope* gtScope = m_oneData.GetData();
+		return scope->className.empty() ? gtScope : gtScope->FindChildScope(scope->className);
+	}
+
+	const gt::CScope* gtScope = FindNestedScope(scope->nestedIn);
+	return gtScope ? gtScope->FindChildScope(scope->className) : nullptr;
+}
+
 void CGlobalTokenizer::FindFunctionInBase(const gt::CScope* gtScope, const Token* tok, size_t args, bool requireScope, std::vector<const gt::CFunction *> & matches, int level) const
 {
 	if (gtScope->GetKind() != gt::CScope::Type)
@@ -513,7 +502,6 @@ void CGlobalTokenizer::FindFunctionInBase(const gt::CScope* gtScope, const Token
 		const gt::CScope* parentScope = gtType->GetParent();
 		if (parentScope)
 		{
-			const std::map<std::string, gt::CScope*>& scopeMap = parentScope->GetScopeMap();
 			const std::set< std::string >& derived = gtType->GetDerived();
 
 			for (std::set< std::string >::const_iterator I = derived.begin(), E = derived.end(); I != E; ++I)
@@ -523,16 +511,15 @@ void CGlobalTokenizer::FindFunctionInBase(const gt::CScope* gtScope, const Token
 				{
 					continue;
 				}
-				std::map<std::string, gt::CScope*>::const_iterator I2 = scopeMap.find(sDerived);
-				if (I2 != scopeMap.end())
+				if (const gt::CScope* gtScope2 = parentScope->FindChildScope(sDerived))
 				{
-					gt::CScope* gtScope2 = I2->second;
-					const std::multimap<std::string, gt::CFunction*>& functionMap = gtScope2->GetFunctionMap();
-
-					for (std::multimap<std::string, gt::CFunction*>::const_iterator it = functionMap.find(tok->str());
-					it != functionMap.end() && it->first == tok->str(); ++it)
+					std::vector<gt::CFunction*> unfrozen;
+					gt::CFunction* const* it;
+					gt::CFunction* const* itEnd;
+					gtScope2->FindFunctions(tok->str(), unfrozen, it, itEnd);
+					for (; it != itEnd; ++it)
 					{
-						const gt::CFunction *func = it->second;
+						const gt::CFunction *func = *it;
 						if (args == func->GetArgCount() || (args < func->GetArgCount() && args >= func->GetMinArgCount())) 
 						{
 							if (!requireScope || func->HasScope())
@@ -561,10 +548,12 @@ void CGlobalTokenizer::FindFunctionInBase(const gt::CScope* gtScope, const Token
 
 const gt::CFunction* CGlobalTokenizer::FindFunctionWrapper(const Token* tokFunc) const
 {
+	WorkCounters::add(WORK_FINDFUNCTION_LOOKUPS);
 	Token* tok = const_cast<Token*>(tokFunc);
 	const gt::CFunction* gtFunc = tok->GetTokenEx().GetGtFunc();
 	if (gtFunc)
 	{
+		WorkCounters::add(WORK_FINDFUNCTION_CACHE_HITS);
 		return gtFunc;
 	}
 	
@@ -1146,12 +1135,17 @@ void CGlobalTokenizeData::Dump(const char* szPath) const
 	if (fs.bad())
 		return;
 
-	fs << "[Global Types]" << std::endl;
-	m_data->Dump(fs);
+	Dump(fs);
 
 	fs.close();
 }
 
+void CGlobalTokenizeData::Dump(std::ostream& fs) const
+{
+	fs << "[Global Types]" << std::endl;
+	m_data->Dump(fs);
+}
+
 
 const gt::CFunction* CGlobalTokenizer::FindFunctionData(const Token* tokFunc)
 {
@@ -1662,6 +1656,10 @@ CGlobalErrorList::~CGlobalErrorList()
 
 void CGlobalTokenizeData::RecordFuncInfo(const Tokenizer* tokenizer, const std::string &strFileName)
 {
+	if (!SideOutput::isOpen(SIDE_OUTPUT_FUNCINFO)) {
+		return;
+	}
+
 	const SymbolDatabase * const symbolDatabase = tokenizer->getSymbolDatabase();
 
 	const std::size_t functions = symbolDatabase->functionScopes.size();
@@ -1683,12 +1681,11 @@ void CGlobalTokenizeData::RecordFuncInfo(const Tokenizer* tokenizer, const std::
 			//fileindex==0
 			if (startline>0 && endline>0)
 			{
-				FUNCINFO temp;
-				temp.filename = tokenizer->list.file(tok); 
-				ErrorLogger::GetScopeFuncInfo(scope, temp.functionname);
-				temp.startline = startline;
-				temp.endline = endline;
-				m_funcInfoList.push_back(temp);
+				std::string functionname;
+				ErrorLogger::GetScopeFuncInfo(scope, functionname);
+				std::ostringstream line;
+				line << tokenizer->list.file(tok) << "#bebe#" << functionname << "#bebe#" << startline << "#bebe#" << endline;
+				SideOutput::append(SIDE_OUTPUT_FUNCINFO, line.str());
 			}
 		}
 	}
@@ -1699,7 +1696,7 @@ void CGlobalTokenizeData::RecordFuncInfo(const Tokenizer* tokenizer, const std::
 */
 void CGlobalTokenizeData::RecordInfoForLua(const Tokenizer* tokenizer, const std::string &strFileName)
 {
-	if (!Settings::Instance()->checkLua()) {
+	if (!SideOutput::isOpen(SIDE_OUTPUT_LUA_EXPORT)) {
 		return;
 	}
 
@@ -1733,43 +1730,28 @@ void CGlobalTokenizeData::RecordInfoForLua(const Tokenizer* tokenizer, const std
 		}
 		if (bValidName)
 		{
-			m_InfoForLua.insert(str.substr(1, nLength - 1));
+			AddLuaInfo(str.substr(1, nLength - 1));
 		}
 	}
 }
 
-void CGlobalTokenizeData::DumpFuncinfo()
-{
-	//append data to
-	std::ofstream myFuncinfo("funcinfo.txt", std::ios::app);
-	if (!myFuncinfo)
-	{
-		return;
-	}
-	for (std::list<FUNCINFO>::const_iterator iter = m_funcInfoList.begin(), end = m_funcInfoList.end(); iter != end; ++iter)
-	{
-		myFuncinfo << (*iter).filename << "#bebe#" << (*iter).functionname << "#bebe#" << (*iter).startline << "#bebe#" << (*iter).endline << "\n";
-	}
-}
-
 namespace {
 	const std::set<std::string> lua_keywords = make_container< std::set<std::string> >()
 		<< "and" << "break" << "do" << "else" << "elseif" << "end" << "false" << "for" << "function" << "goto" << "if"
 		<< "in" << "local" << "nil" << "not" << "or" << "repeat" << "return" << "then" << "true" << "until" << "while";
 }
-void CGlobalTokenizeData:: MergeLuaInfoToOneData(std::set<std::string> & m_oneLuaData, std::set<std::string> &luaExportClass)
+// "[exp]" sorts before "[lua.exp.cls]", so the names come first in cpp.lua.exp
+void CGlobalTokenizeData::AddLuaInfo(const std::string &info)
 {
-	for (std::set<std::string>::const_iterator iter = m_InfoForLua.begin(), end = m_InfoForLua.end();
-		iter != end; ++iter)
+	if (info.compare(0, 2, "m_") != 0 && lua_keywords.count(info) == 0)
 	{
-		if (iter->compare(0, 2, "m_") != 0 && lua_keywords.count(*iter) == 0)
-		{
-			m_oneLuaData.insert(*iter);
-		}
+		SideOutput::append(SIDE_OUTPUT_LUA_EXPORT, "[exp]" + info);
 	}
-	luaExportClass.insert(m_luaExportClass.begin(), m_luaExportClass.end());
-	m_InfoForLua.clear();
-	m_luaExportClass.clear();
+}
+
+void CGlobalTokenizeData::AddExportClass(const std::string &str)
+{
+	SideOutput::append(SIDE_OUTPUT_LUA_EXPORT, "[lua.exp.cls]" + str);
 }
 
 
@@ -1914,6 +1896,42 @@ std::map<std::string, std::list<ArrayIndexInfo> >& CGlobalStatisticData::GetOutO
 	return data;
 }
 
+void CGlobalStatisticData::BeginWindows(void* pKey)
+{
+	TSC_LOCK_ENTER(&m_lock);
+	StatisticThreadData& data = m_threadData[pKey];
+	data.Windowed = true;
+	data.FilesBeforeWindows.clear();
+	for (std::map<std::string, std::map<const gt::CFunction*, std::list<FuncRetInfo> > >::const_iterator
+		I = data.FuncRetNullInfo.begin(), E = data.FuncRetNullInfo.end(); I != E; ++I)
+	{
+		data.FilesBeforeWindows.insert(I->first);
+	}
+	for (std::map<std::string, std::list<ArrayIndexInfo> >::const_iterator
+		I = data.OutOfBoundsInfo.begin(), E = data.OutOfBoundsInfo.end(); I != E; ++I)
+	{
+		data.FilesBeforeWindows.insert(I->first);
+	}
+	TSC_LOCK_LEAVE(&m_lock);
+}
+
+void CGlobalStatisticData::EndWindows(void* pKey)
+{
+	TSC_LOCK_ENTER(&m_lock);
+	StatisticThreadData& data = m_threadData[pKey];
+	data.Windowed = false;
+	data.FilesBeforeWindows.clear();
+	TSC_LOCK_LEAVE(&m_lock);
+}
+
+const std::set<std::string>* CGlobalStatisticData::GetFilesBeforeWindows(void* pKey)
+{
+	TSC_LOCK_ENTER(&m_lock);
+	const StatisticThreadData& data = m_threadData[pKey];
+	TSC_LOCK_LEAVE(&m_lock);
+	return data.Windowed ? &data.FilesBeforeWindows : NULL;
+}
+
 void CGlobalStatisticData::Merge(bool bDump)
 {
 	StatisticThreadData tempData;
@@ -2070,6 +2088,7 @@ void CGlobalStatisticData::ReportErrors(Settings& setting, std::set<std::string>
 
 void CGlobalStatisticData::ReportFuncRetNullErrors(Settings& setting, std::set<std::string>& errorList)
 {
+	Baseline::LineHashes lineHashes;
 	for (std::map<const gt::CFunction*, FuncRetStatus>::const_iterator I = m_mergedData.FuncRetNullInfo.begin(), E = m_mergedData.FuncRetNullInfo.end(); I != E; ++I)
 	{
 		const std::string& funcName = I->first->GetName();
@@ -2092,6 +2111,10 @@ void CGlobalStatisticData::ReportFuncRetNullErrors(Settings& setting, std::set<s
 				msg.SetWebIdentity(id);
 				msg.SetFuncInfo(I->first->GetFuncStr());
 
+				// --baseline: known findings are dropped before they are formatted
+				if ((!setting._baseline.empty() || !setting._baselineOut.empty()) && setting._baseline.addFinding(Baseline::fingerprint(msg, lineHashes)))
+					continue;
+
 				std::string errmsg;
 				if (setting._xml)
 				{
@@ -2148,6 +2171,7 @@ bool IsLikeMacro(std::string& str)
 
 void CGlobalStatisticData::ReportOutOfBoundsErrors(Settings& setting, std::set<std::string>& errorList)
 {
+	Baseline::LineHashes lineHashes;
 	for (std::map<std::string, std::map<std::string, std::vector<StatisticMergedData::Pos> > >::const_iterator 
 		I = m_mergedData.OutOfBoundsInfo.begin(), E = m_mergedData.OutOfBoundsInfo.end(); I != E; ++I)
 	{
@@ -2218,6 +2242,10 @@ void CGlobalStatisticData::ReportOutOfBoundsErrors(Settings& setting, std::set<s
 				msg.SetWebIdentity(id);
 				msg.SetFuncInfo("test");
 
+				// --baseline: known findings are dropped before they are formatted
+				if ((!setting._baseline.empty() || !setting._baselineOut.empty()) && setting._baseline.addFinding(Baseline::fingerprint(msg, lineHashes)))
+					continue;
+
 				std::string errmsg;
 				if (setting._xml)
 				{
@@ -21,15 +21,6 @@ class SymbolDatabase;
 class Scope;
 class Variable;
 
-//from bebezhang 20140623
-struct  FUNCINFO
-{
-	std::string filename;
-	std::string functionname;
-	int startline;
-	int endline;
-};
-
 struct SPack1Scope 
 {
 	unsigned StartLine;
@@ -54,6 +45,7 @@ public:
     ~CGlobalTokenizeData();
 
 	void Dump(const char* szPath) const;
+	void Dump(std::ostream& fs) const;
     
     void Merge(const CGlobalTokenizeData& threadData);
 	void RelateTypeInfo();
@@ -63,9 +55,6 @@ public:
 	void RecordFuncInfo(const Tokenizer* tokenizer, const std::string &strFileName);
 	void RecordInfoForLua(const Tokenizer* tokenizer, const std::string &strFileName);
 
-	void DumpFuncinfo();
-	void MergeLuaInfoToOneData(std::set<std::string>& m_oneLuaData, std::set<std::string> &luaExportClass);
-
 	void AddPack1Scope(const std::string& filename, unsigned start, unsigned end);
 	std::map<std::string, std::set<SPack1Scope> >& GetPack1Scope();
 	void RecordRiskTypes(const Tokenizer* tokenizer);
@@ -73,11 +62,9 @@ public:
 	bool IsRiskType(const Variable& var, const Scope* scope);
 	const std::set<std::string>& GetRiskTypes() { return m_riskTypes; }
 
-	void AddLuaInfo(const std::string &info) { m_InfoForLua.insert(info); }
-	std::set<std::string>& GetLuaInfo() { return m_InfoForLua; }
-
-	void AddExportClass(const std::string &str) { m_luaExportClass.insert(str); }
-	std::set<std::string>& GetExportClass() { return m_luaExportClass; }
+	// names for cpp.lua.exp, written by SideOutput
+	void AddLuaInfo(const std::string &info);
+	void AddExportClass(const std::string &str);
 	bool RecoredExportClass() const { return m_bRecoredExportClass; }
 	void RecoredExportClass(bool b) { m_bRecoredExportClass = b; }
 private:
@@ -96,10 +83,7 @@ private:
 	std::multimap<std::string, gt::CScope*> m_scopeMap;
     std::map<const Scope*, gt::CScope*> m_scopeCache;
 
-	std::list<FUNCINFO> m_funcInfoList;
-	std::set<std::string> m_InfoForLua;
 	/////[LUA.EXPORT.CLASS]
-	std::set<std::string> m_luaExportClass;
 	bool m_bRecoredExportClass;
 	std::map<std::string, std::set<SPack1Scope> > m_pack1Scopes;
 	std::set<std::string> m_riskTypes;
@@ -118,7 +102,12 @@ public:
 
     CGlobalTokenizeData* GetGlobalData(void* pKey);
     
+	/** open the side outputs written by Merge(), before the analyze pass */
+	void OpenSideOutputs();
     void Merge(bool dump = false);
+	void DumpMergedData();
+
+	gt::CCallGraph& GetCallGraph() { return m_callGraph; }
  
 	gt::CFuncData::RetNullFlag CheckFuncReturnNull(const Token* tokFunc);
 
@@ -155,6 +144,7 @@ private:
 	const gt::CFunction* FindFunction(const Token* tokFunc, bool requireScope = false) const;
 	const gt::CFunction* FindFunction(const gt::CScope* gtScope, const Token* tokFunc, bool requireScope = false, bool requireConst = false) const;
 	const gt::CScope* FindScope(const Scope* scope, const std::list<std::string>& missedScope) const;
+	const gt::CScope* FindNestedScope(const Scope* scope) const;
 	void FindFunctionInBase(const gt::CScope* gtScope, const Token* tok, size_t args, bool requireScope, std::vector<const gt::CFunction *> & matches, int level = 0) const;
 
 	const gt::CScope* FindGtScopeByStringType(const Scope* currScope, const std::vector < std::string >& stringType) const;
@@ -164,8 +154,9 @@ private:
 
     std::map<void*, CGlobalTokenizeData*> m_threadData;
     CGlobalTokenizeData m_oneData;
-	std::set<std::string> m_oneLuaData;
+	gt::CCallGraph m_callGraph;
 	bool m_bAnalyze;
+	TSC_LOCK m_lock;
 };
 
 class TSCANCODELIB CGlobalErrorList
@@ -213,6 +204,11 @@ struct FuncRetInfo
 	{
 	}
 
+	bool operator==(const FuncRetInfo& other) const
+	{
+		return Op == other.Op && LineNo == other.LineNo && VarName == other.VarName;
+	}
+
 	static FuncRetInfo UnknownInfo;
 };
 
@@ -249,6 +245,12 @@ struct ArrayIndexInfo
 	std::string ArrayStr;
 	std::string ArrayType;
 	unsigned ArrayLine;
+
+	bool operator==(const ArrayIndexInfo& other) const
+	{
+		return BoundLine == other.BoundLine && ArrayLine == other.ArrayLine && BoundStr == other.BoundStr
+			&& ArrayStr == other.ArrayStr && BoundType == other.BoundType && ArrayType == other.ArrayType;
+	}
 };
 
 
@@ -263,6 +265,15 @@ struct StatisticThreadData
 
 	std::map<std::string, std::list<ArrayIndexInfo> > OutOfBoundsInfo;
 
+	// --window-size: files recorded before the current file was split into windows.
+	// The windows record the other files together, each entry once.
+	bool Windowed;
+	std::set<std::string> FilesBeforeWindows;
+
+	StatisticThreadData() : Windowed(false)
+	{
+	}
+
 	void Clear()
 	{
 		FuncRetNullInfo.clear();
@@ -307,6 +318,11 @@ public:
 	std::map<const gt::CFunction*, FuncRetStatus>& GetFuncRetNullMergedData();
 
 	std::map<std::string, std::list<ArrayIndexInfo> >& GetOutOfBoundsThreadData(void* pKey);
+
+	void BeginWindows(void* pKey);
+	void EndWindows(void* pKey);
+	// NULL unless the windows of a file are being checked
+	const std::set<std::string>* GetFilesBeforeWindows(void* pKey);
 	
 	void Merge(bool bDump);
 
@@ -0,0 +1,477 @@
+//
+//  incremental.cpp
+//
+//  Function-granular incremental checking (--incremental-dir).
+//
+
+#include "incremental.h"
+#include "tokenize.h"
+#include "symboldatabase.h"
+#include "settings.h"
+#include "globaltokenizer.h"
+#include "version.h"
+#include <fstream>
+#include <sstream>
+#include <cctype>
+
+static const char STORE_HEADER[] = "tscancode-incremental 1 " TSCANCODE_VERSION_STRING;
+
+static void AppendField(std::string& data, const std::string& field)
+{
+	std::ostringstream oss;
+	oss << field.size() << ':';
+	data += oss.str();
+	data += field;
+}
+
+static void AppendField(std::string& data, unsigned long long value)
+{
+	std::ostringstream oss;
+	oss << value;
+	AppendField(data, oss.str());
+}
+
+static bool ReadField(const std::string& data, std::string::size_type& pos, std::string& field)
+{
+	const std::string::size_type colon = data.find(':', pos);
+	if (colon == std::string::npos)
+		return false;
+	std::istringstream iss(data.substr(pos, colon - pos));
+	std::string::size_type len = 0;
+	if (!(iss >> len) || colon + 1 + len > data.size())
+		return false;
+	field = data.substr(colon + 1, len);
+	pos = colon + 1 + len;
+	return true;
+}
+
+static bool ReadField(const std::string& data, std::string::size_type& pos, unsigned long long& value)
+{
+	std::string field;
+	if (!ReadField(data, pos, field))
+		return false;
+	std::istringstream iss(field);
+	return !!(iss >> value);
+}
+
+// "... at line 12 ..." makes a finding depend on where the function is
+static bool HasLineReference(const std::string& str)
+{
+	for (std::string::size_type pos = str.find("line "); pos != std::string::npos; pos = str.find("line ", pos + 1))
+	{
+		if (pos + 5 < str.size() && std::isdigit((unsigned char)str[pos + 5]))
+			return true;
+	}
+	return false;
+}
+
+static std::string NormalizedFile(const std::string& file)
+{
+	ErrorLogger::ErrorMessage::FileLocation loc;
+	loc.setfile(file);
+	return loc.getfile(false);
+}
+
+// first token of the function definition, including the return type
+static const Token* FunctionStart(const Scope* scope)
+{
+	const Token* start = scope->classDef;
+	while (start->previous() && start->previous()->fileIndex() == start->fileIndex() &&
+		!Token::Match(start->previous(), "[;{}]"))
+		start = start->previous();
+	return start;
+}
+
+static bool IsDeclaredIn(const Variable* var, const Scope* scope)
+{
+	for (const Scope* s = var->scope(); s; s = s->nestedIn)
+	{
+		if (s == scope)
+			return true;
+	}
+	return false;
+}
+
+static void AddDeclaration(CFingerprint& fp, const Variable* var)
+{
+	for (const Token* tok = var->typeStartToken(); tok; tok = tok->next())
+	{
+		fp.Add(tok->str());
+		if (tok == var->typeEndToken())
+			break;
+	}
+	if (var->nameToken())
+		fp.Add(var->nameToken()->str());
+	fp.Add(var->dimensions().size());
+	for (std::size_t i = 0; i < var->dimensions().size(); ++i)
+		fp.Add(var->dimension(i));
+}
+
+static void AddSignature(CFingerprint& fp, const Function* func)
+{
+	if (func->retDef)
+	{
+		for (const Token* tok = func->retDef; tok && tok != func->tokenDef; tok = tok->next())
+			fp.Add(tok->str());
+	}
+	fp.Add(func->tokenDef->str());
+	if (func->argDef && func->argDef->link())
+	{
+		for (const Token* tok = func->argDef; tok != func->argDef->link(); tok = tok->next())
+			fp.Add(tok->str());
+	}
+}
+
+static void AddSummary(CFingerprint& fp, const gt::CFuncData& data)
+{
+	fp.Add(data.GetFuncRetNull());
+	fp.Add(data.GetExitFlag());
+	fp.Add(data.AssignThis());
+
+	const std::set<gt::SVarEntry>& derefed = data.GetDerefedVars();
+	fp.Add(derefed.size());
+	for (std::set<gt::SVarEntry>::const_iterator I = derefed.begin(), E = derefed.end(); I != E; ++I)
+	{
+		fp.Add(I->sName);
+		fp.Add(I->eType);
+		fp.Add(I->iParamIndex);
+	}
+
+	const std::set<gt::CFuncData::ParamRetRelation>* relations = data.GetRetParamRelation();
+	for (int i = 0; i < gt::CFuncData::ParamRetRelationNum; ++i)
+	{
+		fp.Add(relations[i].size());
+		for (std::set<gt::CFuncData::ParamRetRelation>::const_iterator I = relations[i].begin(), E = relations[i].end(); I != E; ++I)
+		{
+			fp.Add(I->nValue);
+			fp.Add(I->nIndex);
+			fp.Add((I->bNull ? 1 : 0) | (I->bEqual ? 2 : 0) | (I->bStr ? 4 : 0) | (I->bNerverNull ? 8 : 0));
+			fp.Add(I->str);
+		}
+	}
+
+	const std::set<gt::SOutScopeVarState>& outScope = data.GetOutScopeVarState();
+	fp.Add(outScope.size());
+	for (std::set<gt::SOutScopeVarState>::const_iterator I = outScope.begin(), E = outScope.end(); I != E; ++I)
+	{
+		fp.Add(I->strName);
+		fp.Add(I->bNull);
+	}
+}
+
+CIncrementalStore::CIncrementalStore(const Settings& settings)
+	: m_settings(settings)
+	, m_bRecording(false)
+	, m_bConfiguration(false)
+{
+}
+
+bool CIncrementalStore::Enabled() const
+{
+	return !m_settings._incrementalDir.empty();
+}
+
+void CIncrementalStore::Load(const std::string& sourceFile)
+{
+	m_loaded.clear();
+	m_saved.clear();
+	m_functions.clear();
+	m_storeFile.clear();
+	if (!Enabled())
+		return;
+
+	CFingerprint pathHash;
+	pathHash.Add(NormalizedFile(sourceFile));
+	std::string::size_type slash = sourceFile.find_last_of("/\\");
+	std::ostringstream name;
+	name << m_settings._incrementalDir << '/' << (slash == std::string::npos ? sourceFile : sourceFile.substr(slash + 1))
+		<< '.' << std::hex << pathHash.Value() << ".fp";
+	m_storeFile = name.str();
+
+	std::ifstream fin(m_storeFile.c_str(), std::ios::in | std::ios::binary);
+	std::string header;
+	if (!fin.is_open() || !std::getline(fin, header) || header != STORE_HEADER)
+		return;
+
+	unsigned long long fingerprint = 0;
+	unsigned pinnedLine = 0;
+	std::size_t count = 0;
+	while (fin >> std::hex >> fingerprint >> std::dec >> pinnedLine >> count)
+	{
+		SEntry& entry = m_loaded[fingerprint];
+		entry.uPinnedLine = pinnedLine;
+		entry.findings.clear();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			std::size_t len = 0;
+			if (!(fin >> len) || fin.get() != ' ')
+			{
+				m_loaded.clear();
+				return;
+			}
+			std::string finding(len, '\0');
+			if (len && !fin.read(&finding[0], len))
+			{
+				m_loaded.clear();
+				return;
+			}
+			entry.findings.push_back(finding);
+		}
+	}
+}
+
+void CIncrementalStore::Save()
+{
+	if (!Enabled() || m_storeFile.empty())
+		return;
+
+	std::ofstream fout(m_storeFile.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (fout.is_open())
+	{
+		fout << STORE_HEADER << '\n';
+		for (std::map<unsigned long long, SEntry>::const_iterator I = m_saved.begin(), E = m_saved.end(); I != E; ++I)
+		{
+			fout << std::hex << I->first << std::dec << ' ' << I->second.uPinnedLine << ' ' << I->second.findings.size() << '\n';
+			for (std::vector<std::string>::const_iterator F = I->second.findings.begin(); F != I->second.findings.end(); ++F)
+				fout << F->size() << ' ' << *F << '\n';
+		}
+	}
+
+	m_loaded.clear();
+	m_saved.clear();
+	m_storeFile.clear();
+}
+
+void CIncrementalStore::BeginConfiguration(Tokenizer& tokenizer, const std::string& cfg)
+{
+	m_functions.clear();
+	m_bConfiguration = false;
+	if (!Enabled() || m_storeFile.empty())
+		return;
+
+	const SymbolDatabase* symbolDatabase = tokenizer.getSymbolDatabase();
+	std::map<std::pair<unsigned, unsigned>, std::pair<SFunction*, const Scope*> > keys;
+	for (std::size_t i = 0, n = symbolDatabase->functionScopes.size(); i < n; ++i)
+	{
+		const Scope* scope = symbolDatabase->functionScopes[i];
+		if (!scope->classDef || !scope->classEnd)
+			continue;
+
+		const Token* start = FunctionStart(scope);
+		SFunction func;
+		func.sFile = NormalizedFile(tokenizer.list.file(start));
+		func.uFirstLine = start->linenr();
+		func.uLastLine = scope->classEnd->linenr();
+		func.uFingerprint = Fingerprint(tokenizer, scope, cfg);
+		// functions skipped for other reasons (--diff-scope) have no complete findings
+		func.bCacheable = start->fileIndex() == scope->classEnd->fileIndex() && !tokenizer.isSkippedScope(scope);
+		func.bReplayed = false;
+		if (func.bCacheable)
+		{
+			std::map<unsigned long long, SEntry>::const_iterator it = m_loaded.find(func.uFingerprint);
+			func.bReplayed = it != m_loaded.end() && (it->second.uPinnedLine == 0 || it->second.uPinnedLine == func.uFirstLine);
+		}
+		m_functions.push_back(func);
+
+		// functions sharing a line can't be told apart by the checks
+		std::pair<SFunction*, const Scope*>& other = keys[std::make_pair(scope->classDef->fileIndex(), scope->classDef->linenr())];
+		if (other.first)
+		{
+			other.first->bReplayed = other.first->bCacheable = false;
+			m_functions.back().bReplayed = m_functions.back().bCacheable = false;
+		}
+		other = std::make_pair(&m_functions.back(), scope);
+	}
+
+	// findings of nested functions (local classes, lambdas) are not told apart either
+	for (std::list<SFunction>::iterator I = m_functions.begin(); I != m_functions.end(); ++I)
+	{
+		for (std::list<SFunction>::iterator J = m_functions.begin(); J != m_functions.end(); ++J)
+		{
+			if (I != J && I->sFile == J->sFile && I->uFirstLine <= J->uLastLine && J->uFirstLine <= I->uLastLine)
+				I->bReplayed = I->bCacheable = false;
+		}
+	}
+
+	for (std::map<std::pair<unsigned, unsigned>, std::pair<SFunction*, const Scope*> >::const_iterator I = keys.begin(), E = keys.end(); I != E; ++I)
+	{
+		if (I->second.first->bReplayed)
+			tokenizer.skipFunction(I->second.second);
+	}
+	m_bConfiguration = true;
+}
+
+void CIncrementalStore::EndConfiguration(ErrorLogger& logger, bool bCommit)
+{
+	if (!m_bConfiguration)
+		return;
+	m_bConfiguration = false;
+	m_bRecording = false;
+
+	for (std::list<SFunction>::iterator I = m_functions.begin(); I != m_functions.end(); ++I)
+	{
+		if (I->bReplayed)
+		{
+			const SEntry& entry = m_loaded[I->uFingerprint];
+			for (std::vector<std::string>::const_iterator F = entry.findings.begin(); F != entry.findings.end(); ++F)
+			{
+				ErrorLogger::ErrorMessage msg;
+				if (Deserialize(*F, I->uFirstLine, msg))
+					logger.reportErr(msg);
+			}
+			m_saved[I->uFingerprint] = entry;
+		}
+		else if (bCommit && I->bCacheable)
+		{
+			m_saved[I->uFingerprint] = I->entry;
+		}
+	}
+	m_functions.clear();
+}
+
+CIncrementalStore::SFunction* CIncrementalStore::FindFunction(const std::string& file, unsigned line)
+{
+	for (std::list<SFunction>::iterator I = m_functions.begin(); I != m_functions.end(); ++I)
+	{
+		if (line >= I->uFirstLine && line <= I->uLastLine && I->sFile == file)
+			return &*I;
+	}
+	return nullptr;
+}
+
+bool CIncrementalStore::OnFinding(const ErrorLogger::ErrorMessage& msg)
+{
+	if (!m_bConfiguration || !m_bRecording || msg._callStack.empty())
+		return true;
+
+	SFunction* func = FindFunction(msg._callStack.back().getfile(false), msg._callStack.back().line);
+	bool bLocal = func != nullptr;
+	for (std::list<ErrorLogger::ErrorMessage::FileLocation>::const_iterator I = msg._callStack.begin(); I != msg._callStack.end(); ++I)
+	{
+		SFunction* other = FindFunction(I->getfile(false), I->line);
+		if (other != func)
+		{
+			// spans several functions, recheck all of them next time
+			bLocal = false;
+			if (other)
+				other->bCacheable = false;
+		}
+	}
+
+	if (!bLocal)
+	{
+		if (func)
+			func->bCacheable = false;
+		return true;
+	}
+
+	if (func->bReplayed)
+		return false;
+
+	if (HasLineReference(msg.shortMessage()) || HasLineReference(msg.verboseMessage()))
+		func->entry.uPinnedLine = func->uFirstLine;
+	func->entry.findings.push_back(Serialize(msg, func->uFirstLine));
+	return true;
+}
+
+std::string CIncrementalStore::Serialize(const ErrorLogger::ErrorMessage& msg, unsigned firstLine)
+{
+	std::string data;
+	AppendField(data, msg._type);
+	AppendField(data, msg._id);
+	AppendField(data, Severity::toString(msg._severity));
+	AppendField(data, msg._cwe);
+	AppendField(data, msg._inconclusive ? 1 : 0);
+	AppendField(data, msg.shortMessage());
+	AppendField(data, msg.verboseMessage());
+	AppendField(data, msg._webIdentify);
+	AppendField(data, msg._funcinfo);
+	AppendField(data, msg.file0);
+	AppendField(data, msg._callStack.size());
+	for (std::list<ErrorLogger::ErrorMessage::FileLocation>::const_iterator I = msg._callStack.begin(); I != msg._callStack.end(); ++I)
+	{
+		AppendField(data, I->getfile(false));
+		AppendField(data, I->line - firstLine);
+	}
+	return data;
+}
+
+bool CIncrementalStore::Deserialize(const std::string& data, unsigned firstLine, ErrorLogger::ErrorMessage& msg)
+{
+	std::string::size_type pos = 0;
+	unsigned long long type = 0, cwe = 0, inconclusive = 0, locations = 0;
+	std::string id, severity, shortMessage, verboseMessage, webIdentify, funcinfo, file0;
+	if (!ReadField(data, pos, type) || !ReadField(data, pos, id) || !ReadField(data, pos, severity) ||
+		!ReadField(data, pos, cwe) || !ReadField(data, pos, inconclusive) ||
+		!ReadField(data, pos, shortMessage) || !ReadField(data, pos, verboseMessage) ||
+		!ReadField(data, pos, webIdentify) || !ReadField(data, pos, funcinfo) || !ReadField(data, pos, file0) ||
+		!ReadField(data, pos, locations))
+		return false;
+
+	std::list<ErrorLogger::ErrorMessage::FileLocation> callStack;
+	for (unsigned long long i = 0; i < locations; ++i)
+	{
+		std::string file;
+		unsigned long long line = 0;
+		if (!ReadField(data, pos, file) || !ReadField(data, pos, line))
+			return false;
+		callStack.push_back(ErrorLogger::ErrorMessage::FileLocation(file, firstLine + (unsigned)line));
+	}
+
+	const std::string text = (verboseMessage.empty() || verboseMessage == shortMessage) ? shortMessage : shortMessage + "\n" + verboseMessage;
+	msg = ErrorLogger::ErrorMessage(callStack, Severity::fromString(severity), text, (ErrorType::ErrorTypeEnum)type, id, inconclusive != 0);
+	msg._cwe = (unsigned)cwe;
+	msg.file0 = file0;
+	msg.SetWebIdentity(webIdentify);
+	msg.SetFuncInfo(funcinfo);
+	return true;
+}
+
+unsigned long long CIncrementalStore::Fingerprint(const Tokenizer& tokenizer, const Scope* scope, const std::string& cfg) const
+{
+	CFingerprint fp;
+	fp.Add(cfg);
+
+	const Token* start = FunctionStart(scope);
+	const unsigned firstLine = start->linenr();
+	fp.Add(NormalizedFile(tokenizer.list.file(start)));
+
+	std::map<unsigned, unsigned> varIds;
+	std::set<const Function*> callees;
+	CGlobalTokenizer* globalTokenizer = CGlobalTokenizer::Instance();
+	for (const Token* tok = start; tok; tok = tok->next())
+	{
+		fp.Add(tok->str());
+		fp.Add(tok->fileIndex());
+		fp.Add(tok->linenr() - firstLine);
+
+		if (tok->varId())
+		{
+			// varids depend on the rest of the file, number them by first use
+			std::map<unsigned, unsigned>::iterator it = varIds.find(tok->varId());
+			if (it == varIds.end())
+			{
+				it = varIds.insert(std::make_pair(tok->varId(), (unsigned)varIds.size() + 1)).first;
+				const Variable* var = tok->variable();
+				if (var && !IsDeclaredIn(var, scope))
+					AddDeclaration(fp, var);
+			}
+			fp.Add(it->second);
+		}
+		else if (tok->function() && tok->function() != scope->function && callees.insert(tok->function()).second)
+		{
+			AddSignature(fp, tok->function());
+		}
+
+		if (!tok->varId() && Token::Match(tok, "%name% ("))
+		{
+			const gt::CFunction* gtFunc = globalTokenizer->FindFunctionData(tok);
+			if (gtFunc)
+				AddSummary(fp, gtFunc->GetFuncData());
+		}
+
+		if (tok == scope->classEnd)
+			break;
+	}
+	return fp.Value();
+}
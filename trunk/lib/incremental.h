@@ -0,0 +1,121 @@
+//
+//  incremental.h
+//
+//  Function-granular incremental checking (--incremental-dir).
+//
+
+#ifndef incremental_h
+#define incremental_h
+
+#include <string>
+#include <map>
+#include <set>
+#include <list>
+#include <vector>
+#include "config.h"
+#include "errorlogger.h"
+
+class Tokenizer;
+class Scope;
+class Settings;
+
+// 64 bit FNV-1a, stable across runs and platforms
+class TSCANCODELIB CFingerprint
+{
+public:
+	CFingerprint() : m_hash(14695981039346656037ULL) {}
+
+	void Add(const std::string& str)
+	{
+		Add(str.size());
+		for (std::size_t i = 0; i < str.size(); ++i)
+			AddByte((unsigned char)str[i]);
+	}
+
+	void Add(unsigned long long value)
+	{
+		for (int i = 0; i < 8; ++i, value >>= 8)
+			AddByte((unsigned char)(value & 0xff));
+	}
+
+	unsigned long long Value() const { return m_hash; }
+
+private:
+	void AddByte(unsigned char c)
+	{
+		m_hash ^= c;
+		m_hash *= 1099511628211ULL;
+	}
+
+	unsigned long long m_hash;
+};
+
+/**
+ * Findings of the function scoped checks (Check::isFunctionScoped()) are
+ * stored per function, keyed by a fingerprint of the simplified function
+ * body, the declarations it uses and the summaries of its callees.
+ * Functions whose fingerprint is found in the store of the file are not
+ * checked again, their stored findings are replayed instead.
+ *
+ * One store file per source file is kept in the incremental directory.
+ */
+class TSCANCODELIB CIncrementalStore
+{
+public:
+	explicit CIncrementalStore(const Settings& settings);
+
+	bool Enabled() const;
+
+	// load the store of @sourceFile, findings of previous runs become replayable
+	void Load(const std::string& sourceFile);
+	// write the entries of all checked configurations back, stale ones are dropped
+	void Save();
+
+	// fingerprint the function scopes of one configuration and tell the
+	// tokenizer which of them are replayed
+	void BeginConfiguration(Tokenizer& tokenizer, const std::string& cfg);
+	// replay the findings of skipped functions, keep the new entries if @bCommit
+	void EndConfiguration(ErrorLogger& logger, bool bCommit);
+
+	// findings reported while a function scoped check runs are recorded
+	void SetRecording(bool bRecording) { m_bRecording = bRecording; }
+
+	// record a finding; returns false if it is replayed and must not be reported again
+	bool OnFinding(const ErrorLogger::ErrorMessage& msg);
+
+	static std::string Serialize(const ErrorLogger::ErrorMessage& msg, unsigned firstLine);
+	static bool Deserialize(const std::string& data, unsigned firstLine, ErrorLogger::ErrorMessage& msg);
+
+private:
+	struct SEntry
+	{
+		// 0 if the findings do not depend on the position of the function
+		unsigned uPinnedLine;
+		std::vector<std::string> findings;
+		SEntry() : uPinnedLine(0) {}
+	};
+
+	struct SFunction
+	{
+		std::string sFile;
+		unsigned uFirstLine;
+		unsigned uLastLine;
+		unsigned long long uFingerprint;
+		bool bReplayed;
+		bool bCacheable;
+		SEntry entry;
+	};
+
+	unsigned long long Fingerprint(const Tokenizer& tokenizer, const Scope* scope, const std::string& cfg) const;
+	SFunction* FindFunction(const std::string& file, unsigned line);
+
+	const Settings& m_settings;
+	std::string m_storeFile;
+	std::map<unsigned long long, SEntry> m_loaded;
+	std::map<unsigned long long, SEntry> m_saved;
+	std::list<SFunction> m_functions;
+	bool m_bRecording;
+	bool m_bConfiguration;
+};
+
+#endif // incremental_h
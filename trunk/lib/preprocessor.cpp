@@ -26,6 +26,9 @@
 #include "errorlogger.h"
 #include "settings.h"
 #include "path.h"
+#include "sourcebundle.h"
+#include "workcounters.h"
+#include "incremental.h"
 
 #include <algorithm>
 #include <sstream>
@@ -1089,10 +1092,10 @@ void Preprocessor::preprocess(std::istream &srcCodeStream, std::string &processe
         const std::string& cur = *it;
 
         // try to open file
-        std::ifstream fin;
+        CSourceFile fin;
 
-        fin.open(cur.c_str());
-        if (!fin.is_open()) {
+        fin.Open(cur);
+        if (!fin.IsOpen()) {
             missingInclude(cur,
                            1,
                            cur,
@@ -1100,9 +1103,9 @@ void Preprocessor::preprocess(std::istream &srcCodeStream, std::string &processe
                           );
             continue;
         }
-        const std::string fileData = read(fin, filename);
+        const std::string fileData = read(fin.Stream(), filename);
 
-        fin.close();
+        fin.Close();
 
         /*forcedIncludes +=
             "#file \"" + cur + "\"\n" +
@@ -1845,7 +1848,12 @@ bool Preprocessor::is_cfg_def(std::map<std::string, std::string>& cfg, std::stri
 		if (pCodeFile)
 		{
 			std::map < std::string, PreprocessorMacro*> macroBuffer;
-			PreprocessorMacro* macro = CGlobalMacros::FindMacro(def, pCodeFile, macroBuffer);
+			std::list<PreprocessorMacro*> loadedMacros;
+			PreprocessorMacro* macro = CGlobalMacros::FindMacro(def, pCodeFile, macroBuffer, loadedMacros);
+			for (std::list<PreprocessorMacro*>::iterator it = loadedMacros.begin(); it != loadedMacros.end(); ++it)
+			{
+				delete *it;
+			}
 			if (macro)
 			{
 				cfg[def] = emptyString;
@@ -1859,6 +1867,7 @@ bool Preprocessor::is_cfg_def(std::map<std::string, std::string>& cfg, std::stri
 
 bool Preprocessor::match_cfg_def(std::map<std::string, std::string> cfg, std::string def)
 {
+    WorkCounters::add(WORK_PREPROCESSOR_CONDITIONS);
 
     simplifyVarMap(cfg, _settings);
     simplifyCondition(cfg, def, true);
@@ -1876,7 +1885,152 @@ bool Preprocessor::match_cfg_def(std::map<std::string, std::string> cfg, std::st
 }
 
 
+// the directives that change the state of Preprocessor::getcode() even in a branch that is not taken
+static bool isInertDirective(const std::string &line)
+{
+    return line.compare(0, 6, "#undef") != 0 &&
+           line.compare(0, 7, "#file \"") != 0 &&
+           line.compare(0, 8, "#endfile") != 0 &&
+           line.compare(0, 7, "#pragma") != 0;
+}
+
+void Preprocessor::splitLines(const std::string &filedata, CfgLineStream &stream)
+{
+    stream.segments.clear();
+    stream.lines = 0;
+
+    // directives opening the branches the current line is in, innermost last
+    std::vector<std::size_t> open;
+    std::vector<CfgLineSegment> &segments = stream.segments;
+
+    std::istringstream istr(filedata);
+    std::string line;
+    while (std::getline(istr, line)) {
+        const std::size_t branch = open.empty() ? std::string::npos : open.back();
+        ++stream.lines;
+
+        if (line.empty() || line[0] != '#') {
+            if (segments.empty() || segments.back().kind != CfgLineSegment::CODE)
+                segments.push_back(CfgLineSegment(CfgLineSegment::CODE, stream.lines - 1, branch));
+            segments.back().text += line;
+            segments.back().text += '\n';
+            ++segments.back().lines;
+            continue;
+        }
+
+        if (!isInertDirective(line)) {
+            for (std::size_t i = 0; i < open.size(); ++i)
+                segments[open[i]].inert = false;
+        }
+
+        if (line.compare(0, 11, "#pragma asm") == 0) {
+            segments.push_back(CfgLineSegment(CfgLineSegment::ASM, stream.lines - 1, branch));
+            while (std::getline(istr, line)) {
+                ++stream.lines;
+                if (line.compare(0, 14, "#pragma endasm") == 0) {
+                    segments.back().text = line;
+                    break;
+                }
+                ++segments.back().lines;
+            }
+            continue;
+        }
+
+        const std::size_t index = segments.size();
+        segments.push_back(CfgLineSegment(CfgLineSegment::DIRECTIVE, stream.lines - 1, branch));
+        CfgLineSegment &directive = segments.back();
+        directive.text = line;
+        directive.def = getdef(line, true);
+        directive.ndef = getdef(line, false);
+
+        // the same order as in getcode(), an empty stack there is an empty 'open' here
+        if (line.compare(0, 8, "#define ") == 0 || line.compare(0, 7, "#undef ") == 0)
+            continue;
+        if (!open.empty() && line.compare(0, 6, "#elif ") == 0) {
+            segments[open.back()].branchEnd = index;
+            open.back() = index;
+        } else if (line.compare(0, 4, "#if ") == 0 || !directive.def.empty() || !directive.ndef.empty()) {
+            open.push_back(index);
+        } else if (!open.empty() && line == "#else") {
+            segments[open.back()].branchEnd = index;
+            open.back() = index;
+        } else if (!open.empty() && line.compare(0, 6, "#endif") == 0) {
+            segments[open.back()].branchEnd = index;
+            open.pop_back();
+        }
+    }
+}
+
+void Preprocessor::getCheckableFiles(const std::string &code, const std::string &filename, std::map<std::string, unsigned long long> &files)
+{
+    // the file of the current line, innermost header last
+    std::vector<std::string> fileStack(1, filename);
+    // the code of each file, a header changed by the macros of this configuration differs
+    std::map<std::string, CFingerprint> fingerprints;
+    std::vector<CFingerprint *> fingerprintStack(1, &fingerprints[filename]);
+    std::set<std::string> checkable;
+    // names of the current declaration, to tell a namespace or extern "C" block
+    std::vector<std::string> names;
+    bool literal = false;
+
+    std::istringstream istr(code);
+    std::string line;
+    while (std::getline(istr, line)) {
+        if (!line.empty() && line[0] == '#') {
+            if (line.compare(0, 7, "#file \"") == 0) {
+                fileStack.push_back(line.substr(7, line.find('"', 7) - 7));
+                fingerprintStack.push_back(&fingerprints[fileStack.back()]);
+            } else if (line.compare(0, 8, "#endfile") == 0 && fileStack.size() > 1) {
+                fileStack.pop_back();
+                fingerprintStack.pop_back();
+            }
+            continue;
+        }
+        fingerprintStack.back()->Add(line);
+
+        for (std::string::size_type pos = 0; pos < line.size(); ++pos) {
+            const char ch = line[pos];
+            if (ch == '\"' || ch == '\'') {
+                while (++pos < line.size() && line[pos] != ch) {
+                    if (line[pos] == '\\')
+                        ++pos;
+                }
+                literal = true;
+            } else if (std::isalpha((unsigned char)ch) || ch == '_') {
+                const std::string::size_type start = pos;
+                while (++pos < line.size() && (std::isalnum((unsigned char)line[pos]) || line[pos] == '_'))
+                    ;
+                names.push_back(line.substr(start, pos - start));
+                --pos;
+            } else if (ch == '{') {
+                const bool namespaceBlock = !names.empty() &&
+                                            (names[0] == "namespace" || (names[0] == "inline" && names.size() > 1 && names[1] == "namespace"));
+                const bool linkageBlock = names.size() == 1 && names[0] == "extern" && literal;
+                if (!namespaceBlock && !linkageBlock)
+                    checkable.insert(fileStack.back());
+                names.clear();
+                literal = false;
+            } else if (ch == '=') {
+                checkable.insert(fileStack.back());
+            } else if (ch == ';' || ch == '}') {
+                names.clear();
+                literal = false;
+            }
+        }
+    }
+
+    for (std::set<std::string>::const_iterator it = checkable.begin(); it != checkable.end(); ++it)
+        files[*it] = fingerprints[*it].Value();
+}
+
 std::string Preprocessor::getcode(const std::string &filedata, const std::string &cfg, const std::string &filename)
+{
+    CfgLineStream stream;
+    splitLines(filedata, stream);
+    return getcode(stream, cfg, filename, false);
+}
+
+std::string Preprocessor::getcode(const CfgLineStream &stream, const std::string &cfg, const std::string &filename, bool skipDeadBranches)
 {
 	CGlobalTokenizeData* data = CGlobalTokenizer::Instance()->GetGlobalData(_errorLogger);
 	bool bAnalyze = CGlobalTokenizer::Instance()->IsAnalyze();
@@ -1911,32 +2065,33 @@ std::string Preprocessor::getcode(const std::string &filedata, const std::string
     std::stack<std::string> filenames;
     filenames.push(filename);
     std::stack<unsigned int> lineNumbers;
-    std::istringstream istr(filedata);
     std::string line;
-    while (std::getline(istr, line)) {
-        ++lineno;
+    WorkCount lines(WORK_PREPROCESSOR_LINES);
+    const std::vector<CfgLineSegment> &segments = stream.segments;
+    for (std::size_t index = 0; index < segments.size(); ++index) {
+        const CfgLineSegment &segment = segments[index];
 
         if (_settings.terminated())
             return "";
 
-		if (line.compare(0, 7, "#pragma") == 0)
-		{
-			int i = 0;
-			++i;
-		}
+        // code lines are kept or removed together with the preceding directive
+        if (segment.kind == CfgLineSegment::CODE) {
+            lineno += segment.lines;
+            lines += segment.lines;
+            if (match)
+                ret << segment.text;
+            else
+                ret << std::string(segment.lines, '\n');
+            continue;
+        }
 
-        if (line.compare(0, 11, "#pragma asm") == 0) {
-            ret << "\n";
-            bool found_end = false;
-            while (getline(istr, line)) {
-                if (line.compare(0, 14, "#pragma endasm") == 0) {
-                    found_end = true;
-                    break;
-                }
+        ++lineno;
+        ++lines;
+        line = segment.text;
 
-                ret << "\n";
-            }
-            if (!found_end)
+        if (segment.kind == CfgLineSegment::ASM) {
+            ret << "\n" << std::string(segment.lines, '\n');
+            if (line.empty())
                 break;
 
             if (line.find('=') != std::string::npos) {
@@ -1954,8 +2109,8 @@ std::string Preprocessor::getcode(const std::string &filedata, const std::string
             continue;
         }
 
-        const std::string def = getdef(line, true);
-        const std::string ndef = getdef(line, false);
+        const std::string &def = segment.def;
+        const std::string &ndef = segment.ndef;
 
         const bool emptymatch = matching_ifdef.empty() || matched_ifdef.empty();
 
@@ -2169,6 +2324,13 @@ std::string Preprocessor::getcode(const std::string &filedata, const std::string
 		
 		ret << line << "\n";
 
+        // nothing in a branch that is not taken has an effect, its lines are all removed
+        if (skipDeadBranches && !match && segment.inert && segment.branchEnd != std::string::npos) {
+            const std::size_t skipped = segments[segment.branchEnd].firstLine - segment.firstLine - 1;
+            lineno += (unsigned int)skipped;
+            ret << std::string(skipped, '\n');
+            index = segment.branchEnd - 1;
+        }
     }
 
 	if (bPackMatch && !packStack.empty())
@@ -2274,10 +2436,10 @@ Preprocessor::HeaderTypes Preprocessor::getHeaderFileName(std::string &str)
  * @param fin file input stream (in/out)
  * @return if file is opened then true is returned
  */
-static bool openHeader(std::string &filename, const std::list<std::string> &includePaths, const std::string &filePath, std::ifstream &fin, std::set<CCodeFile*>& openedCache, size_t largeHeaderSize)
+static bool openHeader(std::string &filename, const std::list<std::string> &includePaths, const std::string &filePath, CSourceFile &fin, std::set<CCodeFile*>& openedCache, size_t largeHeaderSize)
 {
 	std::string headerPath = filePath + filename;
-	headerPath = Path::getAbsoluteFilePath(headerPath);
+	headerPath = CSourceBundle::IsLoaded() ? CSourceBundle::GetAbsolutePath(headerPath) : Path::getAbsoluteFilePath(headerPath);
 	
 	CCodeFile* pCodeFile = dynamic_cast<CCodeFile*>(CGlobalMacros::GetFileTable()->FindFile(headerPath));
 	if (pCodeFile)
@@ -2299,8 +2461,8 @@ static bool openHeader(std::string &filename, const std::list<std::string> &incl
 		pCodeFile->AddExpandCount();
 	}
 
-	fin.open((filePath + filename).c_str());
-	if (fin.is_open()) {
+	fin.Open(filePath + filename);
+	if (fin.IsOpen()) {
 		filename = filePath + filename;
 		return true;
 	}
@@ -2310,12 +2472,11 @@ static bool openHeader(std::string &filename, const std::list<std::string> &incl
 
     for (std::list<std::string>::const_iterator iter = includePaths2.begin(); iter != includePaths2.end(); ++iter) {
         const std::string nativePath(Path::toNativeSeparators(*iter));
-        fin.open((nativePath + filename).c_str());
-        if (fin.is_open()) {
+        fin.Open(nativePath + filename);
+        if (fin.IsOpen()) {
             filename = nativePath + filename;
             return true;
         }
-        fin.clear();
     }
     return false;
 }
@@ -2374,8 +2535,10 @@ std::string Preprocessor::handleIncludes(const std::string &code, const std::str
     std::istringstream istr(code);
     std::string line;
     bool suppressCurrentCodePath = false;
+    WorkCount lines(WORK_PREPROCESSOR_LINES);
     while (std::getline(istr,line)) {
         ++linenr;
+        ++lines;
 
         if (_settings.terminated())
             return "";
@@ -2526,7 +2689,7 @@ std::string Preprocessor::handleIncludes(const std::string &code, const std::str
                 std::string filepath;
                 if (headerType == UserHeader)
                     filepath = path;
-                std::ifstream fin;
+                CSourceFile fin;
                 if (!openHeader(filename, includePaths, filepath, fin, largeHeaderSet, _settings._big_header_file_size)) {
 					
 					//try-local folder 
@@ -2561,7 +2724,7 @@ std::string Preprocessor::handleIncludes(const std::string &code, const std::str
                 }
 				
                 ostr << "#file \"" << filename << "\"\n"
-                     << handleIncludes(read(fin, filename), filename, includePaths, defs, pragmaOnce, includes) << std::endl
+                     << handleIncludes(read(fin.Stream(), filename), filename, includePaths, defs, pragmaOnce, includes) << std::endl
                      << "#endfile\n";
                 continue;
             }
@@ -2578,6 +2741,15 @@ std::string Preprocessor::handleIncludes(const std::string &code, const std::str
 }
 
 
+namespace {
+    /** Text that handleIncludes has not written yet: text[pos..] */
+    struct IncludePiece {
+        IncludePiece() : pos(0) {}
+        std::string text;
+        std::string::size_type pos;
+    };
+}
+
 void Preprocessor::handleIncludes(std::string &code, const std::string &filePath, const std::list<std::string> &includePaths)
 {
 	TscanCode* tscanCode = dynamic_cast<TscanCode*>(_errorLogger);
@@ -2597,29 +2769,54 @@ void Preprocessor::handleIncludes(std::string &code, const std::string &filePath
             endfilePos = start;
     }
     std::set<std::string> handledFiles;
-    while ((pos = code.find("#include", pos)) != std::string::npos) {
-        if (_settings.terminated())
+
+    // The result is written once, from front to back. Text that is not written
+    // yet is a stack of pieces: the rest of the code and the rest of every
+    // header that is being expanded, so a header is never inserted into the
+    // middle of a large string.
+    std::string result;
+    result.reserve(code.size());
+    std::vector<IncludePiece> pieces(1);
+    pieces.back().text.swap(code);
+    while (!pieces.empty()) {
+        IncludePiece &piece = pieces.back();
+        if (_settings.terminated()) {
+            for (std::vector<IncludePiece>::reverse_iterator it = pieces.rbegin(); it != pieces.rend(); ++it)
+                result.append(it->text, it->pos, std::string::npos);
+            code.swap(result);
             return;
+        }
+
+        const std::string::size_type found = piece.text.find("#include", piece.pos);
+        if (found == std::string::npos) {
+            result.append(piece.text, piece.pos, std::string::npos);
+            pieces.pop_back();
+            continue;
+        }
+        result.append(piece.text, piece.pos, found - piece.pos);
+        piece.pos = found;
+        pos = result.size();
 
         // Accept only includes that are at the start of a line
-        if (pos > 0 && code[pos-1] != '\n') {
-            pos += 8; // length of "#include"
+        if (pos > 0 && result[pos-1] != '\n') {
+            result.append("#include");
+            piece.pos += 8; // length of "#include"
             continue;
         }
 
         // If endfile is encountered, we have moved to a next file in our stack,
         // so remove last path in our list.
-        while (!paths.empty() && (endfilePos = code.find("\n#endfile", endfilePos)) != std::string::npos && endfilePos < pos) {
+        while (!paths.empty() && (endfilePos = result.find("\n#endfile", endfilePos)) != std::string::npos && endfilePos < pos) {
             paths.pop_back();
             endfilePos += 9; // size of #endfile
         }
 
         endfilePos = pos;
-        std::string::size_type end = code.find('\n', pos);
-        std::string filename = code.substr(pos, end - pos);
+        const std::string::size_type end = piece.text.find('\n', piece.pos);
+        std::string filename = piece.text.substr(piece.pos, end - piece.pos);
 
         // Remove #include clause
-        code.erase(pos, end - pos);
+        piece.pos = (end == std::string::npos) ? piece.text.size() : end;
 
         HeaderTypes headerType = getHeaderFileName(filename);
         if (headerType == NoHeader)
@@ -2630,7 +2827,7 @@ void Preprocessor::handleIncludes(std::string &code, const std::string &filePath
         std::string filepath;
         if (headerType == UserHeader && !paths.empty())
             filepath = paths.back();
-        std::ifstream fin;
+        CSourceFile fin;
         const bool fileOpened(openHeader(filename, includePaths, filepath, fin, largeHeaderSet, _settings._big_header_file_size));
 
         if (fileOpened) {
@@ -2640,19 +2837,19 @@ void Preprocessor::handleIncludes(std::string &code, const std::string &filePath
             if (handledFiles.find(tempFile) != handledFiles.end()) {
                 // We have processed this file already once, skip
                 // it this time to avoid eternal loop.
-                fin.close();
+                fin.Close();
                 continue;
             }
 
             handledFiles.insert(tempFile);
-            processedFile = Preprocessor::read(fin, filename);
-            fin.close();
+            processedFile = Preprocessor::read(fin.Stream(), filename);
+            fin.Close();
         }
 
         if (!processedFile.empty()) {
             // Remove space characters that are after or before new line character
-            processedFile = "#file \"" + Path::fromNativeSeparators(filename) + "\"\n" + processedFile + "\n#endfile";
-            code.insert(pos, processedFile);
+            pieces.push_back(IncludePiece());
+            pieces.back().text = "#file \"" + Path::fromNativeSeparators(filename) + "\"\n" + processedFile + "\n#endfile";
 
             path = filename;
             path.erase(1 + path.find_last_of("\\/"));
@@ -2660,32 +2857,39 @@ void Preprocessor::handleIncludes(std::string &code, const std::string &filePath
         } else if (!fileOpened) {
             std::string f = filePath;
 
+            // The line number is counted in the written code, the look back
+            // below may compare a few characters past the include.
+            result.append(piece.text, piece.pos, 8U);
+
             // Determine line number of include
             unsigned int linenr = 1;
             unsigned int level = 0;
             for (std::string::size_type p = 1; p <= pos; ++p) {
-                if (level == 0 && code[pos-p] == '\n')
+                if (level == 0 && result[pos-p] == '\n')
                     ++linenr;
-                else if (code.compare(pos-p, 9, "#endfile\n") == 0) {
+                else if (result.compare(pos-p, 9, "#endfile\n") == 0) {
                     ++level;
-                } else if (code.compare(pos-p, 6, "#file ") == 0) {
+                } else if (result.compare(pos-p, 6, "#file ") == 0) {
                     if (level == 0) {
                         linenr--;
                         const std::string::size_type pos1 = pos - p + 7;
-                        const std::string::size_type pos2 = code.find_first_of("\"\n", pos1);
-                        f = code.substr(pos1, (pos2 == std::string::npos) ? pos2 : (pos2 - pos1));
+                        const std::string::size_type pos2 = result.find_first_of("\"\n", pos1);
+                        f = result.substr(pos1, (pos2 == std::string::npos) ? pos2 : (pos2 - pos1));
                         break;
                     }
                     --level;
                 }
             }
 
+            result.resize(pos);
+
             missingInclude(Path::toNativeSeparators(f),
                            linenr,
                            filename,
                            headerType);
         }
     }
+    code.swap(result);
 }
 
 // Report that include is missing
@@ -3033,7 +3237,7 @@ std::string Preprocessor::expandMacros_global(const std::string &code, std::stri
 					const std::string id = line.substr(pos1, pos - pos1);
 
 					// is there a macro with this name?
-					PreprocessorMacro* macro = CGlobalMacros::FindMacro(id, pCodeFile, macroBuffer);
+					PreprocessorMacro* macro = CGlobalMacros::FindMacro(id, pCodeFile, macroBuffer, tempMacroList);
 					if (!macro)
 						break;  // no macro with this name exist
 
@@ -3076,7 +3280,7 @@ std::string Preprocessor::expandMacros_global(const std::string &code, std::stri
 
 					// Create macro code..
 					std::string tempMacro;
-					if (!macro->code(params, macroBuffer, tempMacro, pCodeFile)) {
+					if (!macro->code(params, macroBuffer, tempMacroList, tempMacro, pCodeFile)) {
 						// Syntax error in code
 						writeError(filename,
 							linenr + tmpLinenr,
@@ -3239,8 +3443,9 @@ void Preprocessor::getMacros(CCodeFile* pFile)
 
 	std::string filename = Path::toNativeSeparators(pFile->GetFullPath());
 	std::map<std::string, PreprocessorMacro*> mapMacro;
-	std::ifstream fin(Path::toNativeSeparators(pFile->GetFullPath()).c_str());
-	std::string code = read(fin, filename);
+	CSourceFile fin;
+	fin.Open(filename);
+	std::string code = read(fin.Stream(), filename);
 
 	// Available macros (key=macroname, value=macro).
 	M_MAP macros;
@@ -3286,33 +3491,27 @@ void Preprocessor::getMacros(CCodeFile* pFile)
 		}
 	}
 
-	std::size_t code_length = code.length();
-	std::size_t index = 0;
-	while (index < code_length)
+	// one lexer pass over the file, typedefs are read from its tokens
+	TokenList tokenList(&_settings);
+	std::istringstream istr2(code);
+	tokenList.createTokens(istr2);
+	for (Token* tok = tokenList.front(); tok; tok = tok->next())
 	{
-		std::size_t start = code.find("typedef ", index);
-		if (start != std::string::npos)
+		if (tok->str() != "typedef")
 		{
-			std::size_t end = code.find(";", start + strlen("typedef "));
-
-			if (end != std::string::npos)
-			{
-				std::string str = code.substr(start, end - start + 1);
-				std::istringstream istr2(str);
-				TokenList tokenList(&_settings);
-				tokenList.createTokens(istr2);
-				SGTypeDef gTypedef;
-				if (CGlobalTypedefs::ExtractGTypeDef(tokenList, gTypedef))
-				{
-					typedefs[gTypedef.Name] = gTypedef;
-				}
-				index = end;
-			}
-			else
-				break;
+			continue;
 		}
-		else
+		SGTypeDef gTypedef;
+		if (CGlobalTypedefs::ExtractGTypeDef(tok, gTypedef))
+		{
+			typedefs[gTypedef.Name] = gTypedef;
+		}
+		// continue after the typedef
+		tok = Token::findsimplematch(tok, ";");
+		if (!tok)
+		{
 			break;
+		}
 	}
 	
 
@@ -27,6 +27,7 @@
 #include <list>
 #include <set>
 #include <stack>
+#include <vector>
 #include "config.h"
 #include "config.h"
 #include "filedepend.h"
@@ -70,6 +71,50 @@ struct SPackInfo
 	static SPackInfo Default;
 };
 
+/**
+ * @brief One segment of a CfgLineStream: a run of code lines, a single
+ * preprocessor directive or a "#pragma asm" block.
+ */
+struct CfgLineSegment {
+    enum Kind { CODE, DIRECTIVE, ASM };
+
+    CfgLineSegment(Kind kind_, std::size_t firstLine_, std::size_t branch_)
+        : kind(kind_), lines(0), firstLine(firstLine_), branch(branch_), branchEnd(std::string::npos), inert(true) {
+    }
+
+    Kind kind;
+    /** CODE: the lines, each ended by a newline. DIRECTIVE: the line. ASM: the "#pragma endasm" line, empty if there is none */
+    std::string text;
+    /** DIRECTIVE: Preprocessor::getdef() of the line */
+    std::string def;
+    std::string ndef;
+    /** CODE: number of lines. ASM: number of lines between "#pragma asm" and "#pragma endasm" */
+    unsigned int lines;
+    /** lines of the file before this segment */
+    std::size_t firstLine;
+    /** presence condition: the directive opening the #if branch this segment is in, npos outside of any #if */
+    std::size_t branch;
+    /** directive opening a branch: the #elif, #else or #endif ending the branch, npos if it is not ended */
+    std::size_t branchEnd;
+    /** directive opening a branch: there is no #undef, #file or #pragma in the branch, so it has no effect when not taken */
+    bool inert;
+};
+
+/**
+ * @brief The output of Preprocessor::preprocess() split into segments once,
+ * so that the code of every configuration is a cheap slice of it.
+ *
+ * Within a run of code lines every line has the same presence condition,
+ * a configuration keeps or blanks the run as a whole. Only the directives
+ * are evaluated per configuration, with the same semantics as
+ * Preprocessor::getcode().
+ */
+struct CfgLineStream {
+    std::vector<CfgLineSegment> segments;
+    /** lines of the file */
+    std::size_t lines;
+};
+
 /**
  * @brief The tscancode preprocessor.
  * The preprocessor has special functionality for extracting the various ifdef
@@ -141,6 +186,35 @@ public:
      */
     std::string getcode(const std::string &filedata, const std::string &cfg, const std::string &filename);
 
+    /**
+     * Get preprocessed code for a given configuration from a shared line stream
+     * @param stream file data split by splitLines()
+     * @param cfg configuration to read out
+     * @param filename name of source file
+     * @param skipDeadBranches blank inert branches that are not taken without evaluating
+     * the directives in them. The code is the same, but a broken condition in such a
+     * branch is not evaluated.
+     */
+    std::string getcode(const CfgLineStream &stream, const std::string &cfg, const std::string &filename, bool skipDeadBranches);
+
+    /**
+     * Split file data including preprocessing 'if', 'define', etc into the line
+     * stream shared by the configurations
+     */
+    static void splitLines(const std::string &filedata, CfgLineStream &stream);
+
+    /**
+     * Get the files of preprocessed code that have something to check: a
+     * function body, a class, enum or initializer block, or an initializer.
+     * Namespace and linkage blocks do not count, code with only
+     * declarations has nothing to check.
+     * @param code preprocessed code, with the headers in '#file' blocks
+     * @param filename name of source file, its own code is listed under this name
+     * @param files the files with something to check, with a fingerprint of
+     * their code in this configuration
+     */
+    static void getCheckableFiles(const std::string &code, const std::string &filename, std::map<std::string, unsigned long long> &files);
+
     /**
      * simplify condition
      * @param variables Variable values
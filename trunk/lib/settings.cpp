@@ -43,6 +43,8 @@ Settings::Settings()
 	  debugDumpSimp2(false),
       
 	  dump(false),
+      _dumpFormat(DUMP_XML),
+      _dumpSections(DUMP_ALL),
       exceptionHandling(false),
       inconclusive(true), // default to true
       jointSuppressionReport(false),
@@ -56,10 +58,17 @@ Settings::Settings()
       _relativePaths(false),
       _xml(false), _xml_version(1),
       _jobs(1),
+      _functionJobs(1),
       _loadAverage(0),
+      _memoryBudget(0),
+      _windowSize(0),
       _exitCode(0),
       _showtime(SHOWTIME_NONE),
+      _workCountersTolerance(5),
       _maxConfigs(1),
+      _variabilityAware(false),
+      _compactTokens(true),
+      _skipThinFiles(false),
       enforcedLang(None),
       reportProgress(false),
       checkConfiguration(false),
@@ -31,6 +31,9 @@
 #include "suppressions.h"
 #include "standards.h"
 #include "timer.h"
+#include "dumpwriter.h"
+#include "changedlines.h"
+#include "baseline.h"
 
 /// @addtogroup Core
 /// @{
@@ -100,6 +103,24 @@ public:
     /** @brief Is --dump given? */
     bool dump;
 
+    /** @brief format of the --dump output (--dump-format=xml|jsonl) */
+    DUMP_FORMATS _dumpFormat;
+
+    /** @brief DUMP_SECTIONS written by --dump (--dump-sections=tokens,scopes,..) */
+    unsigned int _dumpSections;
+
+    /** @brief store of per function findings (--incremental-dir=), empty if not used */
+    std::string _incrementalDir;
+
+    /** @brief only check and report code touched by a change (--diff-scope=) */
+    ChangedLines _changedLines;
+
+    /** @brief findings of an earlier run that are not reported again (--baseline=) */
+    Baseline _baseline;
+
+    /** @brief write the fingerprints of all findings to this file (--baseline-out=) */
+    std::string _baselineOut;
+
     /** @brief Is --exception-handling given */
     bool exceptionHandling;
 
@@ -157,9 +178,22 @@ public:
         time. Default is 1. (-j N) */
     unsigned int _jobs;
 
+    /** @brief How many threads check the functions of one file in the checks
+        that support it. Default is 1. (--function-jobs=N) */
+    unsigned int _functionJobs;
+
     /** @brief Load average value */
     unsigned int _loadAverage;
 
+    /** @brief Resident memory for global macro definitions in MB, the rest
+        is spilled to disk. Default is 0, no limit. (--memory-budget=N) */
+    unsigned int _memoryBudget;
+
+    /** @brief Configurations whose preprocessed code is larger than this
+        many MB are checked in windows of function bodies of about this
+        size. Default is 0, off. (--window-size=N) */
+    unsigned int _windowSize;
+
     /** @brief If errors are found, this value is returned from main().
         Default value is 0. */
     int _exitCode;
@@ -171,6 +205,15 @@ public:
     /** @brief show timing information (--showtime=file|summary|top5) */
     SHOWTIME_MODES _showtime;
 
+    /** @brief write the work counts to this file (--work-counters=) */
+    std::string _workCounters;
+
+    /** @brief compare the work counts with this file (--work-counters-baseline=) */
+    std::string _workCountersBaseline;
+
+    /** @brief allowed growth of a work count in percent (--work-counters-tolerance=) */
+    unsigned int _workCountersTolerance;
+
     /** @brief List of include paths, e.g. "my/includes/" which should be used
         for finding include files inside source files. (-I) */
     std::list<std::string> _includePaths;
@@ -185,6 +228,19 @@ public:
         Default is 1. (--max-configs=N) */
     unsigned int _maxConfigs;
 
+    /** @brief Get the code of all configurations from one shared line stream
+        and check configurations with the same code once (--variability-aware) */
+    bool _variabilityAware;
+
+    /** @brief Move the tokens into one block in list order after the
+        simplifications. Default is true. (--no-compact-tokens) */
+    bool _compactTokens;
+
+    /** @brief Do not check configurations with only declarations outside of
+        headers checked before, their declarations are still recorded in the
+        analyze pass. Default is false. (--skip-thin-files) */
+    bool _skipThinFiles;
+
     /**
      * @brief Returns true if given id is in the list of
      * enabled extra checks (--enable)
@@ -0,0 +1,260 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sideoutput.h"
+
+#include <atomic>
+#include <fstream>
+#include <list>
+#include <map>
+#include <queue>
+#include <set>
+#include <vector>
+#ifdef TSC_THREADING_MODEL_WIN
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+bool SideOutput::_open[SIDE_OUTPUT_SIZE];
+
+namespace {
+    enum MERGE {
+        MERGE_SORTED_UNIQUE,
+        MERGE_CONCATENATE,
+        MERGE_KEYED
+    };
+
+    // how the shards of each channel are merged, in SIDE_OUTPUT_CHANNEL order
+    const MERGE channelMerge[SIDE_OUTPUT_SIZE] = {
+        MERGE_CONCATENATE,
+        MERGE_SORTED_UNIQUE,
+        MERGE_KEYED
+    };
+
+    struct Shard {
+        std::vector<std::string> lines;
+        // the lines of a sorted unique channel, a thread that repeats a line keeps one copy
+        std::set<std::string> uniqueLines;
+        std::map<std::string, std::string> texts;
+    };
+
+    // the shards of one thread
+    struct ShardSet {
+        Shard shards[SIDE_OUTPUT_SIZE];
+    };
+
+    // everything one flush() writes
+    struct Output {
+        std::string paths[SIDE_OUTPUT_SIZE];
+        bool open[SIDE_OUTPUT_SIZE];
+        std::list<ShardSet *> shardSets;
+    };
+
+    // the next line of a sorted shard in the k-way merge
+    struct Cursor {
+        std::set<std::string>::const_iterator pos;
+        std::set<std::string>::const_iterator end;
+    };
+
+    struct CursorAfter {
+        bool operator()(const Cursor &a, const Cursor &b) const {
+            return *b.pos < *a.pos;
+        }
+    };
+}
+
+// the shards of this thread, registered in shardSets on first use. A thread
+// that appended before the last flush() starts new shards.
+static TSC_THREAD_LOCAL ShardSet *shardSetOfThread = nullptr;
+static TSC_THREAD_LOCAL unsigned int generationOfThread = 0;
+// counts the flush() calls, read by every appending thread
+static std::atomic<unsigned int> generation(1);
+static std::list<ShardSet *> shardSets;
+static std::string paths[SIDE_OUTPUT_SIZE];
+static TSC_LOCK shardSetsLock;
+static bool lockInitialized = false;
+static TSC_THREAD writer;
+static bool writing = false;
+
+static Shard &shardOfThread(SIDE_OUTPUT_CHANNEL channel)
+{
+    const unsigned int current = generation.load();
+    if (!shardSetOfThread || generationOfThread != current) {
+        shardSetOfThread = new ShardSet;
+        generationOfThread = current;
+        TSC_LOCK_ENTER(&shardSetsLock);
+        shardSets.push_back(shardSetOfThread);
+        TSC_LOCK_LEAVE(&shardSetsLock);
+    }
+    return shardSetOfThread->shards[channel];
+}
+
+void SideOutput::open(SIDE_OUTPUT_CHANNEL channel, const std::string &path)
+{
+    if (!lockInitialized) {
+        TSC_LOCK_INIT(&shardSetsLock);
+        lockInitialized = true;
+    }
+    paths[channel] = path;
+    _open[channel] = true;
+}
+
+void SideOutput::append(SIDE_OUTPUT_CHANNEL channel, const std::string &line)
+{
+    if (!_open[channel])
+        return;
+    if (channelMerge[channel] == MERGE_SORTED_UNIQUE)
+        shardOfThread(channel).uniqueLines.insert(line);
+    else
+        shardOfThread(channel).lines.push_back(line);
+}
+
+void SideOutput::append(SIDE_OUTPUT_CHANNEL channel, const std::string &key, const std::string &text)
+{
+    if (_open[channel])
+        shardOfThread(channel).texts[key] += text;
+}
+
+static void writeSortedUnique(const std::list<ShardSet *> &shardSets, SIDE_OUTPUT_CHANNEL channel, std::ofstream &out)
+{
+    std::priority_queue<Cursor, std::vector<Cursor>, CursorAfter> cursors;
+    for (std::list<ShardSet *>::const_iterator set = shardSets.begin(); set != shardSets.end(); ++set) {
+        const std::set<std::string> &lines = (*set)->shards[channel].uniqueLines;
+        if (lines.empty())
+            continue;
+        Cursor cursor;
+        cursor.pos = lines.begin();
+        cursor.end = lines.end();
+        cursors.push(cursor);
+    }
+
+    const std::string *last = nullptr;
+    while (!cursors.empty()) {
+        Cursor cursor = cursors.top();
+        cursors.pop();
+        if (!last || *last != *cursor.pos)
+            out << *cursor.pos << "\n";
+        last = &*cursor.pos;
+        if (++cursor.pos != cursor.end)
+            cursors.push(cursor);
+    }
+}
+
+static void write(const Output &output)
+{
+    for (int i = 0; i < SIDE_OUTPUT_SIZE; ++i) {
+        if (!output.open[i])
+            continue;
+        const SIDE_OUTPUT_CHANNEL channel = (SIDE_OUTPUT_CHANNEL)i;
+
+        if (channelMerge[channel] == MERGE_KEYED) {
+            std::map<std::string, std::string> texts;
+            for (std::list<ShardSet *>::const_iterator set = output.shardSets.begin(); set != output.shardSets.end(); ++set) {
+                const std::map<std::string, std::string> &shard = (*set)->shards[channel].texts;
+                for (std::map<std::string, std::string>::const_iterator text = shard.begin(); text != shard.end(); ++text)
+                    texts[text->first] += text->second;
+            }
+            for (std::map<std::string, std::string>::const_iterator text = texts.begin(); text != texts.end(); ++text) {
+                std::ofstream out((output.paths[channel] + text->first).c_str(), std::ios::trunc);
+                out << text->second;
+            }
+            continue;
+        }
+
+        std::ofstream out(output.paths[channel].c_str(), std::ios::trunc);
+        if (!out)
+            continue;
+        if (channelMerge[channel] == MERGE_SORTED_UNIQUE) {
+            writeSortedUnique(output.shardSets, channel, out);
+        } else {
+            for (std::list<ShardSet *>::const_iterator set = output.shardSets.begin(); set != output.shardSets.end(); ++set) {
+                const std::vector<std::string> &lines = (*set)->shards[channel].lines;
+                for (std::vector<std::string>::const_iterator line = lines.begin(); line != lines.end(); ++line)
+                    out << *line << "\n";
+            }
+        }
+    }
+}
+
+static void writeAndDelete(Output *output)
+{
+    write(*output);
+    for (std::list<ShardSet *>::const_iterator set = output->shardSets.begin(); set != output->shardSets.end(); ++set)
+        delete *set;
+    delete output;
+}
+
+#ifdef TSC_THREADING_MODEL_WIN
+static unsigned int __stdcall writerProc(void *arg)
+#else
+static void *writerProc(void *arg)
+#endif
+{
+    writeAndDelete(static_cast<Output *>(arg));
+    return 0;
+}
+
+void SideOutput::flush()
+{
+    wait();
+
+    Output *output = new Output;
+    bool anyOpen = false;
+    for (int i = 0; i < SIDE_OUTPUT_SIZE; ++i) {
+        output->paths[i] = paths[i];
+        output->open[i] = _open[i];
+        anyOpen = anyOpen || _open[i];
+        _open[i] = false;
+    }
+    if (lockInitialized) {
+        TSC_LOCK_ENTER(&shardSetsLock);
+        output->shardSets.swap(shardSets);
+        TSC_LOCK_LEAVE(&shardSetsLock);
+    }
+    ++generation;
+
+    if (!anyOpen) {
+        writeAndDelete(output);
+        return;
+    }
+
+    // the files are written on this thread if no thread can be started
+#ifdef TSC_THREADING_MODEL_WIN
+    writer = (HANDLE)_beginthreadex(NULL, 0, writerProc, output, 0, NULL);
+    writing = writer != 0;
+#else
+    writing = pthread_create(&writer, nullptr, writerProc, output) == 0;
+#endif
+    if (!writing)
+        writeAndDelete(output);
+}
+
+void SideOutput::wait()
+{
+    if (!writing)
+        return;
+#ifdef TSC_THREADING_MODEL_WIN
+    WaitForSingleObject(writer, INFINITE);
+    CloseHandle(writer);
+#else
+    pthread_join(writer, nullptr);
+#endif
+    writing = false;
+}
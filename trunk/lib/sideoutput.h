@@ -0,0 +1,77 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//---------------------------------------------------------------------------
+#ifndef sideoutputH
+#define sideoutputH
+//---------------------------------------------------------------------------
+
+#include <string>
+#include "config.h"
+
+/** the files written next to the report, see SideOutput */
+enum SIDE_OUTPUT_CHANNEL {
+    SIDE_OUTPUT_FUNCINFO = 0,   // funcinfo.txt (--recordfuncinfo), concatenated
+    SIDE_OUTPUT_LUA_EXPORT,     // cpp.lua.exp (--lua), sorted unique
+    SIDE_OUTPUT_GLOBAL_DUMP,    // log/gt_data_<n>.log (--dump-global), keyed
+    SIDE_OUTPUT_SIZE
+};
+
+/**
+ * @brief Buffered output of the files that are written besides the report.
+ *
+ * Records are appended to a shard of the current thread without locking.
+ * flush() closes the channels and merges the shards of all threads on a
+ * background thread, so the merge and the file writes overlap the work
+ * that follows. How the shards of a channel are merged is fixed per
+ * channel:
+ * - sorted unique: the lines of all shards, sorted and without duplicates
+ * - concatenated: the lines of the shards, one shard after the other in the
+ *   order the threads appended their first record
+ * - keyed: the texts of a key are concatenated in shard order and every key
+ *   is written to its own file, path + key
+ */
+class TSCANCODELIB SideOutput {
+public:
+    /** @brief start collecting the records of a channel, written to path by flush() */
+    static void open(SIDE_OUTPUT_CHANNEL channel, const std::string &path);
+
+    static bool isOpen(SIDE_OUTPUT_CHANNEL channel) {
+        return _open[channel];
+    }
+
+    /** @brief append a line to a sorted unique or concatenated channel, ignored if it is not open */
+    static void append(SIDE_OUTPUT_CHANNEL channel, const std::string &line);
+
+    /** @brief append text under key to a keyed channel, ignored if it is not open */
+    static void append(SIDE_OUTPUT_CHANNEL channel, const std::string &key, const std::string &text);
+
+    /**
+     * @brief close all channels and write them on a background thread
+     * No other thread may append while flush() runs.
+     */
+    static void flush();
+
+    /** @brief wait until the files of the last flush() are written */
+    static void wait();
+
+private:
+    static bool _open[SIDE_OUTPUT_SIZE];
+};
+
+//---------------------------------------------------------------------------
+#endif // sideoutputH
@@ -23,6 +23,7 @@
 #include "token.h"
 #include "settings.h"
 #include "errorlogger.h"
+#include "dumpwriter.h"
 
 #include <string>
 #include <ostream>
@@ -2191,9 +2192,9 @@ bool Variable::arrayDimensions(const Library* lib)
     return arr;
 }
 
-static std::ostream & operator << (std::ostream & s, Scope::ScopeType type)
+static const char *scopeTypeName(Scope::ScopeType type)
 {
-    s << (type == Scope::eGlobal ? "Global" :
+    return (type == Scope::eGlobal ? "Global" :
           type == Scope::eClass ? "Class" :
           type == Scope::eStruct ? "Struct" :
           type == Scope::eUnion ? "Union" :
@@ -2210,6 +2211,11 @@ static std::ostream & operator << (std::ostream & s, Scope::ScopeType type)
           type == Scope::eUnconditional ? "Unconditional" :
           type == Scope::eLambda ? "Lambda" :
           "Unknown");
+}
+
+static std::ostream & operator << (std::ostream & s, Scope::ScopeType type)
+{
+    s << scopeTypeName(type);
     return s;
 }
 
@@ -2481,104 +2487,98 @@ void SymbolDatabase::printOut(const char *title) const
     std::cout << std::resetiosflags(std::ios::boolalpha);
 }
 
-static std::string toxml(const std::string &str)
+void SymbolDatabase::printXml(std::ostream &out) const
 {
-    std::ostringstream xml;
-    for (std::size_t i = 0U; i < str.length(); i++) {
-        char c = str[i];
-        switch (c) {
-        case '<':
-            xml << "&lt;";
-            break;
-        case '>':
-            xml << "&gt;";
-            break;
-        case '&':
-            xml << "&amp;";
-            break;
-        case '\"':
-            xml << "&quot;";
-            break;
-        default:
-            xml << c;
-            break;
-        }
-    }
-    return xml.str();
+    DumpWriter writer(out);
+    dump(writer);
 }
 
-void SymbolDatabase::printXml(std::ostream &out) const
+void SymbolDatabase::dump(DumpWriter &writer) const
 {
-    out << std::setiosflags(std::ios::boolalpha);
     // Scopes..
-    out << "  <scopes>" << std::endl;
-    for (std::list<Scope>::const_iterator scope = scopeList.begin(); scope != scopeList.end(); ++scope) {
-        out << "    <scope";
-        out << " id=\"" << &*scope << "\"";
-        out << " type=\"" << scope->type << "\"";
-        if (!scope->className.empty())
-            out << " className=\"" << toxml(scope->className) << "\"";
-        if (scope->classStart)
-            out << " classStart=\"" << scope->classStart << '\"';
-        if (scope->classEnd)
-            out << " classEnd=\"" << scope->classEnd << '\"';
-        if (scope->nestedIn)
-            out << " nestedIn=\"" << scope->nestedIn << "\"";
-        if (scope->function)
-            out << " function=\"" << scope->function << "\"";
-        if (scope->functionList.empty() && scope->varlist.empty())
-            out << "/>" << std::endl;
-        else {
-            out << '>' << std::endl;
+    if (writer.wants(DUMP_SCOPES)) {
+        writer.openList("scopes");
+        for (std::list<Scope>::const_iterator scope = scopeList.begin(); scope != scopeList.end(); ++scope) {
+            writer.beginElement("scope");
+            writer.attrPtr("id", &*scope);
+            writer.attrLit("type", scopeTypeName(scope->type));
+            if (!scope->className.empty())
+                writer.attrStr("className", scope->className);
+            if (scope->classStart)
+                writer.attrPtr("classStart", scope->classStart);
+            if (scope->classEnd)
+                writer.attrPtr("classEnd", scope->classEnd);
+            if (scope->nestedIn)
+                writer.attrPtr("nestedIn", scope->nestedIn);
+            if (scope->function)
+                writer.attrPtr("function", scope->function);
+            if (scope->functionList.empty() && scope->varlist.empty()) {
+                writer.endElement();
+                continue;
+            }
+            writer.endElement(true);
             if (!scope->functionList.empty()) {
-                out << "      <functionList>" << std::endl;
+                writer.openList("functionList");
                 for (std::list<Function>::const_iterator function = scope->functionList.begin(); function != scope->functionList.end(); ++function) {
-                    out << "        <function id=\"" << &*function << "\" tokenDef=\"" << function->tokenDef << "\" name=\"" << toxml(function->name()) << '\"';
-                    if (function->argCount() == 0U)
-                        out << "/>" << std::endl;
-                    else {
-                        out << ">" << std::endl;
-                        for (unsigned int argnr = 0; argnr < function->argCount(); ++argnr) {
-                            const Variable *arg = function->getArgumentVar(argnr);
-                            out << "          <arg nr=\"" << argnr+1 << "\" variable=\"" << arg << "\"/>" << std::endl;
-                        }
-                        out << "        </function>" << std::endl;
+                    writer.beginElement("function");
+                    writer.attrPtr("id", &*function);
+                    writer.parent("scope", &*scope);
+                    writer.attrPtr("tokenDef", function->tokenDef);
+                    writer.attrStr("name", function->name());
+                    if (function->argCount() == 0U) {
+                        writer.endElement();
+                        continue;
                     }
+                    writer.endElement(true);
+                    for (unsigned int argnr = 0; argnr < function->argCount(); ++argnr) {
+                        writer.beginElement("arg");
+                        writer.parent("function", &*function);
+                        writer.attrInt("nr", argnr + 1);
+                        writer.attrPtr("variable", function->getArgumentVar(argnr));
+                        writer.endElement();
+                    }
+                    writer.closeElement("function");
                 }
-                out << "      </functionList>" << std::endl;
+                writer.closeList("functionList");
             }
             if (!scope->varlist.empty()) {
-                out << "      <varlist>" << std::endl;
-                for (std::list<Variable>::const_iterator var = scope->varlist.begin(); var != scope->varlist.end(); ++var)
-                    out << "        <var id=\""   << &*var << "\"/>" << std::endl;
-                out << "      </varlist>" << std::endl;
+                writer.openList("varlist");
+                for (std::list<Variable>::const_iterator var = scope->varlist.begin(); var != scope->varlist.end(); ++var) {
+                    writer.beginElement("var");
+                    writer.attrPtr("id", &*var);
+                    writer.parent("scope", &*scope);
+                    writer.endElement();
+                }
+                writer.closeList("varlist");
             }
-            out << "    </scope>" << std::endl;
+            writer.closeElement("scope");
         }
+        writer.closeList("scopes");
     }
-    out << "  </scopes>" << std::endl;
 
     // Variables..
-    out << "  <variables>" << std::endl;
-	for (std::size_t i = 1U; i < _variableList.size(); i++) {
-        const Variable *var = _variableList[i];
-        if (!var)
-            continue;
-        out << "    <var id=\""   << var << '\"';
-        out << " nameToken=\""      << var->nameToken() << '\"';
-        out << " typeStartToken=\"" << var->typeStartToken() << '\"';
-        out << " typeEndToken=\""   << var->typeEndToken() << '\"';
-        out << " isArgument=\""     << var->isArgument() << '\"';
-        out << " isArray=\""        << var->isArray() << '\"';
-        out << " isClass=\""        << var->isClass() << '\"';
-        out << " isLocal=\""        << var->isLocal() << '\"';
-        out << " isPointer=\""      << var->isPointer() << '\"';
-        out << " isReference=\""    << var->isReference() << '\"';
-        out << " isStatic=\""       << var->isStatic() << '\"';
-        out << "/>" << std::endl;
-    }
-    out << "  </variables>" << std::endl;
-    out << std::resetiosflags(std::ios::boolalpha);
+    if (writer.wants(DUMP_VARIABLES)) {
+        writer.openList("variables");
+        for (std::size_t i = 1U; i < _variableList.size(); i++) {
+            const Variable *var = _variableList[i];
+            if (!var)
+                continue;
+            writer.beginElement("var");
+            writer.attrPtr("id", var);
+            writer.attrPtr("nameToken", var->nameToken());
+            writer.attrPtr("typeStartToken", var->typeStartToken());
+            writer.attrPtr("typeEndToken", var->typeEndToken());
+            writer.attrBool("isArgument", var->isArgument());
+            writer.attrBool("isArray", var->isArray());
+            writer.attrBool("isClass", var->isClass());
+            writer.attrBool("isLocal", var->isLocal());
+            writer.attrBool("isPointer", var->isPointer());
+            writer.attrBool("isReference", var->isReference());
+            writer.attrBool("isStatic", var->isStatic());
+            writer.endElement();
+        }
+        writer.closeList("variables");
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -3449,6 +3449,60 @@ const Scope *SymbolDatabase::findScopeByName(const std::string& name) const
     return 0;
 }
 
+const ClassMembers &SymbolDatabase::classMembers(const Scope *scope) const
+{
+    std::map<const Scope *, ClassMembers>::iterator it = _classMembers.find(scope);
+    if (it != _classMembers.end())
+        return it->second;
+
+    // added before the bases are visited, a cyclic hierarchy ends here
+    ClassMembers &members = _classMembers[scope];
+    members.scopes.insert(scope);
+
+    std::size_t index = 0;
+    for (std::list<Variable>::const_iterator var = scope->varlist.begin(); var != scope->varlist.end(); ++var, ++index) {
+        if (members.variables.find(var->name()) != members.variables.end())
+            continue;
+        ClassMembers::MemberVar &member = members.variables[var->name()];
+        member.variable = &*var;
+        member.origin = scope;
+        member.index = index;
+        member.isStatic = var->isStatic();
+        member.isConst = var->isConst();
+        member.isInstanceMember = !var->isStatic();
+    }
+
+    if (!scope->definedType)
+        return members;
+
+    for (std::size_t i = 0; i < scope->definedType->derivedFrom.size(); ++i) {
+        const Type *base = scope->definedType->derivedFrom[i].type;
+        if (!base || !base->classScope) {
+            members.unknownBase = true;
+            continue;
+        }
+
+        for (std::list<Function>::const_iterator func = base->classScope->functionList.begin(); func != base->classScope->functionList.end(); ++func) {
+            if (func->tokenDef)
+                members.directBaseFunctions.insert(func->tokenDef->str());
+        }
+
+        const ClassMembers &baseMembers = classMembers(base->classScope);
+        if (&baseMembers == &members)
+            continue;
+        members.scopes.insert(baseMembers.scopes.begin(), baseMembers.scopes.end());
+        for (std::unordered_map<std::string, ClassMembers::MemberVar>::const_iterator var = baseMembers.variables.begin(); var != baseMembers.variables.end(); ++var) {
+            std::unordered_map<std::string, ClassMembers::MemberVar>::iterator own = members.variables.find(var->first);
+            if (own == members.variables.end())
+                members.variables.insert(*var);
+            else if (own->second.origin != scope && var->second.isInstanceMember)
+                own->second.isInstanceMember = true;
+        }
+    }
+
+    return members;
+}
+
 //---------------------------------------------------------------------------
 
 Scope *Scope::findInNestedList(const std::string & name)
@@ -27,6 +27,8 @@
 #include <set>
 #include <algorithm>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "config.h"
 #include "token.h"
@@ -37,6 +39,7 @@ class Tokenizer;
 class Settings;
 class ErrorLogger;
 class Library;
+class DumpWriter;
 
 class Scope;
 class SymbolDatabase;
@@ -978,6 +981,54 @@ private:
     void findFunctionInBase(const std::string & name, size_t args, std::vector<const Function *> & matches) const;
 };
 
+/**
+ * @brief The members of a class and of all its base classes in one table,
+ * see SymbolDatabase::classMembers()
+ */
+class TSCANCODELIB ClassMembers {
+public:
+    ClassMembers() : unknownBase(false) {
+    }
+
+    /** @brief A member variable visible in the class */
+    struct MemberVar {
+        const Variable *variable;
+
+        /** @brief class that declares the variable */
+        const Scope *origin;
+
+        /** @brief position of the variable in origin->varlist */
+        std::size_t index;
+
+        bool isStatic;
+        bool isConst;
+
+        /**
+         * @brief the name refers to a non-static member: the first variable
+         * of that name in the class is not static or, if the class does not
+         * declare the name, this holds for one of its base classes
+         */
+        bool isInstanceMember;
+    };
+
+    /** @brief member variables by name, the declaration of the nearest class */
+    std::unordered_map<std::string, MemberVar> variables;
+
+    /** @brief the class and all its direct and indirect base classes */
+    std::unordered_set<const Scope *> scopes;
+
+    /** @brief names of the member functions of the direct base classes */
+    std::unordered_set<std::string> directBaseFunctions;
+
+    /** @brief a direct base class is not in the database */
+    bool unknownBase;
+
+    const MemberVar *findVariable(const std::string &name) const {
+        const std::unordered_map<std::string, MemberVar>::const_iterator it = variables.find(name);
+        return it == variables.end() ? nullptr : &it->second;
+    }
+};
+
 class TSCANCODELIB SymbolDatabase {
 public:
     SymbolDatabase(const Tokenizer *tokenizer, const Settings *settings, ErrorLogger *errorLogger);
@@ -1012,6 +1063,12 @@ public:
 
     const Scope *findScopeByName(const std::string& name) const;
 
+    /**
+     * @brief members of a class and its base classes, built on first use
+     * and kept as long as the database. Not thread safe.
+     */
+    const ClassMembers &classMembers(const Scope *scope) const;
+
     const Type* findType(const Token *tok, const Scope *startScope) const;
     Type* findType(const Token *tok, Scope *startScope) const {
         return const_cast<Type*>(this->findType(tok, const_cast<const Scope *>(startScope)));
@@ -1038,6 +1095,7 @@ public:
     void printOut(const char * title = NULL) const;
     void printVariable(const Variable *var, const char *indent) const;
     void printXml(std::ostream &out) const;
+    void dump(DumpWriter &writer) const;
 
     bool isCPP() const;
 
@@ -1075,6 +1133,9 @@ private:
 
     /** list for missing types */
     std::list<Type> _blankTypes;
+
+    /** flattened class members, see classMembers() */
+    mutable std::map<const Scope *, ClassMembers> _classMembers;
 };
 
 /** Value type */
@@ -0,0 +1,117 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "taskpool.h"
+#include "workcounters.h"
+
+#include <string>
+#include <vector>
+#ifdef TSC_THREADING_MODEL_WIN
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace {
+    struct Job {
+        TaskPool::Task *task;
+        void *context;
+        std::size_t count;
+        std::size_t next;
+        TSC_LOCK lock;
+        std::string phase;
+    };
+
+    struct Worker {
+        Job *job;
+        unsigned int thread;
+    };
+}
+
+static void work(Job &job, unsigned int thread)
+{
+    for (;;) {
+        TSC_LOCK_ENTER(&job.lock);
+        const std::size_t index = job.next++;
+        TSC_LOCK_LEAVE(&job.lock);
+        if (index >= job.count)
+            return;
+        job.task(job.context, thread, index);
+    }
+}
+
+#ifdef TSC_THREADING_MODEL_WIN
+static unsigned int __stdcall threadProc(void *arg)
+#else
+static void *threadProc(void *arg)
+#endif
+{
+    Worker *worker = static_cast<Worker *>(arg);
+    WorkPhase phase(worker->job->phase);
+    work(*worker->job, worker->thread);
+    return 0;
+}
+
+void TaskPool::run(Task *task, void *context, std::size_t count, unsigned int jobs)
+{
+    if (jobs > count)
+        jobs = (unsigned int)count;
+    if (jobs <= 1) {
+        for (std::size_t i = 0; i < count; ++i)
+            task(context, 0, i);
+        return;
+    }
+
+    Job job;
+    job.task = task;
+    job.context = context;
+    job.count = count;
+    job.next = 0;
+    job.phase = WorkPhase::currentName();
+    TSC_LOCK_INIT(&job.lock);
+
+    // a thread that can not be started leaves its tasks to the others
+    std::vector<Worker> workers(jobs);
+    std::vector<TSC_THREAD> threads;
+    for (unsigned int i = 1; i < jobs; ++i) {
+        workers[i].job = &job;
+        workers[i].thread = i;
+#ifdef TSC_THREADING_MODEL_WIN
+        const HANDLE thread = (HANDLE)_beginthreadex(NULL, 0, threadProc, &workers[i], 0, NULL);
+        if (thread)
+            threads.push_back(thread);
+#else
+        pthread_t thread;
+        if (pthread_create(&thread, nullptr, threadProc, &workers[i]) == 0)
+            threads.push_back(thread);
+#endif
+    }
+
+    work(job, 0);
+
+    for (std::size_t i = 0; i < threads.size(); ++i) {
+#ifdef TSC_THREADING_MODEL_WIN
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], nullptr);
+#endif
+    }
+    TSC_LOCK_DELETE(&job.lock);
+}
@@ -0,0 +1,50 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//---------------------------------------------------------------------------
+#ifndef taskpoolH
+#define taskpoolH
+//---------------------------------------------------------------------------
+
+#include <cstddef>
+#include "config.h"
+
+/**
+ * @brief Runs the tasks 0..count-1 of one job on a few threads.
+ *
+ * Every thread takes the next task from a shared counter, so tasks of very
+ * different size are balanced. The calling thread works as thread 0 and
+ * run() returns when all tasks are done. The work counters of the tasks are
+ * counted in the WorkPhase of the calling thread.
+ */
+class TSCANCODELIB TaskPool {
+public:
+    /** @brief a task, thread is the index of the thread running it, 0..jobs-1 */
+    typedef void Task(void *context, unsigned int thread, std::size_t index);
+
+    /**
+     * @brief run all tasks
+     * @param task the task
+     * @param context passed to every task
+     * @param count number of tasks
+     * @param jobs number of threads, the tasks run in order on the calling thread if 1
+     */
+    static void run(Task *task, void *context, std::size_t count, unsigned int jobs);
+};
+
+//---------------------------------------------------------------------------
+#endif // taskpoolH
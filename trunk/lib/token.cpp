@@ -22,6 +22,7 @@
 #include "check.h"
 #include "settings.h"
 #include "symboldatabase.h"
+#include "workcounters.h"
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
@@ -59,6 +60,31 @@ Token::Token(Token **t) :
     _originalName(nullptr),
     valuetype(nullptr)
 {
+    WorkCounters::add(WORK_TOKENS_CREATED);
+}
+
+Token::Token(Token **t, Token *from) :
+    tokensBack(t),
+    _next(0),
+    _previous(0),
+    _link(from->_link),
+    _scope(from->_scope),
+    _function(from->_function), // Copy whole union
+    _varId(from->_varId),
+    _fileIndex(from->_fileIndex),
+    _linenr(from->_linenr),
+    _progressValue(from->_progressValue),
+    _tokType(from->_tokType),
+    _flags(from->_flags),
+    _astOperand1(from->_astOperand1),
+    _astOperand2(from->_astOperand2),
+    _astParent(from->_astParent),
+    _originalName(from->_originalName),
+    valuetype(from->valuetype)
+{
+    _str.swap(from->_str);
+    from->_originalName = nullptr;
+    from->valuetype = nullptr;
 }
 
 Token::~Token()
@@ -67,6 +93,64 @@ Token::~Token()
     delete valuetype;
 }
 
+namespace {
+    /** precedes every token, keeps the token behind it aligned */
+    union TokenSlotHeader {
+        bool inBlock;
+        long double alignLongDouble;
+        void *alignPointer;
+    };
+
+    std::size_t tokenSlotSize()
+    {
+        const std::size_t align = sizeof(TokenSlotHeader);
+        return sizeof(TokenSlotHeader) + (sizeof(Token) + align - 1) / align * align;
+    }
+}
+
+void *Token::operator new(std::size_t size)
+{
+    TokenSlotHeader *header = static_cast<TokenSlotHeader *>(::operator new(sizeof(TokenSlotHeader) + size));
+    header->inBlock = false;
+    return header + 1;
+}
+
+void *Token::operator new(std::size_t, void *slot)
+{
+    TokenSlotHeader *header = static_cast<TokenSlotHeader *>(slot);
+    header->inBlock = true;
+    return header + 1;
+}
+
+void Token::operator delete(void *p)
+{
+    if (!p)
+        return;
+    TokenSlotHeader *header = static_cast<TokenSlotHeader *>(p) - 1;
+    // tokens in a block are released together with the block
+    if (!header->inBlock)
+        ::operator delete(header);
+}
+
+void Token::operator delete(void *, void *)
+{
+}
+
+void *Token::allocateBlock(std::size_t count)
+{
+    return ::operator new(count * tokenSlotSize());
+}
+
+void Token::freeBlock(void *block)
+{
+    ::operator delete(block);
+}
+
+void *Token::blockSlot(void *block, std::size_t index)
+{
+    return static_cast<char *>(block) + index * tokenSlotSize();
+}
+
 void Token::update_property_info()
 {
     if (!_str.empty()) {
@@ -537,12 +621,15 @@ bool Token::simpleMatch(const Token *tok, const char pattern[])
 {
     if (!tok)
         return false; // shortcut
+    WorkCounters::add(WORK_MATCH_CALLS);
+    WorkCount steps(WORK_MATCH_STEPS);
     const char *current  = pattern;
     const char *next = std::strchr(pattern, ' ');
     if (!next)
         next = pattern + std::strlen(pattern);
 
     while (*current) {
+        ++steps;
         std::size_t length = next - current;
 
         if (!tok || length != tok->_str.length() || std::strncmp(current, tok->_str.c_str(), length))
@@ -590,8 +677,12 @@ const char *Token::chrInFirstWord(const char *str, char c)
 
 bool Token::Match(const Token *tok, const char pattern[], unsigned int varid)
 {
+    WorkCounters::add(WORK_MATCH_CALLS);
+    WorkCount steps(WORK_MATCH_STEPS);
     const char *p = pattern;
     while (*p) {
+        ++steps;
+
         // Skip spaces in pattern..
         while (*p == ' ')
             ++p;
@@ -63,6 +63,17 @@ private:
     Token(const Token &);
     Token operator=(const Token &);
 
+    /** Move the contents of @p from into a new token, used by TokenList::compact() */
+    Token(Token **tokensBack, Token *from);
+
+    /** @return storage for @p count tokens, release it with freeBlock() */
+    static void *allocateBlock(std::size_t count);
+    static void freeBlock(void *block);
+    /** @return the storage of the token with index @p index in the block */
+    static void *blockSlot(void *block, std::size_t index);
+
+    friend class TokenList;
+
 public:
     enum Type {
         eVariable, eType, eFunction, eKeyword, eName, // Names: Variable (varId), Type (typeId, later), Function (FuncId, later), Language keyword, Name (unknown identifier)
@@ -76,6 +87,16 @@ public:
     explicit Token(Token **tokensBack);
     ~Token();
 
+    /**
+     * Tokens are either allocated one by one or placed into a block owned by
+     * the TokenList (see TokenList::compact()). A small header in front of
+     * each token tells delete which of both it is.
+     */
+    static void *operator new(std::size_t size);
+    static void *operator new(std::size_t size, void *slot);
+    static void operator delete(void *p);
+    static void operator delete(void *p, void *slot);
+
     template<typename T>
     void str(T&& s) {
         _str = s;
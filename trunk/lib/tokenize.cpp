@@ -27,6 +27,7 @@
 #include "templatesimplifier.h"
 #include "timer.h"
 #include "utilities.h"
+#include "dumpwriter.h"
 
 #include <cstring>
 #include <sstream>
@@ -104,7 +105,8 @@ Tokenizer::Tokenizer() :
 	_varId(0),
 	_codeWithTemplates(false), //is there any templates?
 	m_timerResults(nullptr),
-	m_currentFileIndex(-1)
+	m_currentFileIndex(-1),
+	m_currentGTypedefs(nullptr)
 #ifdef MAXTIME
 	, maxtime(std::time(0) + MAXTIME)
 #endif
@@ -119,7 +121,9 @@ Tokenizer::Tokenizer(const Settings *settings, ErrorLogger *errorLogger) :
 	_symbolDatabase(0),
 	_varId(0),
 	_codeWithTemplates(false), //is there any templates?
-	m_timerResults(nullptr)
+	m_timerResults(nullptr),
+	m_currentFileIndex(-1),
+	m_currentGTypedefs(nullptr)
 #ifdef MAXTIME
 	, maxtime(std::time(0) + MAXTIME)
 #endif
@@ -2455,27 +2459,17 @@ bool Tokenizer::simplifyTypedef2_expandTypedef_global(Token*& tok)
 	}
 	if (m_currentFileIndex != (int)tok->fileIndex())
 	{
-		m_currentGTypedefBuffer.clear();
 		m_currentFileIndex = tok->fileIndex();
-		CCodeFile* pCurFile = dynamic_cast<CCodeFile*>(CGlobalMacros::GetFileTable()->FindFile(list.file(tok)));
-
-		if (!pCurFile)
+		std::unordered_map<unsigned int, const SGTypeDefView*>::iterator iterView = m_gTypedefViews.find(tok->fileIndex());
+		if (iterView == m_gTypedefViews.end())
 		{
-			return false;
-		}
-		std::list<CCodeFile*> depends = pCurFile->GetAllDepends();
-
-		for (std::list<CCodeFile*>::iterator I = depends.begin(), E = depends.end(); I != E; ++I)
-		{
-			CCodeFile* pCodeFile = *I;
-			if (CGlobalTypedefs::s_global_typedefs.count(pCodeFile))
-			{
-				m_currentGTypedefBuffer.insert(CGlobalTypedefs::s_global_typedefs[pCodeFile].begin(), CGlobalTypedefs::s_global_typedefs[pCodeFile].end());
-			}
+			CCodeFile* pCurFile = dynamic_cast<CCodeFile*>(CGlobalMacros::GetFileTable()->FindFile(list.file(tok)));
+			iterView = m_gTypedefViews.insert(std::make_pair(tok->fileIndex(), pCurFile ? CGlobalTypedefs::GetVisibleTypedefs(pCurFile) : nullptr)).first;
 		}
+		m_currentGTypedefs = iterView->second;
 	}
 
-	if (m_currentGTypedefBuffer.empty())
+	if (!m_currentGTypedefs)
 	{
 		return false;
 	}
@@ -2496,13 +2490,17 @@ bool Tokenizer::simplifyTypedef2_expandTypedef_global(Token*& tok)
 		return false;
 	}
 
-	std::map<std::string, SGTypeDef>::iterator iter =  m_currentGTypedefBuffer.find(tok->str());
-	if (iter == m_currentGTypedefBuffer.end())
+	if (!CGlobalTypedefs::IsTypedefName(tok->str()))
+	{
+		return false;
+	}
+	const SGTypeDef* pTypedef = m_currentGTypedefs->Find(tok->str());
+	if (!pTypedef)
 	{
 		return false;
 	}
 
-	const SGTypeDef& gTypedef = iter->second;
+	const SGTypeDef& gTypedef = *pTypedef;
 
 
 	//std::vector<std::string>::const_iterator I = gTypedef.TypeVec.begin();
@@ -2617,6 +2615,9 @@ bool Tokenizer::tokenize(std::istream &code,
 
 	if (simplifyTokenList1(FileName)) {
 
+		if (_settings->_compactTokens)
+			list.compact();
+
 		if (!noSymbolDB_AST) {
 			createSymbolDatabase();
 
@@ -4809,6 +4810,9 @@ bool Tokenizer::simplifyTokenList2()
 
 	Token::assignProgressValues(list.front());
 
+	if (_settings->_compactTokens)
+		list.compact();
+
 	// Create symbol database and then remove const keywords
 	createSymbolDatabase();
 	simplifyPointerConst();
@@ -4925,103 +4929,109 @@ void Tokenizer::printDebugOutputInternal(std::ostream& os) const
 		
 }
 
-static std::string toxml(const std::string &str)
+void Tokenizer::dump(std::ostream &out) const
 {
-	std::ostringstream xml;
-	const bool isstring(str[0] == '\"');
-	for (std::size_t i = 0U; i < str.length(); i++) {
-		char c = str[i];
-		switch (c) {
-		case '<':
-			xml << "&lt;";
-			break;
-		case '>':
-			xml << "&gt;";
-			break;
-		case '&':
-			xml << "&amp;";
-			break;
-		case '\"':
-			xml << "&quot;";
-			break;
-		case '\0':
-			xml << "\\0";
-			break;
-		case 0x1:
-			break;
-		default:
-			if (!isstring || (c >= ' ' && c <= 'z'))
-				xml << c;
-			else
-				xml << 'x';
-			break;
-		}
-	}
-	return xml.str();
+	DumpWriter writer(out);
+	dump(writer);
 }
 
-void Tokenizer::dump(std::ostream &out) const
+void Tokenizer::dump(DumpWriter &writer) const
 {
-	// Create a xml data dump.
+	// Create a data dump.
 	// The idea is not that this will be readable for humans. It's a
 	// data dump that 3rd party tools could load and get useful info from.
 
 	// tokens..
-	out << "  <tokenlist>" << std::endl;
-	for (const Token *tok = list.front(); tok; tok = tok->next()) {
-		out << "    <token id=\"" << tok << "\" file=\"" << toxml(list.file(tok)) << "\" linenr=\"" << tok->linenr() << '\"';
-		out << " str=\"" << toxml(tok->str()) << '\"';
-		out << " scope=\"" << tok->scope() << '\"';
-		if (tok->isName())
-			out << " type=\"name\"";
-		else if (tok->isNumber()) {
-			out << " type=\"number\"";
-			if (MathLib::isInt(tok->str()))
-				out << " isInt=\"True\"";
-			if (MathLib::isFloat(tok->str()))
-				out << " isFloat=\"True\"";
-		}
-		else if (tok->tokType() == Token::eString)
-			out << " type=\"string\" strlen=\"" << Token::getStrLength(tok) << '\"';
-		else if (tok->tokType() == Token::eChar)
-			out << " type=\"char\"";
-		else if (tok->isBoolean())
-			out << " type=\"boolean\"";
-		else if (tok->isOp()) {
-			out << " type=\"op\"";
-			if (tok->isArithmeticalOp())
-				out << " isArithmeticalOp=\"True\"";
-			else if (tok->isAssignmentOp())
-				out << " isAssignmentOp=\"True\"";
-			else if (tok->isComparisonOp())
-				out << " isComparisonOp=\"True\"";
-			else if (tok->tokType() == Token::eLogicalOp)
-				out << " isLogicalOp=\"True\"";
-		}
-		if (tok->link())
-			out << " link=\"" << tok->link() << '\"';
-		if (tok->varId() > 0U)
-			out << " varId=\"" << MathLib::toString(tok->varId()) << '\"';
-		if (tok->variable())
-			out << " variable=\"" << tok->variable() << '\"';
-		if (tok->function())
-			out << " function=\"" << tok->function() << '\"';
-		if (!tok->values.empty())
-			out << " values=\"" << &tok->values << '\"';
-		if (tok->type())
-			out << " type-scope=\"" << tok->type()->classScope << '\"';
-		if (tok->astParent())
-			out << " astParent=\"" << tok->astParent() << '\"';
-		if (tok->astOperand1())
-			out << " astOperand1=\"" << tok->astOperand1() << '\"';
-		if (tok->astOperand2())
-			out << " astOperand2=\"" << tok->astOperand2() << '\"';
-		out << "/>" << std::endl;
-	}
-	out << "  </tokenlist>" << std::endl;
-
-	_symbolDatabase->printXml(out);
-	list.front()->printValueFlow(true, out);
+	if (writer.wants(DUMP_TOKENS)) {
+		writer.openList("tokenlist");
+		for (const Token *tok = list.front(); tok; tok = tok->next()) {
+			writer.beginElement("token");
+			writer.attrPtr("id", tok);
+			writer.attrStr("file", list.file(tok));
+			writer.attrInt("linenr", tok->linenr());
+			writer.attrStr("str", tok->str());
+			writer.attrPtr("scope", tok->scope());
+			if (tok->isName())
+				writer.attrLit("type", "name");
+			else if (tok->isNumber()) {
+				writer.attrLit("type", "number");
+				if (MathLib::isInt(tok->str()))
+					writer.attrLit("isInt", "True");
+				if (MathLib::isFloat(tok->str()))
+					writer.attrLit("isFloat", "True");
+			}
+			else if (tok->tokType() == Token::eString) {
+				writer.attrLit("type", "string");
+				writer.attrInt("strlen", (long long)Token::getStrLength(tok));
+			}
+			else if (tok->tokType() == Token::eChar)
+				writer.attrLit("type", "char");
+			else if (tok->isBoolean())
+				writer.attrLit("type", "boolean");
+			else if (tok->isOp()) {
+				writer.attrLit("type", "op");
+				if (tok->isArithmeticalOp())
+					writer.attrLit("isArithmeticalOp", "True");
+				else if (tok->isAssignmentOp())
+					writer.attrLit("isAssignmentOp", "True");
+				else if (tok->isComparisonOp())
+					writer.attrLit("isComparisonOp", "True");
+				else if (tok->tokType() == Token::eLogicalOp)
+					writer.attrLit("isLogicalOp", "True");
+			}
+			if (tok->link())
+				writer.attrPtr("link", tok->link());
+			if (tok->varId() > 0U)
+				writer.attrInt("varId", tok->varId());
+			if (tok->variable())
+				writer.attrPtr("variable", tok->variable());
+			if (tok->function())
+				writer.attrPtr("function", tok->function());
+			if (!tok->values.empty())
+				writer.attrPtr("values", &tok->values);
+			if (tok->type())
+				writer.attrPtr("type-scope", tok->type()->classScope);
+			if (tok->astParent())
+				writer.attrPtr("astParent", tok->astParent());
+			if (tok->astOperand1())
+				writer.attrPtr("astOperand1", tok->astOperand1());
+			if (tok->astOperand2())
+				writer.attrPtr("astOperand2", tok->astOperand2());
+			writer.endElement();
+		}
+		writer.closeList("tokenlist");
+	}
+
+	_symbolDatabase->dump(writer);
+
+	// values..
+	if (writer.wants(DUMP_VALUES)) {
+		writer.openList("valueflow");
+		for (const Token *tok = list.front(); tok; tok = tok->next()) {
+			if (tok->values.empty())
+				continue;
+			writer.beginElement("values");
+			writer.attrPtr("id", &tok->values);
+			writer.endElement(true);
+			for (std::list<ValueFlow::Value>::const_iterator it = tok->values.begin(); it != tok->values.end(); ++it) {
+				writer.beginElement("value");
+				writer.parent("values", &tok->values);
+				if (it->tokvalue)
+					writer.attrPtr("tokvalue", it->tokvalue);
+				else
+					writer.attrInt("intvalue", it->intvalue);
+				if (it->condition)
+					writer.attrInt("condition-line", it->condition->linenr());
+				if (it->isKnown())
+					writer.attrBool("known", true);
+				else if (it->isPossible())
+					writer.attrBool("possible", true);
+				writer.endElement();
+			}
+			writer.closeElement("values");
+		}
+		writer.closeList("valueflow");
+	}
 }
 
 void Tokenizer::removeMacrosInGlobalScope()
@@ -9289,13 +9299,12 @@ void Tokenizer::dumpEnumInfo(std::list<TSCEnumerator>& enumList)
 	}
 	std::list<TSCEnumerator>::reverse_iterator I = enumList.rbegin();
 	std::list<TSCEnumerator>::reverse_iterator E = enumList.rend();
-	std::set<std::string> &luaInfo = tmp_oneData->GetLuaInfo();
 	for (; I != E; ++I)
 	{
 		for (std::map<std::string, EnumValue>::const_iterator iter = I->EnumValues.begin(), end = I->EnumValues.end();
 		iter != end; ++iter)
 		{
-			luaInfo.insert(iter->first);
+			tmp_oneData->AddLuaInfo(iter->first);
 		}
 	}
 	return;
@@ -11881,6 +11890,23 @@ void Tokenizer::deleteSymbolDatabase()
 	_symbolDatabase = nullptr;
 }
 
+void Tokenizer::skipFunction(const Scope *scope)
+{
+	_skippedFunctions.insert(std::make_pair(scope->classDef->fileIndex(), scope->classDef->linenr()));
+}
+
+bool Tokenizer::isSkippedScope(const Scope *scope) const
+{
+	if (_skippedFunctions.empty())
+		return false;
+	// nested scopes belong to the enclosing function
+	while (scope && scope->type != Scope::eFunction)
+		scope = scope->nestedIn;
+	if (!scope || !scope->classDef)
+		return false;
+	return _skippedFunctions.count(std::make_pair(scope->classDef->fileIndex(), scope->classDef->linenr())) != 0;
+}
+
 static bool operatorEnd(const Token * tok)
 {
 	if (tok && tok->str() == ")") {
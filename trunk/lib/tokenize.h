@@ -38,10 +38,12 @@
 
 class Settings;
 class SymbolDatabase;
+class Scope;
+class DumpWriter;
 class TimerResults;
 struct TSCEnumerator;
 struct STypedefEntry;
-struct SGTypeDef;
+struct SGTypeDefView;
 
 /// @addtogroup Core
 /// @{
@@ -761,6 +763,17 @@ public:
     void createSymbolDatabase();
     void deleteSymbolDatabase();
 
+    /**
+     * Function the function scoped checks skip, e.g. because its findings
+     * are replayed from the incremental store or it is outside --diff-scope.
+     * Keyed by file index and line of Scope::classDef so the keys survive
+     * the symbol database being recreated.
+     */
+    void skipFunction(const Scope *scope);
+
+    /** Is the function scope skipped by function scoped checks? */
+    bool isSkippedScope(const Scope *scope) const;
+
     /** print --debug output if debug flags match the simplification:
      * 0=unknown/both simplifications
      * 1=1st simplifications
@@ -771,6 +784,7 @@ public:
 	void printDebugOutputInternal(std::ostream& os) const;
 
     void dump(std::ostream &out) const;
+    void dump(DumpWriter &writer) const;
 
     Token *deleteInvalidTypedef(Token *typeDef);
 	Token *skipTypedef(Token *typeDef);
@@ -901,9 +915,14 @@ private:
 	mutable std::string _lastFuncName;
 
 private:
+	std::set<std::pair<unsigned int, unsigned int> > _skippedFunctions;
+
 	int m_currentFileIndex;
 
-	std::map<std::string, SGTypeDef> m_currentGTypedefBuffer;
+	const SGTypeDefView* m_currentGTypedefs;
+
+	// visible global typedefs by file index
+	std::unordered_map<unsigned int, const SGTypeDefView*> m_gTypedefViews;
 
 };
 
@@ -34,7 +34,10 @@
 
 // How many compileExpression recursions are allowed?
 // For practical code this could be endless. But in some special torture test
-// there needs to be a limit.
+// there needs to be a limit. Chains of binary operators are compiled iteratively
+// and do not count. Unary operators, brackets and the parentheses nested in them
+// still recurse: more than AST_MAX_DEPTH of them in one expression get no tree,
+// as before. bench/astdiff.sh compares the trees of two builds.
 static const unsigned int AST_MAX_DEPTH = 50U;
 
 
@@ -71,6 +74,53 @@ void TokenList::deallocateTokens()
     _front = 0;
     _back = 0;
     _files.clear();
+    for (std::size_t i = 0; i < _blocks.size(); ++i)
+        Token::freeBlock(_blocks[i]);
+    _blocks.clear();
+}
+
+void TokenList::compact()
+{
+    std::size_t count = 0;
+    for (const Token *tok = _front; tok; tok = tok->next())
+        ++count;
+    if (count == 0)
+        return;
+
+    // Copy the tokens in list order. The old token remembers its copy in
+    // _previous until all copies exist.
+    void *block = Token::allocateBlock(count);
+    Token *back = nullptr;
+    std::size_t index = 0;
+    for (Token *tok = _front; tok; tok = tok->next()) {
+        Token *copy = new (Token::blockSlot(block, index++)) Token(&_back, tok);
+        copy->_previous = back;
+        if (back)
+            back->_next = copy;
+        tok->_previous = copy;
+        back = copy;
+    }
+
+    Token *const front = _front->_previous;
+    for (Token *tok = front; tok; tok = tok->next()) {
+        if (tok->_link)
+            tok->_link = tok->_link->_previous;
+        if (tok->_astOperand1)
+            tok->_astOperand1 = tok->_astOperand1->_previous;
+        if (tok->_astOperand2)
+            tok->_astOperand2 = tok->_astOperand2->_previous;
+        if (tok->_astParent)
+            tok->_astParent = tok->_astParent->_previous;
+    }
+
+    deleteTokens(_front);
+    _front = front;
+    _back = back;
+
+    // the old blocks only held tokens of the list
+    for (std::size_t i = 0; i < _blocks.size(); ++i)
+        Token::freeBlock(_blocks[i]);
+    _blocks.assign(1U, block);
 }
 
 unsigned int TokenList::appendFileIfNew(const std::string &fileName)
@@ -420,8 +470,35 @@ unsigned long long TokenList::calculateChecksum() const
 
 //---------------------------------------------------------------------------
 
+// Precedence of a binary operator, a higher one binds tighter.
+// The operators of ASSIGN_TERNARY are right associative, all others left associative.
+enum AST_PRECEDENCE {
+    PRECEDENCE_NONE = 0,
+    PRECEDENCE_COMMA,
+    PRECEDENCE_ASSIGN_TERNARY,
+    PRECEDENCE_LOGIC_OR,
+    PRECEDENCE_LOGIC_AND,
+    PRECEDENCE_OR,
+    PRECEDENCE_XOR,
+    PRECEDENCE_AND,
+    PRECEDENCE_EQ_COMP,
+    PRECEDENCE_REL_COMP,
+    PRECEDENCE_SHIFT,
+    PRECEDENCE_ADD_SUB,
+    PRECEDENCE_MUL_DIV,
+    PRECEDENCE_POINTER_TO_ELEM
+};
+
+// A binary operator whose right operand is being compiled
+struct AST_pending {
+    Token *op;
+    AST_PRECEDENCE rhs; // lowest precedence of the operators in the right operand
+    unsigned int assign; // AST_state::assign before a '?'
+};
+
 struct AST_state {
     std::stack<Token*> op;
+    std::vector<AST_pending> pending;
     unsigned int depth;
     unsigned int inArrayAssignment;
     bool cpp;
@@ -740,143 +817,127 @@ static void compilePrecedence3(Token *&tok, AST_state& state)
     }
 }
 
-static void compilePointerToElem(Token *&tok, AST_state& state)
-{
-    compilePrecedence3(tok, state);
-    while (tok) {
-        if (Token::simpleMatch(tok, ". *")) {
-            compileBinOp(tok, state, compilePrecedence3);
-        } else break;
-    }
-}
-
-static void compileMulDiv(Token *&tok, AST_state& state)
-{
-    compilePointerToElem(tok, state);
-    while (tok) {
-        if (Token::Match(tok, "[/%]") || (tok->str() == "*" && !tok->astOperand1())) {
-            if (Token::Match(tok, "* [*,)]")) {
-                Token* tok2 = tok->next();
-                while (tok2->next() && tok2->str() == "*")
-                    tok2 = tok2->next();
-                if (Token::Match(tok2, "[>),]")) {
-                    tok = tok2;
-                    break;
-                }
-            }
-            compileBinOp(tok, state, compilePointerToElem);
-        } else break;
-    }
-}
-
-static void compileAddSub(Token *&tok, AST_state& state)
-{
-    compileMulDiv(tok, state);
-    while (tok) {
-        if (Token::Match(tok, "+|-") && !tok->astOperand1()) {
-            compileBinOp(tok, state, compileMulDiv);
-        } else break;
-    }
-}
-
-static void compileShift(Token *&tok, AST_state& state)
-{
-    compileAddSub(tok, state);
-    while (tok) {
-        if (Token::Match(tok, "<<|>>")) {
-            compileBinOp(tok, state, compileAddSub);
-        } else break;
-    }
-}
-
-static void compileRelComp(Token *&tok, AST_state& state)
-{
-    compileShift(tok, state);
-    while (tok) {
-        if (Token::Match(tok, "<|<=|>=|>") && !tok->link()) {
-            compileBinOp(tok, state, compileShift);
-        } else break;
-    }
-}
+struct AST_binaryOperator {
+    const char *str;
+    AST_PRECEDENCE precedence;
+};
 
-static void compileEqComp(Token *&tok, AST_state& state)
-{
-    compileRelComp(tok, state);
-    while (tok) {
-        if (Token::Match(tok, "==|!=")) {
-            compileBinOp(tok, state, compileRelComp);
-        } else break;
-    }
-}
+// Binary operators whose precedence does not depend on the context
+static const AST_binaryOperator AST_binaryOperators[] = {
+    { ",", PRECEDENCE_COMMA },
+    { "||", PRECEDENCE_LOGIC_OR },
+    { "&&", PRECEDENCE_LOGIC_AND },
+    { "|", PRECEDENCE_OR },
+    { "^", PRECEDENCE_XOR },
+    { "==", PRECEDENCE_EQ_COMP },
+    { "!=", PRECEDENCE_EQ_COMP },
+    { "<<", PRECEDENCE_SHIFT },
+    { ">>", PRECEDENCE_SHIFT },
+    { "/", PRECEDENCE_MUL_DIV },
+    { "%", PRECEDENCE_MUL_DIV }
+};
 
-static void compileAnd(Token *&tok, AST_state& state)
+// Precedence of tok as a binary operator, PRECEDENCE_NONE if it ends the expression.
+// tok is moved past the declarator in "T * ," and "T && )".
+static AST_PRECEDENCE binaryPrecedence(Token *&tok, const AST_state& state)
 {
-    compileEqComp(tok, state);
-    while (tok) {
-        if (tok->str() == "&" && !tok->astOperand1()) {
+    if (tok->isName())
+        return PRECEDENCE_NONE;
+    if (tok->isAssignmentOp() || tok->str() == "?" || tok->str() == ":")
+        return PRECEDENCE_ASSIGN_TERNARY;
+
+    if (tok->str() == "*") {
+        if (tok->astOperand1())
+            return PRECEDENCE_NONE;
+        if (Token::Match(tok, "* [*,)]")) {
             Token* tok2 = tok->next();
-            if (!tok2)
-                break;
-            if (tok2->str() == "&")
+            while (tok2->next() && tok2->str() == "*")
                 tok2 = tok2->next();
-            if (state.cpp && Token::Match(tok2, ",|)")) {
+            if (Token::Match(tok2, "[>),]")) {
                 tok = tok2;
-                break; // rValue reference
+                return binaryPrecedence(tok, state);
             }
-            compileBinOp(tok, state, compileEqComp);
-        } else break;
+        }
+        return PRECEDENCE_MUL_DIV;
     }
-}
-
-static void compileXor(Token *&tok, AST_state& state)
-{
-    compileAnd(tok, state);
-    while (tok) {
-        if (tok->str() == "^") {
-            compileBinOp(tok, state, compileAnd);
-        } else break;
+    if (Token::Match(tok, "+|-"))
+        return tok->astOperand1() ? PRECEDENCE_NONE : PRECEDENCE_ADD_SUB;
+    if (tok->str() == "&") {
+        Token* tok2 = tok->next();
+        if (tok->astOperand1() || !tok2)
+            return PRECEDENCE_NONE;
+        if (tok2->str() == "&")
+            tok2 = tok2->next();
+        if (state.cpp && Token::Match(tok2, ",|)")) {
+            tok = tok2;
+            return binaryPrecedence(tok, state); // rValue reference
+        }
+        return PRECEDENCE_AND;
     }
-}
-
-static void compileOr(Token *&tok, AST_state& state)
-{
-    compileXor(tok, state);
-    while (tok) {
-        if (tok->str() == "|") {
-            compileBinOp(tok, state, compileXor);
-        } else break;
+    if (Token::Match(tok, "<|<=|>=|>"))
+        return tok->link() ? PRECEDENCE_NONE : PRECEDENCE_REL_COMP;
+    if (Token::simpleMatch(tok, ". *"))
+        return PRECEDENCE_POINTER_TO_ELEM;
+
+    for (std::size_t i = 0; i < sizeof(AST_binaryOperators) / sizeof(AST_binaryOperators[0]); ++i) {
+        if (tok->str() == AST_binaryOperators[i].str)
+            return AST_binaryOperators[i].precedence;
     }
+    return PRECEDENCE_NONE;
 }
 
-static void compileLogicAnd(Token *&tok, AST_state& state)
+// The right operand of the innermost pending binary operator is complete
+static void compilePendingBinOp(AST_state& state)
 {
-    compileOr(tok, state);
-    while (tok) {
-        if (tok->str() == "&&") {
-            compileBinOp(tok, state, compileOr);
-        } else break;
-    }
+    const AST_pending pending = state.pending.back();
+    state.pending.pop_back();
+
+    Token *binop = pending.op;
+    compileBinOp(binop, state, nullptr);
+    if (binop->isAssignmentOp()) {
+        if (state.assign > 0U)
+            state.assign--;
+    } else if (binop->str() == "?")
+        state.assign = pending.assign;
 }
 
-static void compileLogicOr(Token *&tok, AST_state& state)
+// Operator precedence parsing: the operands are compiled by compilePrecedence3 and
+// every binary operator waits in state.pending until its right operand is complete.
+// Operator chains are compiled in a single loop, they do not count for AST_MAX_DEPTH.
+// Unary operators and brackets still do, see AST_MAX_DEPTH.
+static void compileExpression(Token *&tok, AST_state& state)
 {
-    compileLogicAnd(tok, state);
-    while (tok) {
-        if (tok->str() == "||") {
-            compileBinOp(tok, state, compileLogicAnd);
-        } else break;
-    }
-}
+    if (state.depth > AST_MAX_DEPTH)
+        return; // ticket #5592
+    if (!tok)
+        return;
 
-static void compileAssignTernary(Token *&tok, AST_state& state)
-{
-    compileLogicOr(tok, state);
+    const std::size_t base = state.pending.size();
+    compilePrecedence3(tok, state);
     while (tok) {
+        const AST_PRECEDENCE precedence = binaryPrecedence(tok, state);
+        if (precedence == PRECEDENCE_NONE)
+            break;
+
+        // the operators on the left binding tighter than tok get their right operand
+        while (state.pending.size() > base && state.pending.back().rhs > precedence)
+            compilePendingBinOp(state);
+
+        if (tok->str() == ":" && state.assign > 0U) {
+            // ':' ends the right operand of an assignment
+            if (state.pending.size() > base && state.pending.back().op->isAssignmentOp()) {
+                compilePendingBinOp(state);
+                continue;
+            }
+            break;
+        }
+
+        AST_pending pending;
+        pending.op = tok;
+        pending.rhs = (precedence == PRECEDENCE_ASSIGN_TERNARY) ? precedence : AST_PRECEDENCE(precedence + 1);
+        pending.assign = state.assign;
         if (tok->isAssignmentOp()) {
             state.assign++;
-            compileBinOp(tok, state, compileAssignTernary);
-            if (state.assign > 0U)
-                state.assign--;
         } else if (tok->str() == "?") {
             // http://en.cppreference.com/w/cpp/language/operator_precedence says about ternary operator:
             //       "The expression in the middle of the conditional operator (between ? and :) is parsed as if parenthesized: its precedence relative to ?: is ignored."
@@ -884,34 +945,17 @@ static void compileAssignTernary(Token *&tok, AST_state& state)
             if (tok->strAt(1) == ":") {
                 state.op.push(0);
             }
-            const unsigned int assign = state.assign;
             state.assign = 0U;
-            compileBinOp(tok, state, compileAssignTernary);
-            state.assign = assign;
-        } else if (tok->str() == ":") {
-            if (state.assign > 0U)
-                break;
-            compileBinOp(tok, state, compileAssignTernary);
-        } else break;
-    }
-}
+        }
+        state.pending.push_back(pending);
 
-static void compileComma(Token *&tok, AST_state& state)
-{
-    compileAssignTernary(tok, state);
-    while (tok) {
-        if (tok->str() == ",") {
-            compileBinOp(tok, state, compileAssignTernary);
-        } else break;
+        tok = tok->next();
+        if (tok)
+            compilePrecedence3(tok, state);
     }
-}
 
-static void compileExpression(Token *&tok, AST_state& state)
-{
-    if (state.depth > AST_MAX_DEPTH)
-        return; // ticket #5592
-    if (tok)
-        compileComma(tok, state);
+    while (state.pending.size() > base)
+        compilePendingBinOp(state);
 }
 
 static Token * createAstAtToken(Token *tok, bool cpp)
@@ -128,6 +128,14 @@ public:
 
     void createAst();
 
+    /**
+     * Move all tokens into one block in list order, so that walking the list
+     * touches consecutive memory. link() and the AST are kept. ValueFlow
+     * values are dropped, call this before ValueFlow::setValues(). Pointers
+     * to the tokens held elsewhere (symbol database) become invalid.
+     */
+    void compact();
+
 private:
     /** Disable copy constructor, no implementation */
     TokenList(const TokenList &);
@@ -138,6 +146,9 @@ private:
     /** Token list */
     Token *_front, *_back;
 
+    /** blocks holding the tokens after compact() */
+    std::vector<void *> _blocks;
+
     /** filenames for the tokenized source code (source + included) */
     std::vector<std::string> _files;
 
@@ -19,6 +19,8 @@
 
 #include "preprocessor.h" // Preprocessor
 #include "tokenize.h" // Tokenizer
+#include "symboldatabase.h"
+#include "codewindows.h"
 
 #include "check.h"
 #include "path.h"
@@ -28,6 +30,8 @@
 #include <sstream>
 #include <stdexcept>
 #include "timer.h"
+#include "workcounters.h"
+#include "dumpwriter.h"
 #include "version.h"
 
 #ifdef HAVE_RULES
@@ -37,6 +41,7 @@
 
 #include "globaltokenizer.h"
 #include "filelister.h"
+#include "sourcebundle.h"
 
 #include "tinyxml2.h"
 using namespace tinyxml2;
@@ -46,9 +51,26 @@ static const char ExtraVersion[] = "";
 
 static TimerResults S_timerResults;
 
+// --diff-scope: function scoped checks skip functions without changed lines
+static void skipUnchangedFunctions(Tokenizer &tokenizer, const ChangedLines &changedLines)
+{
+    const SymbolDatabase *symbolDatabase = tokenizer.getSymbolDatabase();
+    for (std::size_t i = 0; i < symbolDatabase->functionScopes.size(); ++i) {
+        const Scope *scope = symbolDatabase->functionScopes[i];
+        if (!scope->classDef || !scope->classEnd)
+            continue;
+        const Token *start = scope->classDef;
+        if (scope->function && scope->function->retDef && scope->function->retDef->fileIndex() == start->fileIndex())
+            start = scope->function->retDef;
+        if (start->fileIndex() == scope->classEnd->fileIndex() &&
+            !changedLines.overlaps(tokenizer.list.file(start), start->linenr(), scope->classEnd->linenr()))
+            tokenizer.skipFunction(scope);
+    }
+}
+
 TscanCode::TscanCode(ErrorLogger &errorLogger, bool useGlobalSuppressions)
     : _errorLogger(errorLogger), exitcode(0), _useGlobalSuppressions(useGlobalSuppressions), tooManyConfigs(false)
-	, _settings(*Settings::Instance()), _simplify(true)
+	, _settings(*Settings::Instance()), _incremental(*Settings::Instance()), _simplify(true)
 {
 	
 }
@@ -74,8 +96,9 @@ const char * TscanCode::extraVersion()
 
 unsigned int TscanCode::check(const std::string &path)
 {
-    std::ifstream fin(path.c_str());
-    return processFile(path, fin);
+    CSourceFile fin;
+    fin.Open(path);
+    return processFile(path, fin.Stream());
 }
 
 unsigned int TscanCode::check(const std::string &path, const std::string &content)
@@ -86,8 +109,9 @@ unsigned int TscanCode::check(const std::string &path, const std::string &conten
 
 unsigned int TscanCode::analyze(const std::string &path)
 {
-    std::ifstream fin(path.c_str());
-    return analyzeFile(fin, path);
+    CSourceFile fin;
+    fin.Open(path);
+    return analyzeFile(fin.Stream(), path);
 }
 
 unsigned int TscanCode::analyze(const std::string &path, const std::string &content)
@@ -110,6 +134,11 @@ void TscanCode::SyncErrorList(std::list<std::string>& errorList)
 	errorList.insert(errorList.end(), _errorList.begin(), _errorList.end());
 }
 
+void TscanCode::SyncBaseline(Baseline& baseline)
+{
+	baseline.addFindings(_baselineFindings);
+}
+
 std::set<CCodeFile*>& TscanCode::GetLargeHeaderSet()
 {
 	return _largeHeaderSet;
@@ -425,6 +454,7 @@ unsigned int TscanCode::processFile(const std::string& filename, std::istream& f
         return exitcode;
 
     bool internalErrorFound(false);
+    _incremental.Load(filename);
     try {
         Preprocessor preprocessor(_settings, this);
         std::list<std::string> configurations;
@@ -432,6 +462,7 @@ unsigned int TscanCode::processFile(const std::string& filename, std::istream& f
 
         {
             Timer t("Preprocessor::preprocess", _settings._showtime, &S_timerResults);
+            WorkPhase phase("Preprocessor::preprocess");
             preprocessor.preprocess(fileStream, filedata, configurations, filename, _settings._includePaths);
         }
 
@@ -474,6 +505,15 @@ unsigned int TscanCode::processFile(const std::string& filename, std::istream& f
             }
         }
 
+        // the code and directives shared by all configurations
+        CfgLineStream stream;
+        if (_settings._variabilityAware) {
+            Timer t("Preprocessor::splitLines", _settings._showtime, &S_timerResults);
+            WorkPhase phase("Preprocessor::splitLines");
+            Preprocessor::splitLines(filedata, stream);
+        }
+        std::set<std::string> codes;
+
         std::set<unsigned long long> checksums;
         unsigned int checkCount = 0;
         for (std::list<std::string>::const_iterator it = configurations.begin(); it != configurations.end(); ++it) {
@@ -491,11 +531,28 @@ unsigned int TscanCode::processFile(const std::string& filename, std::istream& f
             }
 
             Timer t("Preprocessor::getcode", _settings._showtime, &S_timerResults);
-            std::string codeWithoutCfg = preprocessor.getcode(filedata, cfg, filename);
+            WorkPhase phase("Preprocessor::getcode");
+            std::string codeWithoutCfg = _settings._variabilityAware ?
+                                         preprocessor.getcode(stream, cfg, filename, true) :
+                                         preprocessor.getcode(filedata, cfg, filename);
+            phase.Stop();
             t.Stop();
 
             codeWithoutCfg += _settings.append();
 
+            // a configuration with the same code as an earlier one has the same findings
+            if (_settings._variabilityAware && (_settings._force || _settings._maxConfigs > 1) && !codes.insert(codeWithoutCfg).second) {
+                if (_settings.isEnabled("information") && _settings._verbose)
+                    purgedConfigurationMessage(filename, cfg);
+                continue;
+            }
+
+			if (_settings._skipThinFiles && isThinConfiguration(codeWithoutCfg, filename))
+				continue;
+
+			if (checkWindows(codeWithoutCfg, filename.c_str(), checksums, internalErrorFound, false))
+				continue;
+
 			if (!checkFile(codeWithoutCfg, filename.c_str(), checksums, internalErrorFound)) {
 				if (_settings.isEnabled("information") && _settings._verbose)
 					purgedConfigurationMessage(filename, cfg);
@@ -508,6 +565,8 @@ unsigned int TscanCode::processFile(const std::string& filename, std::istream& f
         internalError(filename, e.errorMessage);
         exitcode=1; // e.g. reflect a syntax error
     }
+    _incremental.Save();
+    _lineHashes.clear();
 
     // In jointSuppressionReport mode, unmatched suppressions are
     // collected after all files are processed
@@ -566,6 +625,7 @@ unsigned int TscanCode::analyzeFile(std::istream &fileStream, const std::string
         
         {
             Timer t("Preprocessor::preprocess", _settings._showtime, &S_timerResults);
+            WorkPhase phase("Preprocessor::preprocess");
             preprocessor.preprocess(fileStream, filedata, configurations, filename, _settings._includePaths);
         }
         
@@ -586,6 +646,15 @@ unsigned int TscanCode::analyzeFile(std::istream &fileStream, const std::string
             }
         }
         
+        // the code and directives shared by all configurations
+        CfgLineStream stream;
+        if (_settings._variabilityAware) {
+            Timer t("Preprocessor::splitLines", _settings._showtime, &S_timerResults);
+            WorkPhase phase("Preprocessor::splitLines");
+            Preprocessor::splitLines(filedata, stream);
+        }
+        std::set<std::string> codes;
+
         std::set<unsigned long long> checksums;
         unsigned int checkCount = 0;
         for (std::list<std::string>::const_iterator it = configurations.begin(); it != configurations.end(); ++it) {
@@ -601,11 +670,25 @@ unsigned int TscanCode::analyzeFile(std::istream &fileStream, const std::string
             }
             
             Timer t("Preprocessor::getcode", _settings._showtime, &S_timerResults);
-            std::string codeWithoutCfg = preprocessor.getcode(filedata, cfg, filename);
+            WorkPhase phase("Preprocessor::getcode");
+            std::string codeWithoutCfg = _settings._variabilityAware ?
+                                         preprocessor.getcode(stream, cfg, filename, true) :
+                                         preprocessor.getcode(filedata, cfg, filename);
+            phase.Stop();
             t.Stop();
 
             codeWithoutCfg += _settings.append();
 
+            // a configuration with the same code as an earlier one has the same findings
+            if (_settings._variabilityAware && (_settings._force || _settings._maxConfigs > 1) && !codes.insert(codeWithoutCfg).second) {
+                if (_settings.isEnabled("information") && _settings._verbose)
+                    purgedConfigurationMessage(filename, cfg);
+                continue;
+            }
+
+            if (checkWindows(codeWithoutCfg, filename.c_str(), checksums, internalErrorFound, true))
+                continue;
+
             if (!analyzeFile_internal(codeWithoutCfg, filename.c_str(), checksums, internalErrorFound)) {
                 if (_settings.isEnabled("information") && _settings._verbose)
                     purgedConfigurationMessage(filename, cfg);
@@ -638,7 +721,9 @@ bool TscanCode::analyzeFile_internal(const std::string &code, const char FileNam
         std::istringstream istr(code);
         
         Timer timer("Tokenizer::tokenize", _settings._showtime, &S_timerResults);
+        WorkPhase phase("Tokenizer::tokenize");
         bool result = _tokenizer.tokenize(istr, FileName, cfg, false, true);
+        phase.Stop();
         timer.Stop();
         
         if (_settings._force || _settings._maxConfigs > 1) {
@@ -692,6 +777,71 @@ bool TscanCode::analyzeFile_internal(const std::string &code, const char FileNam
     return true;
 }
 
+bool TscanCode::checkWindows(const std::string &code, const char FileName[], std::set<unsigned long long>& checksums, bool& internalErrorFound, bool analyze)
+{
+    // the windows of one configuration would overwrite each other's dump and incremental records
+    const std::size_t windowSize = std::size_t(_settings._windowSize) * 1024U * 1024U;
+    if (windowSize == 0 || code.size() <= windowSize || _settings.dump || !_settings._incrementalDir.empty())
+        return false;
+
+    const CodeWindows windows(code, windowSize);
+    if (windows.size() <= 1)
+        return false;
+
+    internalErrorFound = false;
+    if (!analyze)
+        CGlobalStatisticData::Instance()->BeginWindows(static_cast<ErrorLogger *>(this));
+    std::string window;
+    for (std::size_t i = 0; i < windows.size(); ++i) {
+        if (_settings.terminated())
+            break;
+        windows.getWindow(i, window);
+        bool windowError = false;
+        if (analyze)
+            analyzeFile_internal(window, FileName, checksums, windowError);
+        else
+            checkFile(window, FileName, checksums, windowError);
+        if (windowError)
+            internalErrorFound = true;
+    }
+    if (!analyze)
+        CGlobalStatisticData::Instance()->EndWindows(static_cast<ErrorLogger *>(this));
+    return true;
+}
+
+bool TscanCode::isThinConfiguration(const std::string &code, const std::string &filename)
+{
+    // the dump, the rules and the unused functions need every configuration
+    if (_settings.dump || !_settings.rules.empty() || unusedFunctionCheckIsEnabled())
+        return false;
+
+    std::map<std::string, unsigned long long> files;
+    Preprocessor::getCheckableFiles(code, filename, files);
+
+    // a header counts as checked only with the same code, the macros of a configuration can change it
+    std::string reason;
+    if (files.erase(filename))
+        reason = "code to check";
+    for (std::map<std::string, unsigned long long>::const_iterator it = files.begin(); reason.empty() && it != files.end(); ++it) {
+        if (_checkedHeaders.find(*it) == _checkedHeaders.end())
+            reason = "code to check in " + Path::toNativeSeparators(it->first);
+    }
+    const bool thin = reason.empty();
+    if (!thin)
+        _checkedHeaders.insert(files.begin(), files.end());
+
+    // a skipped configuration is never checked, so the decision is printed even with -q
+    if (thin || !_settings.quiet) {
+        std::ostringstream oss;
+        oss << "[Classify] " << (thin ? "[Skip] " : "[Check] ") << Path::toNativeSeparators(filename);
+        if (!cfg.empty())
+            oss << " (" << cfg << ")";
+        oss << ": " << (thin ? "only declarations outside of checked headers" : reason);
+        reportOut(oss.str());
+    }
+    return thin;
+}
+
 bool TscanCode::checkFile(const std::string &code, const char FileName[], std::set<unsigned long long>& checksums, bool& internalErrorFound)
 {
     internalErrorFound=false;
@@ -717,7 +867,9 @@ bool TscanCode::checkFile(const std::string &code, const char FileName[], std::s
         std::istringstream istr(code);
 
         Timer timer("Tokenizer::tokenize", _settings._showtime, &S_timerResults);
+        WorkPhase phase("Tokenizer::tokenize");
         bool result = _tokenizer.tokenize(istr, FileName, cfg);
+        phase.Stop();
         timer.Stop();
 
         if (_settings._force || _settings._maxConfigs > 1) {
@@ -734,25 +886,32 @@ bool TscanCode::checkFile(const std::string &code, const char FileName[], std::s
 
         // dump
         if (_settings.dump) {
-            std::string dumpfile = std::string(FileName) + ".dump";
+            std::string dumpfile = std::string(FileName) + (_settings._dumpFormat == DUMP_JSONL ? ".dump.jsonl" : ".dump");
             std::ofstream fdump(dumpfile.c_str());
             if (fdump.is_open()) {
-                fdump << "<?xml version=\"1.0\"?>" << std::endl;
-                fdump << "<dump cfg=\"" << cfg << "\">" << std::endl;
-                _tokenizer.dump(fdump);
-                fdump << "</dump>" << std::endl;
+                DumpWriter writer(fdump, _settings._dumpFormat, _settings._dumpSections);
+                writer.beginDocument(cfg);
+                _tokenizer.dump(writer);
+                writer.endDocument();
             }
             return true;
         }
 
+        if (!_settings._changedLines.empty())
+            skipUnchangedFunctions(_tokenizer, _settings._changedLines);
+        _incremental.BeginConfiguration(_tokenizer, cfg);
+
         // call all "runChecks" in all registered Check classes
         for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
             if (_settings.terminated())
                 return true;
 
             Timer timerRunChecks((*it)->name() + "::runChecks", _settings._showtime, &S_timerResults);
+            WorkPhase phaseRunChecks((*it)->name() + "::runChecks");
+            _incremental.SetRecording((*it)->isFunctionScoped());
             (*it)->runChecks(&_tokenizer, &_settings, this);
         }
+        _incremental.SetRecording(false);
 
         // Analyse the tokens..
         for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
@@ -763,14 +922,20 @@ bool TscanCode::checkFile(const std::string &code, const char FileName[], std::s
 
         executeRules("normal", _tokenizer);
 
-        if (!_simplify)
+        if (!_simplify) {
+            _incremental.EndConfiguration(*this, false);
             return true;
+        }
 
         Timer timer3("Tokenizer::simplifyTokenList2", _settings._showtime, &S_timerResults);
+        WorkPhase phase3("Tokenizer::simplifyTokenList2");
         result = _tokenizer.simplifyTokenList2();
+        phase3.Stop();
         timer3.Stop();
-        if (!result)
+        if (!result) {
+            _incremental.EndConfiguration(*this, false);
             return true;
+        }
 
         // call all "runSimplifiedChecks" in all registered Check classes
         for (std::list<Check *>::const_iterator it = Check::instances().begin(); it != Check::instances().end(); ++it) {
@@ -778,17 +943,22 @@ bool TscanCode::checkFile(const std::string &code, const char FileName[], std::s
                 return true;
 
             Timer timerSimpleChecks((*it)->name() + "::runSimplifiedChecks", _settings._showtime, &S_timerResults);
+            WorkPhase phaseSimpleChecks((*it)->name() + "::runSimplifiedChecks");
+            _incremental.SetRecording((*it)->isFunctionScoped());
             (*it)->runSimplifiedChecks(&_tokenizer, &_settings, this);
         }
+        _incremental.SetRecording(false);
 
         if (_settings.terminated())
             return true;
 
         executeRules("simple", _tokenizer);
+        _incremental.EndConfiguration(*this, true);
 
         if (_settings.terminated())
             return true;
     } catch (const InternalError &e) {
+        _incremental.EndConfiguration(*this, false);
         internalErrorFound=true;
         std::list<ErrorLogger::ErrorMessage::FileLocation> locationList;
         ErrorLogger::ErrorMessage::FileLocation loc;
@@ -981,6 +1151,12 @@ void TscanCode::reportErr(const ErrorLogger::ErrorMessage &msg)
 	{
 		return;//not report debug error
 	}
+	if (!_incremental.OnFinding(msg))
+		return;
+	// --diff-scope: only findings in changed lines are reported
+	if (!_settings._changedLines.empty() && !msg._callStack.empty() &&
+		!_settings._changedLines.overlaps(msg._callStack.back().getfile(false), msg._callStack.back().line, msg._callStack.back().line))
+		return;
 	if (!_settings.IsCheckIdOpened(ErrorType::ToString(msg._type).c_str(), msg._id.c_str()))
 		return;
 
@@ -1016,6 +1192,10 @@ void TscanCode::reportErr(const ErrorLogger::ErrorMessage &msg)
     if (!_settings.library.reportErrors(msg.file0))
         return;
 
+	// --baseline: known findings are dropped before they are formatted
+	if ((!_settings._baseline.empty() || !_settings._baselineOut.empty()) && isKnownFinding(msg))
+		return;
+
 	std::string errmsg;
 	
 
@@ -1058,6 +1238,14 @@ void TscanCode::reportErr(const ErrorLogger::ErrorMessage &msg)
     _errorList.push_back(errmsg);
 }
 
+bool TscanCode::isKnownFinding(const ErrorLogger::ErrorMessage &msg)
+{
+    const Baseline::Fingerprint fingerprint = Baseline::fingerprint(msg, _lineHashes);
+    if (!_settings._baselineOut.empty())
+        _baselineFindings.insert(fingerprint);
+    return _settings._baseline.isKnown(fingerprint);
+}
+
 void TscanCode::reportOut(const std::string &outmsg)
 {
     _errorLogger.reportOut(outmsg);
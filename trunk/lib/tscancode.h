@@ -25,6 +25,7 @@
 #include "settings.h"
 #include "errorlogger.h"
 #include "check.h"
+#include "incremental.h"
 
 #include <string>
 #include <list>
@@ -155,11 +156,17 @@ public:
 
 	void SyncErrorList(std::list<std::string>& errorList);
 
+	/** @brief add the fingerprints of the findings to @baseline (--baseline-out=), not thread safe */
+	void SyncBaseline(Baseline& baseline);
+
 	std::set<CCodeFile*>& GetLargeHeaderSet();
 
 	bool mergeCfgXml(const std::string& cfgNew, const std::string& cfgOld);
 private:
 
+    /** @brief Is the finding in the --baseline= file? Records its fingerprint for --baseline-out= */
+    bool isKnownFinding(const ErrorLogger::ErrorMessage &msg);
+
     /** @brief There has been an internal error => Report information message */
     void internalError(const std::string &filename, const std::string &msg);
 
@@ -200,6 +207,22 @@ private:
      * @return false if file has been checked before, true else !?
      */
     bool analyzeFile_internal(const std::string &code, const char FileName[], std::set<unsigned long long>& checksums, bool& internalErrorFound);
+
+    /**
+     * @brief Check or analyze a large configuration one window of function
+     * bodies at a time (--window-size=)
+     * @param[out] internalErrorFound will be set to true if an internal has been caught in a window
+     * @return false if the configuration is not checked in windows
+     */
+    bool checkWindows(const std::string &code, const char FileName[], std::set<unsigned long long>& checksums, bool& internalErrorFound, bool analyze);
+
+    /**
+     * @brief Has the configuration nothing to check but code of headers this
+     * instance checked before with the same code? (--skip-thin-files) The
+     * decision is printed unless quiet.
+     * @return true if the configuration is not checked
+     */
+    bool isThinConfiguration(const std::string &code, const std::string &filename);
     
     /**
      * @brief Execute rules, if any
@@ -253,6 +276,15 @@ private:
     /** @brief Current preprocessor configuration */
     std::string cfg;
 
+    /** @brief findings of unchanged functions (--incremental-dir) */
+    CIncrementalStore _incremental;
+
+    /** @brief fingerprints of the findings for --baseline-out= */
+    std::set<Baseline::Fingerprint> _baselineFindings;
+
+    /** @brief line hashes of the files with findings, cleared after each file */
+    Baseline::LineHashes _lineHashes;
+
     unsigned int exitcode;
 
     bool _useGlobalSuppressions;
@@ -267,6 +299,10 @@ private:
     std::list<Check::FileInfo*> fileInfo;
 
 	std::set<CCodeFile*> _largeHeaderSet;
+
+	/** headers with something to check in a checked configuration, with the
+	    fingerprint of their code there (--skip-thin-files) */
+	std::set<std::pair<std::string, unsigned long long> > _checkedHeaders;
 };
 
 #endif 
\ No newline at end of file
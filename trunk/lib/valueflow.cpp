@@ -24,7 +24,9 @@
 #include "symboldatabase.h"
 #include "token.h"
 #include "tokenlist.h"
+#include "workcounters.h"
 #include <stack>
+#include <vector>
 
 namespace {
     struct ProgramMemory {
@@ -338,6 +340,124 @@ static bool isReturn(const Token *tok)
     return false;
 }
 
+/** Number of values that a (range) value stands for */
+static std::size_t rangeSize(const ValueFlow::Value &value)
+{
+    return value.isRange() ? (std::size_t)((value.intmax - value.intvalue) / value.step) + 1U : 1U;
+}
+
+/** Number of values in a value list, ranges are counted value by value */
+static std::size_t valueCount(const std::list<ValueFlow::Value> &values)
+{
+    std::size_t count = 0;
+    for (std::list<ValueFlow::Value>::const_iterator it = values.begin(); it != values.end(); ++it)
+        count += rangeSize(*it);
+    return count;
+}
+
+static bool containsValue(const ValueFlow::Value &value, MathLib::bigint intvalue)
+{
+    if (!value.isRange())
+        return value.intvalue == intvalue;
+    return intvalue >= value.intvalue && intvalue <= value.intmax && (intvalue - value.intvalue) % value.step == 0;
+}
+
+/** Case label that follows a fall-through case label */
+static const Token *nextCaseLabel(const Token *caseToken)
+{
+    const Token *tok = caseToken->tokAt(3);
+    return (tok && !tok->isName()) ? tok->next() : tok;
+}
+
+/**
+ * Get 'count' consecutive values of a range, starting with value number 'first'.
+ * The values of a range come from consecutive case labels, so the condition of
+ * each value is the case label that follows the condition of the previous value.
+ */
+static ValueFlow::Value rangeSlice(const ValueFlow::Value &range, std::size_t first, std::size_t count)
+{
+    ValueFlow::Value value(range);
+    value.intvalue += (MathLib::bigint)first * range.step;
+    value.varvalue += (MathLib::bigint)first * range.varstep;
+    for (std::size_t i = 0; i < first && value.condition; ++i)
+        value.condition = nextCaseLabel(value.condition);
+    if (count > 1U) {
+        value.intmax = value.intvalue + (MathLib::bigint)(count - 1U) * range.step;
+    } else {
+        value.intmax = value.intvalue;
+        value.step = 0;
+        value.varstep = 0;
+    }
+    return value;
+}
+
+/** Get value number 'index' of a (range) value */
+static ValueFlow::Value rangeValue(const ValueFlow::Value &value, std::size_t index)
+{
+    return value.isRange() ? rangeSlice(value, index, 1U) : value;
+}
+
+/** Values with ranges replaced by their values. 'buffer' is only used if there are ranges. */
+static const std::list<ValueFlow::Value> &expandRanges(const std::list<ValueFlow::Value> &values, std::list<ValueFlow::Value> &buffer)
+{
+    if (valueCount(values) == values.size())
+        return values;
+    buffer.clear();
+    for (std::list<ValueFlow::Value>::const_iterator it = values.begin(); it != values.end(); ++it) {
+        const std::size_t size = rangeSize(*it);
+        for (std::size_t i = 0; i < size; ++i)
+            buffer.push_back(rangeValue(*it, i));
+    }
+    return buffer;
+}
+
+/** Append the selected values of a (range) value. Consecutive selected values are kept as a range. */
+static void appendSelected(const ValueFlow::Value &value, const std::vector<bool> &selected, std::list<ValueFlow::Value> *values)
+{
+    if (!value.isRange()) {
+        if (selected[0])
+            values->push_back(value);
+        return;
+    }
+    for (std::size_t first = 0; first < selected.size(); ++first) {
+        if (!selected[first])
+            continue;
+        std::size_t last = first;
+        while (last + 1U < selected.size() && selected[last + 1U])
+            ++last;
+        values->push_back(rangeSlice(value, first, last - first + 1U));
+        first = last;
+    }
+}
+
+/**
+ * Merge runs of values that come from consecutive case labels and have a
+ * constant distance into ranges, so they are propagated as one value.
+ */
+static std::list<ValueFlow::Value> mergeRanges(const std::list<ValueFlow::Value> &values)
+{
+    std::list<ValueFlow::Value> result;
+    for (std::list<ValueFlow::Value>::const_iterator it = values.begin(); it != values.end(); ++it) {
+        if (!result.empty()) {
+            ValueFlow::Value &range = result.back();
+            const ValueFlow::Value last = rangeValue(range, rangeSize(range) - 1U);
+            const MathLib::bigint step = it->intvalue - last.intvalue;
+            const MathLib::bigint varstep = it->varvalue - last.varvalue;
+            if (step > 0 && (!range.isRange() || (step == range.step && varstep == range.varstep)) &&
+                last.condition && Token::simpleMatch(last.condition, "case") && nextCaseLabel(last.condition) == it->condition &&
+                !range.tokvalue && !it->tokvalue && range.varId == it->varId && range.conditional == it->conditional &&
+                range.inconclusive == it->inconclusive && range.defaultArg == it->defaultArg && range.valueKind == it->valueKind) {
+                range.intmax = it->intvalue;
+                range.step = step;
+                range.varstep = varstep;
+                continue;
+            }
+        }
+        result.push_back(*it);
+    }
+    return result;
+}
+
 /** Add token value. Return true if value is added. */
 static bool addValue(Token *tok, const ValueFlow::Value &value)
 {
@@ -348,12 +468,33 @@ static bool addValue(Token *tok, const ValueFlow::Value &value)
 
     // Don't handle more than 10 values for performance reasons
     // TODO: add setting?
-    if (tok->values.size() >= 10U)
+    if (valueCount(tok->values) >= 10U)
         return false;
 
     // if value already exists, don't add it again
     std::list<ValueFlow::Value>::iterator it;
     for (it = tok->values.begin(); it != tok->values.end(); ++it) {
+        if (it->isRange()) {
+            if (value.tokvalue || !containsValue(*it, value.intvalue))
+                continue;
+            if (!it->inconclusive || value.inconclusive)
+                return false;
+
+            // same value, but the range is inconclusive so replace that value of the range
+            const std::size_t index = (std::size_t)((value.intvalue - it->intvalue) / it->step);
+            const std::size_t size = rangeSize(*it);
+            if (index > 0U)
+                tok->values.insert(it, rangeSlice(*it, 0U, index));
+            if (index + 1U < size) {
+                std::list<ValueFlow::Value>::iterator next = it;
+                tok->values.insert(++next, rangeSlice(*it, index + 1U, size - index - 1U));
+            }
+            *it = value;
+            if (it->varId == 0)
+                it->varId = tok->varId();
+            break;
+        }
+
         // different intvalue => continue
         if (it->intvalue != value.intvalue)
             continue;
@@ -387,11 +528,103 @@ static bool addValue(Token *tok, const ValueFlow::Value &value)
     return true;
 }
 
+/**
+ * Can a range be added to the token as one value? This is only done when the
+ * result is the same as when the values of the range are added one by one.
+ */
+static bool keepRange(const Token *tok, const ValueFlow::Value &range)
+{
+    if (range.isKnown() || valueCount(tok->values) + rangeSize(range) > 10U)
+        return false;
+
+    for (std::list<ValueFlow::Value>::const_iterator it = tok->values.begin(); it != tok->values.end(); ++it) {
+        if (it->tokvalue)
+            continue;
+        const std::size_t size = rangeSize(*it);
+        for (std::size_t i = 0; i < size; ++i) {
+            if (containsValue(range, it->intvalue + (MathLib::bigint)i * it->step))
+                return false;
+        }
+    }
+
+    // the calculated values of the parent depend on the order the values are added
+    const Token *parent = tok->astParent();
+    if (parent && parent->astOperand1() && parent->astOperand2() &&
+        (parent->isArithmeticalOp() || parent->isComparisonOp() || parent->tokType() == Token::eBitOp || parent->str() == "[")) {
+        const Token *other = (parent->astOperand1() == tok) ? parent->astOperand2() : parent->astOperand1();
+        if (valueCount(other->values) > 1U)
+            return false;
+    }
+    return true;
+}
+
+/** Calculate 'range op value' or 'value op range' without splitting the range */
+static bool calculateRange(const Token *parent, ValueFlow::Value *result)
+{
+    const std::list<ValueFlow::Value> &values1 = parent->astOperand1()->values;
+    const std::list<ValueFlow::Value> &values2 = parent->astOperand2()->values;
+    if (values1.size() != 1U || values2.size() != 1U || parent->str().size() != 1U)
+        return false;
+    const ValueFlow::Value &value1 = values1.front();
+    const ValueFlow::Value &value2 = values2.front();
+    if (value1.isRange() == value2.isRange() || value1.tokvalue || value2.tokvalue)
+        return false;
+    const ValueFlow::Value &range = value1.isRange() ? value1 : value2;
+    const ValueFlow::Value &other = value1.isRange() ? value2 : value1;
+
+    // the values of the result must be in the same order as the values of the range
+    const char op = parent->str()[0];
+    if (!(op == '+' || (op == '-' && value1.isRange()) || (op == '*' && other.intvalue > 0)))
+        return false;
+
+    // all values of the result must be calculated and depend on the case labels of the range
+    if (!value1.isKnown() && !value2.isKnown() && value1.varId != 0U && value2.varId != 0U)
+        return false;
+    if (other.condition && !value1.isRange())
+        return false;
+
+    *result = ValueFlow::Value(0);
+    result->condition = range.condition;
+    result->inconclusive = value1.inconclusive | value2.inconclusive;
+    result->varId = (value1.varId != 0U) ? value1.varId : value2.varId;
+    const ValueFlow::Value &varsource = (result->varId == value1.varId) ? value1 : value2;
+    result->varvalue = varsource.intvalue;
+    result->varstep = varsource.isRange() ? varsource.step : 0;
+    if (value1.valueKind == value2.valueKind)
+        result->valueKind = value1.valueKind;
+    switch (op) {
+    case '+':
+        result->intvalue = range.intvalue + other.intvalue;
+        result->intmax = range.intmax + other.intvalue;
+        result->step = range.step;
+        break;
+    case '-':
+        result->intvalue = range.intvalue - other.intvalue;
+        result->intmax = range.intmax - other.intvalue;
+        result->step = range.step;
+        break;
+    default:
+        result->intvalue = range.intvalue * other.intvalue;
+        result->intmax = range.intmax * other.intvalue;
+        result->step = range.step * other.intvalue;
+        break;
+    }
+    return true;
+}
+
 /** set ValueFlow value and perform calculations if possible */
 static void setTokenValue(Token* tok, const ValueFlow::Value &value)
 {
+    if (value.isRange() && !keepRange(tok, value)) {
+        const std::size_t size = rangeSize(value);
+        for (std::size_t i = 0; i < size; ++i)
+            setTokenValue(tok, rangeValue(value, i));
+        return;
+    }
+
     if (!addValue(tok,value))
         return;
+    WorkCounters::add(WORK_VALUES_CREATED);
 
     Token *parent = const_cast<Token*>(tok->astParent());
     if (!parent)
@@ -440,15 +673,23 @@ static void setTokenValue(Token* tok, const ValueFlow::Value &value)
     else if ((parent->isArithmeticalOp() || parent->isComparisonOp() || (parent->tokType() == Token::eBitOp)) &&
              parent->astOperand1() &&
              parent->astOperand2()) {
+        ValueFlow::Value range;
+        if (calculateRange(parent, &range)) {
+            setTokenValue(parent, range);
+            return;
+        }
+        std::list<ValueFlow::Value> buffer1, buffer2;
+        const std::list<ValueFlow::Value> &values1 = expandRanges(parent->astOperand1()->values, buffer1);
+        const std::list<ValueFlow::Value> &values2 = expandRanges(parent->astOperand2()->values, buffer2);
         const bool known = ((parent->astOperand1()->values.size() == 1U &&
                              parent->astOperand1()->values.front().isKnown()) ||
                             (parent->astOperand2()->values.size() == 1U &&
                              parent->astOperand2()->values.front().isKnown()));
         std::list<ValueFlow::Value>::const_iterator value1, value2;
-        for (value1 = parent->astOperand1()->values.begin(); value1 != parent->astOperand1()->values.end(); ++value1) {
+        for (value1 = values1.begin(); value1 != values1.end(); ++value1) {
             if (value1->tokvalue && (!parent->isComparisonOp() || value1->tokvalue->tokType() != Token::eString))
                 continue;
-            for (value2 = parent->astOperand2()->values.begin(); value2 != parent->astOperand2()->values.end(); ++value2) {
+            for (value2 = values2.begin(); value2 != values2.end(); ++value2) {
                 if (value2->tokvalue && (!parent->isComparisonOp() || value2->tokvalue->tokType() != Token::eString || value1->tokvalue))
                     continue;
                 if (known || value1->varId == 0U || value2->varId == 0U ||
@@ -548,8 +789,10 @@ static void setTokenValue(Token* tok, const ValueFlow::Value &value)
 
     // !
     else if (parent->str() == "!") {
+        std::list<ValueFlow::Value> buffer;
+        const std::list<ValueFlow::Value> &values = expandRanges(tok->values, buffer);
         std::list<ValueFlow::Value>::const_iterator it;
-        for (it = tok->values.begin(); it != tok->values.end(); ++it) {
+        for (it = values.begin(); it != values.end(); ++it) {
             if (it->tokvalue)
                 continue;
             ValueFlow::Value v(*it);
@@ -560,11 +803,13 @@ static void setTokenValue(Token* tok, const ValueFlow::Value &value)
 
     // Array element
     else if (parent->str() == "[" && parent->astOperand1() && parent->astOperand2()) {
+        std::list<ValueFlow::Value> buffer;
+        const std::list<ValueFlow::Value> &values2 = expandRanges(parent->astOperand2()->values, buffer);
         std::list<ValueFlow::Value>::const_iterator value1, value2;
         for (value1 = parent->astOperand1()->values.begin(); value1 != parent->astOperand1()->values.end(); ++value1) {
             if (!value1->tokvalue)
                 continue;
-            for (value2 = parent->astOperand2()->values.begin(); value2 != parent->astOperand2()->values.end(); ++value2) {
+            for (value2 = values2.begin(); value2 != values2.end(); ++value2) {
                 if (value2->tokvalue)
                     continue;
                 if (value1->varId == 0U || value2->varId == 0U ||
@@ -772,7 +1017,9 @@ static void valueFlowReverse(TokenList *tokenlist,
     const unsigned int       varid      = varToken->varId();
     const Token * const      startToken = var->nameToken();
 
+    WorkCount steps(WORK_VALUEFLOW_REVERSE_STEPS);
     for (Token *tok2 = tok->previous(); ; tok2 = tok2->previous()) {
+        ++steps;
         if (!tok2 ||
             tok2 == startToken ||
             (tok2->str() == "{" && tok2->scope()->type == Scope::ScopeType::eFunction)) {
@@ -1012,19 +1259,21 @@ static void valueFlowBeforeCondition(TokenList *tokenlist, SymbolDatabase *symbo
 
 static void removeValues(std::list<ValueFlow::Value> &values, const std::list<ValueFlow::Value> &valuesToRemove)
 {
-    for (std::list<ValueFlow::Value>::iterator it = values.begin(); it != values.end();) {
-        bool found = false;
-        for (std::list<ValueFlow::Value>::const_iterator it2 = valuesToRemove.begin(); it2 != valuesToRemove.end(); ++it2) {
-            if (it->intvalue == it2->intvalue) {
-                found = true;
-                break;
+    std::list<ValueFlow::Value> result;
+    for (std::list<ValueFlow::Value>::const_iterator it = values.begin(); it != values.end(); ++it) {
+        std::vector<bool> keep(rangeSize(*it), true);
+        for (std::size_t i = 0; i < keep.size(); ++i) {
+            const MathLib::bigint intvalue = it->intvalue + (MathLib::bigint)i * it->step;
+            for (std::list<ValueFlow::Value>::const_iterator it2 = valuesToRemove.begin(); it2 != valuesToRemove.end(); ++it2) {
+                if (containsValue(*it2, intvalue)) {
+                    keep[i] = false;
+                    break;
+                }
             }
         }
-        if (found)
-            values.erase(it++);
-        else
-            ++it;
+        appendSelected(*it, keep, &result);
     }
+    values.swap(result);
 }
 
 static void valueFlowAST(Token *tok, unsigned int varid, const ValueFlow::Value &value)
@@ -1074,7 +1323,9 @@ static bool valueFlowForward(Token * const               startToken,
     bool returnStatement = false;  // current statement is a return, stop analysis at the ";"
     bool read = false;  // is variable value read?
 
+    WorkCount steps(WORK_VALUEFLOW_FORWARD_STEPS);
     for (Token *tok2 = startToken; tok2 && tok2 != endToken; tok2 = tok2->next()) {
+        ++steps;
         if (indentlevel >= 0 && tok2->str() == "{")
             ++indentlevel;
         else if (indentlevel >= 0 && tok2->str() == "}") {
@@ -1095,14 +1346,17 @@ static bool valueFlowForward(Token * const               startToken,
                 }
 
                 bool bailoutflag = false;
-                for (std::list<ValueFlow::Value>::const_iterator it = values.begin(); it != values.end(); ++it) {
-                    if (!iselse && conditionIsTrue(condition, getProgramMemory(condition->astParent(), varid, *it))) {
-                        bailoutflag = true;
-                        break;
-                    }
-                    if (iselse && conditionIsFalse(condition, getProgramMemory(condition->astParent(), varid, *it))) {
-                        bailoutflag = true;
-                        break;
+                for (std::list<ValueFlow::Value>::const_iterator it = values.begin(); it != values.end() && !bailoutflag; ++it) {
+                    for (std::size_t i = 0; i < rangeSize(*it); ++i) {
+                        const ProgramMemory programMemory(getProgramMemory(condition->astParent(), varid, rangeValue(*it, i)));
+                        if (!iselse && conditionIsTrue(condition, programMemory)) {
+                            bailoutflag = true;
+                            break;
+                        }
+                        if (iselse && conditionIsFalse(condition, programMemory)) {
+                            bailoutflag = true;
+                            break;
+                        }
                     }
                 }
                 if (bailoutflag) {
@@ -1129,10 +1383,12 @@ static bool valueFlowForward(Token * const               startToken,
             const Token *condition = tok2->linkAt(-1);
             condition = condition ? condition->linkAt(-1) : nullptr;
             condition = condition ? condition->astOperand2() : nullptr;
-            for (std::list<ValueFlow::Value>::iterator it = values.begin(); it != values.end(); ++it) {
-                if (conditionIsTrue(condition, getProgramMemory(tok2, varid, *it))) {
-                    skipelse = true;
-                    break;
+            for (std::list<ValueFlow::Value>::iterator it = values.begin(); it != values.end() && !skipelse; ++it) {
+                for (std::size_t i = 0; i < rangeSize(*it); ++i) {
+                    if (conditionIsTrue(condition, getProgramMemory(tok2, varid, rangeValue(*it, i)))) {
+                        skipelse = true;
+                        break;
+                    }
                 }
             }
             if (skipelse) {
@@ -1192,10 +1448,12 @@ static bool valueFlowForward(Token * const               startToken,
             // Should scope be skipped because variable value is checked?
             std::list<ValueFlow::Value> truevalues;
             for (std::list<ValueFlow::Value>::const_iterator it = values.begin(); it != values.end(); ++it) {
-                if (condAlwaysTrue || !conditionIsFalse(condTok, getProgramMemory(tok2, varid, *it)))
-                    truevalues.push_back(*it);
+                std::vector<bool> istrue(rangeSize(*it));
+                for (std::size_t i = 0; i < istrue.size(); ++i)
+                    istrue[i] = condAlwaysTrue || !conditionIsFalse(condTok, getProgramMemory(tok2, varid, rangeValue(*it, i)));
+                appendSelected(*it, istrue, &truevalues);
             }
-            if (truevalues.size() != values.size() || condAlwaysTrue) {
+            if (valueCount(truevalues) != valueCount(values) || condAlwaysTrue) {
                 // '{'
                 Token * const startToken1 = tok2->linkAt(1)->next();
 
@@ -1273,13 +1531,15 @@ static bool valueFlowForward(Token * const               startToken,
 
             // stop after conditional noreturn scopes that are executed
             if (isReturn(end)) {
-                std::list<ValueFlow::Value>::iterator it;
-                for (it = values.begin(); it != values.end();) {
-                    if (conditionIsTrue(tok2->next()->astOperand2(), getProgramMemory(tok2, varid, *it)))
-                        values.erase(it++);
-                    else
-                        ++it;
+                std::list<ValueFlow::Value> remaining;
+                std::list<ValueFlow::Value>::const_iterator it;
+                for (it = values.begin(); it != values.end(); ++it) {
+                    std::vector<bool> keep(rangeSize(*it));
+                    for (std::size_t i = 0; i < keep.size(); ++i)
+                        keep[i] = !conditionIsTrue(tok2->next()->astOperand2(), getProgramMemory(tok2, varid, rangeValue(*it, i)));
+                    appendSelected(*it, keep, &remaining);
                 }
+                values.swap(remaining);
                 if (values.empty())
                     return false;
             }
@@ -1395,8 +1655,10 @@ static bool valueFlowForward(Token * const               startToken,
             const Token *op2 = tok2->astOperand2();
             if (!condition || !op2) // Ticket #6713
                 continue;
+            std::list<ValueFlow::Value> buffer;
+            const std::list<ValueFlow::Value> &values1 = expandRanges(values, buffer);
             std::list<ValueFlow::Value>::const_iterator it;
-            for (it = values.begin(); it != values.end(); ++it) {
+            for (it = values1.begin(); it != values1.end(); ++it) {
                 const ProgramMemory programMemory(getProgramMemory(tok2, varid, *it));
                 if (conditionIsTrue(condition, programMemory))
                     valueFlowAST(const_cast<Token*>(op2->astOperand1()), varid, *it);
@@ -1500,6 +1762,7 @@ static bool valueFlowForward(Token * const               startToken,
                     if (!pre)
                         setTokenValue(op, *it);
                     it->intvalue += (inc ? 1 : -1);
+                    it->intmax += (inc ? 1 : -1);
                     if (pre)
                         setTokenValue(op, *it);
                 }
@@ -2265,7 +2528,7 @@ static void valueFlowSwitchVariable(TokenList *tokenlist, SymbolDatabase* symbol
                 }
 				if (vartok->variable() && vartok->variable()->scope())
 				{
-					valueFlowForward(tok, vartok->variable()->scope()->classEnd, vartok->variable(), vartok->varId(), values, false, tokenlist, errorLogger, settings);
+					valueFlowForward(tok, vartok->variable()->scope()->classEnd, vartok->variable(), vartok->varId(), mergeRanges(values), false, tokenlist, errorLogger, settings);
 				}
                 
             }
@@ -2359,7 +2622,7 @@ static void valueFlowFunctionDefaultParameter(TokenList *tokenlist, SymbolDataba
 
 static bool constval(const Token * tok)
 {
-    return tok && tok->values.size() == 1U && tok->values.front().varId == 0U;
+    return tok && tok->values.size() == 1U && tok->values.front().varId == 0U && !tok->values.front().isRange();
 }
 
 static void valueFlowFunctionReturn(TokenList *tokenlist, ErrorLogger *errorLogger, const Settings *settings)
@@ -2439,6 +2702,13 @@ void ValueFlow::setValues(TokenList *tokenlist, SymbolDatabase* symboldatabase,
     valueFlowSwitchVariable(tokenlist, symboldatabase, errorLogger, settings);
     valueFlowSubFunction(tokenlist, errorLogger, settings);
     valueFlowFunctionDefaultParameter(tokenlist, symboldatabase, errorLogger, settings);
+
+    // Ranges are internal to ValueFlow, checks look at the values one by one
+    for (Token *tok = tokenlist->front(); tok; tok = tok->next()) {
+        std::list<ValueFlow::Value> buffer;
+        if (&expandRanges(tok->values, buffer) == &buffer)
+            tok->values.swap(buffer);
+    }
 }
 
 
@@ -33,8 +33,8 @@ class Settings;
 namespace ValueFlow {
     class TSCANCODELIB Value {
     public:
-        explicit Value(long long val = 0) : intvalue(val), tokvalue(nullptr), varvalue(val), condition(0), varId(0U), conditional(false), inconclusive(false), defaultArg(false), valueKind(ValueKind::Possible) {}
-        Value(const Token *c, long long val) : intvalue(val), tokvalue(nullptr), varvalue(val), condition(c), varId(0U), conditional(false), inconclusive(false), defaultArg(false), valueKind(ValueKind::Possible) {}
+        explicit Value(long long val = 0) : intvalue(val), tokvalue(nullptr), varvalue(val), intmax(val), step(0), varstep(0), condition(0), varId(0U), conditional(false), inconclusive(false), defaultArg(false), valueKind(ValueKind::Possible) {}
+        Value(const Token *c, long long val) : intvalue(val), tokvalue(nullptr), varvalue(val), intmax(val), step(0), varstep(0), condition(c), varId(0U), conditional(false), inconclusive(false), defaultArg(false), valueKind(ValueKind::Possible) {}
 
         /** int value */
         long long intvalue;
@@ -45,6 +45,15 @@ namespace ValueFlow {
         /** For calculated values - variable value that calculated value depends on */
         long long varvalue;
 
+        /** Range value - last value of the range, intvalue is the first value */
+        long long intmax;
+
+        /** Range value - distance between consecutive values. 0 => not a range */
+        long long step;
+
+        /** Range value - distance between consecutive varvalues */
+        long long varstep;
+
         /** Condition that this value depends on (TODO: replace with a 'callstack') */
         const Token *condition;
 
@@ -88,6 +97,17 @@ namespace ValueFlow {
             return valueKind == ValueKind::Possible;
         }
 
+        /**
+         * Does this value stand for the values intvalue, intvalue+step, .., intmax?
+         * Ranges only come from the case values of valueFlowSwitchVariable and the
+         * values calculated from them, and setValues() expands them
+         * before it returns. Token::values, Token::getValueLE/GE and the checks
+         * never see a range.
+         */
+        bool isRange() const {
+            return step != 0;
+        }
+
         void changeKnownToPossible() {
             if (isKnown())
                 valueKind = ValueKind::Possible;
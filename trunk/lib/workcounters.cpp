@@ -0,0 +1,229 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "workcounters.h"
+
+#include <list>
+#include <map>
+#ifdef TSC_THREADING_MODEL_WIN
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+TSC_THREAD_LOCAL unsigned long long *workCountersOfThread = nullptr;
+
+bool WorkCounters::_enabled = false;
+
+namespace {
+    struct Counts {
+        unsigned long long values[WORK_COUNTERS_SIZE];
+
+        Counts() {
+            for (int i = 0; i < WORK_COUNTERS_SIZE; ++i)
+                values[i] = 0;
+        }
+    };
+
+    typedef std::map<std::string, Counts> PhaseTable;
+
+    // names in the JSON file, sorted
+    struct CounterName {
+        const char *name;
+        WORK_COUNTERS counter;
+    };
+    const CounterName counterNames[] = {
+        { "findFunctionCacheHits", WORK_FINDFUNCTION_CACHE_HITS },
+        { "findFunctionLookups", WORK_FINDFUNCTION_LOOKUPS },
+        { "matchCalls", WORK_MATCH_CALLS },
+        { "matchSteps", WORK_MATCH_STEPS },
+        { "preprocessorConditions", WORK_PREPROCESSOR_CONDITIONS },
+        { "preprocessorLines", WORK_PREPROCESSOR_LINES },
+        { "tokensCreated", WORK_TOKENS_CREATED },
+        { "valueFlowForwardSteps", WORK_VALUEFLOW_FORWARD_STEPS },
+        { "valueFlowReverseSteps", WORK_VALUEFLOW_REVERSE_STEPS },
+        { "valuesCreated", WORK_VALUES_CREATED }
+    };
+    const std::size_t counterNamesSize = sizeof(counterNames) / sizeof(counterNames[0]);
+}
+
+// the phase table of this thread, registered in threadTables on first use
+static TSC_THREAD_LOCAL PhaseTable *tableOfThread = nullptr;
+static TSC_THREAD_LOCAL const std::string *phaseNameOfThread = nullptr;
+static std::list<PhaseTable *> threadTables;
+static TSC_LOCK threadTablesLock;
+
+void WorkCounters::enable()
+{
+    if (_enabled)
+        return;
+    TSC_LOCK_INIT(&threadTablesLock);
+    _enabled = true;
+}
+
+void WorkCounters::shutdown()
+{
+    if (!_enabled)
+        return;
+    _enabled = false;
+    TSC_LOCK_ENTER(&threadTablesLock);
+    for (std::list<PhaseTable *>::const_iterator table = threadTables.begin(); table != threadTables.end(); ++table)
+        delete *table;
+    threadTables.clear();
+    TSC_LOCK_LEAVE(&threadTablesLock);
+    TSC_LOCK_DELETE(&threadTablesLock);
+
+    // the tables of the other threads are gone with their threads
+    tableOfThread = nullptr;
+    workCountersOfThread = nullptr;
+    phaseNameOfThread = nullptr;
+}
+
+static PhaseTable merge()
+{
+    PhaseTable merged;
+    TSC_LOCK_ENTER(&threadTablesLock);
+    for (std::list<PhaseTable *>::const_iterator table = threadTables.begin(); table != threadTables.end(); ++table) {
+        for (PhaseTable::const_iterator phase = (*table)->begin(); phase != (*table)->end(); ++phase) {
+            Counts &counts = merged[phase->first];
+            Counts &total = merged["total"];
+            for (int i = 0; i < WORK_COUNTERS_SIZE; ++i) {
+                counts.values[i] += phase->second.values[i];
+                total.values[i] += phase->second.values[i];
+            }
+        }
+    }
+    TSC_LOCK_LEAVE(&threadTablesLock);
+    return merged;
+}
+
+void WorkCounters::write(std::ostream &out)
+{
+    if (!_enabled)
+        return;
+    const PhaseTable merged = merge();
+    out << "{\n";
+    for (PhaseTable::const_iterator phase = merged.begin(); phase != merged.end(); ++phase) {
+        if (phase != merged.begin())
+            out << ",\n";
+        out << "\"" << phase->first << "\": {";
+        for (std::size_t i = 0; i < counterNamesSize; ++i)
+            out << (i ? ", \"" : "\"") << counterNames[i].name << "\": " << phase->second.values[counterNames[i].counter];
+        out << "}";
+    }
+    out << "\n}\n";
+}
+
+// read the next "string" of line, starting at pos
+static bool readString(const std::string &line, std::string::size_type &pos, std::string &str)
+{
+    const std::string::size_type start = line.find('"', pos);
+    const std::string::size_type end = start == std::string::npos ? start : line.find('"', start + 1);
+    if (end == std::string::npos)
+        return false;
+    str = line.substr(start + 1, end - start - 1);
+    pos = end + 1;
+    return true;
+}
+
+void WorkCounters::read(std::istream &in, std::map<std::string, std::map<std::string, unsigned long long> > &counts)
+{
+    std::string line;
+    while (std::getline(in, line)) {
+        // "phase": {"counter": value, ...}
+        std::string::size_type pos = 0;
+        std::string phase;
+        if (!readString(line, pos, phase))
+            continue;
+        std::map<std::string, unsigned long long> &phaseCounts = counts[phase];
+        std::string name;
+        while (readString(line, pos, name)) {
+            pos = line.find_first_of("0123456789", pos);
+            if (pos == std::string::npos)
+                break;
+            unsigned long long value = 0;
+            while (pos < line.size() && line[pos] >= '0' && line[pos] <= '9')
+                value = value * 10 + (unsigned long long)(line[pos++] - '0');
+            phaseCounts[name] = value;
+        }
+    }
+}
+
+unsigned int WorkCounters::compare(std::istream &baseline, unsigned int tolerance, std::ostream &report)
+{
+    if (!_enabled)
+        return 0;
+    const PhaseTable merged = merge();
+    std::map<std::string, std::map<std::string, unsigned long long> > baseCounts;
+    read(baseline, baseCounts);
+
+    unsigned int regressions = 0;
+    for (std::map<std::string, std::map<std::string, unsigned long long> >::const_iterator phase = baseCounts.begin(); phase != baseCounts.end(); ++phase) {
+        const PhaseTable::const_iterator counts = merged.find(phase->first);
+        for (std::map<std::string, unsigned long long>::const_iterator it = phase->second.begin(); it != phase->second.end(); ++it) {
+            const unsigned long long base = it->second;
+            unsigned long long current = 0;
+            for (std::size_t i = 0; i < counterNamesSize && counts != merged.end(); ++i) {
+                if (it->first == counterNames[i].name)
+                    current = counts->second.values[counterNames[i].counter];
+            }
+            if (current > base + base * tolerance / 100) {
+                report << phase->first << " " << it->first << ": " << base << " -> " << current << "\n";
+                ++regressions;
+            }
+        }
+    }
+    return regressions;
+}
+
+WorkPhase::WorkPhase(const std::string &name)
+    : _previous(workCountersOfThread)
+    , _previousName(phaseNameOfThread)
+    , _stopped(false)
+{
+    if (!WorkCounters::enabled() || name.empty())
+        return;
+    if (!tableOfThread) {
+        tableOfThread = new PhaseTable;
+        TSC_LOCK_ENTER(&threadTablesLock);
+        threadTables.push_back(tableOfThread);
+        TSC_LOCK_LEAVE(&threadTablesLock);
+    }
+    workCountersOfThread = (*tableOfThread)[name].values;
+    _name = name;
+    phaseNameOfThread = &_name;
+}
+
+WorkPhase::~WorkPhase()
+{
+    Stop();
+}
+
+void WorkPhase::Stop()
+{
+    if (!_stopped) {
+        workCountersOfThread = _previous;
+        phaseNameOfThread = _previousName;
+    }
+    _stopped = true;
+}
+
+std::string WorkPhase::currentName()
+{
+    return phaseNameOfThread ? *phaseNameOfThread : std::string();
+}
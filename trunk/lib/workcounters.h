@@ -0,0 +1,146 @@
+/*
+ * TscanCode - A tool for static C/C++ code analysis
+ * Copyright (C) 2017 TscanCode team.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+//---------------------------------------------------------------------------
+#ifndef workcountersH
+#define workcountersH
+//---------------------------------------------------------------------------
+
+#include <string>
+#include <istream>
+#include <ostream>
+#include <map>
+#include "config.h"
+
+enum WORK_COUNTERS {
+    WORK_TOKENS_CREATED = 0,
+    WORK_MATCH_CALLS,
+    WORK_MATCH_STEPS,
+    WORK_VALUES_CREATED,
+    WORK_VALUEFLOW_FORWARD_STEPS,
+    WORK_VALUEFLOW_REVERSE_STEPS,
+    WORK_PREPROCESSOR_LINES,
+    WORK_PREPROCESSOR_CONDITIONS,
+    WORK_FINDFUNCTION_LOOKUPS,
+    WORK_FINDFUNCTION_CACHE_HITS,
+    WORK_COUNTERS_SIZE
+};
+
+/** counts of the current WorkPhase of this thread, nullptr outside of a phase */
+extern TSC_THREAD_LOCAL unsigned long long *workCountersOfThread;
+
+/**
+ * @brief Deterministic counts of units of work (--work-counters=).
+ *
+ * Unlike the --showtime clocks the counts do not depend on the machine, so
+ * runs can be compared to find algorithmic regressions. Each thread counts
+ * into the table of its current WorkPhase without locking, the tables of
+ * all threads are only merged when the counts are written.
+ */
+class TSCANCODELIB WorkCounters {
+public:
+    /** @brief start counting, phases entered before are not counted */
+    static void enable();
+
+    /** @brief stop counting and free the counts of all threads, once no phase is active and the other threads have ended */
+    static void shutdown();
+
+    static bool enabled() {
+        return _enabled;
+    }
+
+    static void add(WORK_COUNTERS counter, unsigned long long n = 1) {
+        if (workCountersOfThread)
+            workCountersOfThread[counter] += n;
+    }
+
+    /** @brief write the counts of all threads as JSON, one phase per line and sorted keys */
+    static void write(std::ostream &out);
+
+    /** @brief read a file written by write(), phase -> counter name -> count */
+    static void read(std::istream &in, std::map<std::string, std::map<std::string, unsigned long long> > &counts);
+
+    /**
+     * @brief compare the counts with a baseline written by write()
+     * @param baseline the baseline
+     * @param tolerance allowed growth of a count in percent
+     * @param report one line per count that grew by more than tolerance
+     * @return number of counts that grew by more than tolerance
+     */
+    static unsigned int compare(std::istream &baseline, unsigned int tolerance, std::ostream &report);
+
+private:
+    static bool _enabled;
+};
+
+/**
+ * @brief Counts the work done during its lifetime under a phase name.
+ *
+ * Phases nest, the work of an inner phase is not counted in the outer one.
+ * A phase with an empty name leaves the counting to the enclosing phase.
+ */
+class TSCANCODELIB WorkPhase {
+public:
+    explicit WorkPhase(const std::string &name);
+    ~WorkPhase();
+    void Stop();
+
+    /** @brief name of the current phase of this thread, empty outside of a phase */
+    static std::string currentName();
+
+private:
+    /** no copying */
+    WorkPhase(const WorkPhase &);
+    WorkPhase& operator=(const WorkPhase &);
+
+    unsigned long long *_previous;
+    const std::string *_previousName;
+    std::string _name;
+    bool _stopped;
+};
+
+/** @brief Sums a counter of a hot loop locally, it is added once when leaving the scope. */
+class WorkCount {
+public:
+    explicit WorkCount(WORK_COUNTERS counter)
+        : _counter(counter), _n(0) {
+    }
+
+    ~WorkCount() {
+        if (_n)
+            WorkCounters::add(_counter, _n);
+    }
+
+    void operator++() {
+        ++_n;
+    }
+
+    void operator+=(unsigned long long n) {
+        _n += n;
+    }
+
+private:
+    /** no copying */
+    WorkCount(const WorkCount &);
+    WorkCount& operator=(const WorkCount &);
+
+    const WORK_COUNTERS _counter;
+    unsigned long long _n;
+};
+
+//---------------------------------------------------------------------------
+#endif // workcountersH